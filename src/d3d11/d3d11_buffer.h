@@ -68,6 +68,17 @@ namespace dxvk {
       return m_buffer->info().size;
     }
     
+    /**
+     * \brief Checks whether the buffer is dynamic
+     * 
+     * Dynamic buffers get renamed when they are
+     * mapped with \c D3D11_MAP_WRITE_DISCARD.
+     * \returns \c true for dynamic buffers
+     */
+    bool IsDynamic() const {
+      return m_desc.Usage == D3D11_USAGE_DYNAMIC;
+    }
+    
     D3D11BufferInfo* GetBufferInfo() {
       return &m_bufferInfo;
     }
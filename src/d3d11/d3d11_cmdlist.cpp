@@ -2,7 +2,28 @@
 #include "d3d11_device.h"
 
 namespace dxvk {
+  
+  void D3D11CommandListRecording::SetCommandList(
+    const Rc<DxvkCommandList>& CommandList) {
+    { std::lock_guard<std::mutex> lock(m_mutex);
+      m_cmdList = CommandList;
+    }
+    
+    m_cond.notify_all();
+  }
+  
+  
+  Rc<DxvkCommandList> D3D11CommandListRecording::GetCommandList() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    
+    m_cond.wait(lock, [this] {
+      return m_cmdList != nullptr;
+    });
     
+    return m_cmdList;
+  }
+  
+  
   D3D11CommandList::D3D11CommandList(
           D3D11Device*  pDevice,
           UINT          ContextFlags)
@@ -42,13 +63,18 @@ namespace dxvk {
   
   
   void D3D11CommandList::AddChunk(
-            Rc<DxvkCsChunk>&&   Chunk,
+            DxvkCsChunkRef&&    Chunk,
             UINT                DrawCount) {
     m_chunks.push_back(std::move(Chunk));
     m_drawCount += DrawCount;
   }
   
   
+  void D3D11CommandList::ClearChunks() {
+    m_chunks.clear();
+  }
+  
+  
   void D3D11CommandList::EmitToCommandList(ID3D11CommandList* pCommandList) {
     auto cmdList = static_cast<D3D11CommandList*>(pCommandList);
     
@@ -60,8 +86,10 @@ namespace dxvk {
   
   
   void D3D11CommandList::EmitToCsThread(DxvkCsThread* CsThread) {
+    // Chunks recorded on deferred contexts are not single-use,
+    // so their commands remain valid for subsequent executions
     for (auto chunk : m_chunks)
-      CsThread->dispatchChunk(Rc<DxvkCsChunk>(chunk));
+      CsThread->dispatchChunk(DxvkCsChunkRef(chunk));
   }
   
 }
\ No newline at end of file
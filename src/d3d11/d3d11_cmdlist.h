@@ -1,9 +1,37 @@
 #pragma once
 
+#include <condition_variable>
+#include <mutex>
+
 #include "d3d11_context.h"
 
 namespace dxvk {
   
+  /**
+   * \brief Secondary command list recording
+   * 
+   * Receives the secondary command list that a deferred
+   * context records on its worker thread. Executing the
+   * D3D11 command list waits for the recording to finish.
+   */
+  class D3D11CommandListRecording : public RcObject {
+    
+  public:
+    
+    void SetCommandList(
+      const Rc<DxvkCommandList>& CommandList);
+    
+    Rc<DxvkCommandList> GetCommandList();
+    
+  private:
+    
+    std::mutex              m_mutex;
+    std::condition_variable m_cond;
+    Rc<DxvkCommandList>     m_cmdList;
+    
+  };
+  
+  
   class D3D11CommandList : public D3D11DeviceChild<ID3D11CommandList> {
     
   public:
@@ -24,9 +52,11 @@ namespace dxvk {
     UINT STDMETHODCALLTYPE GetContextFlags() final;
     
     void AddChunk(
-            Rc<DxvkCsChunk>&&   Chunk,
+            DxvkCsChunkRef&&    Chunk,
             UINT                DrawCount);
     
+    void ClearChunks();
+    
     void EmitToCommandList(
             ID3D11CommandList*  pCommandList);
     
@@ -43,7 +73,7 @@ namespace dxvk {
     UINT         const m_contextFlags;
     UINT               m_drawCount = 0;
     
-    std::vector<Rc<DxvkCsChunk>> m_chunks;
+    std::vector<DxvkCsChunkRef> m_chunks;
     
   };
   
@@ -10,11 +10,15 @@
 namespace dxvk {
   
   D3D11DeviceContext::D3D11DeviceContext(
-      D3D11Device*    pParent,
-      Rc<DxvkDevice>  Device)
-  : m_parent  (pParent),
-    m_device  (Device),
-    m_csChunk (new DxvkCsChunk()) {
+      D3D11Device*      pParent,
+      Rc<DxvkDevice>    Device,
+      DxvkCsChunkFlags  CsFlags,
+      size_t            CsChunkSize)
+  : m_parent      (pParent),
+    m_device      (Device),
+    m_csFlags     (CsFlags),
+    m_csChunkPool (new DxvkCsChunkPool(CsChunkSize)),
+    m_csChunk     (m_csChunkPool->allocChunk(m_csFlags)) {
     // Create default state objects. We won't ever return them
     // to the application, but we'll use them to apply state.
     Com<ID3D11BlendState>         defaultBlendState;
@@ -63,14 +67,40 @@ namespace dxvk {
   }
 
   void STDMETHODCALLTYPE D3D11DeviceContext::DiscardView(ID3D11View * pResourceView) {
-    Logger::err("D3D11DeviceContext::DiscardView: Not implemented");
+    if (pResourceView == nullptr)
+      return;
+    
+    // Discarding is only a hint, so we only make use of it for
+    // render targets, where it allows the next render pass to
+    // skip loading the previous contents of the image.
+    Rc<DxvkImageView> view;
+    
+    Com<ID3D11RenderTargetView> rtv;
+    Com<ID3D11DepthStencilView> dsv;
+    
+    if (SUCCEEDED(pResourceView->QueryInterface(__uuidof(ID3D11RenderTargetView), reinterpret_cast<void**>(&rtv))))
+      view = static_cast<D3D11RenderTargetView*>(rtv.ptr())->GetImageView();
+    else if (SUCCEEDED(pResourceView->QueryInterface(__uuidof(ID3D11DepthStencilView), reinterpret_cast<void**>(&dsv))))
+      view = static_cast<D3D11DepthStencilView*>(dsv.ptr())->GetImageView();
+    
+    if (view == nullptr)
+      return;
+    
+    EmitCs([
+      cImageView  = view,
+      cAspectMask = imageFormatInfo(view->info().format)->aspectMask
+    ] (DxvkContext* ctx) {
+      ctx->discardRenderTarget(cImageView, cAspectMask);
+    });
   }
 
   void STDMETHODCALLTYPE D3D11DeviceContext::DiscardView1(
           ID3D11View*              pResourceView, 
     const D3D11_RECT*              pRects, 
           UINT                     NumRects) {
-    Logger::err("D3D11DeviceContext::DiscardView1: Not implemented");
+    // Partial discards cannot be expressed as a load op
+    if (NumRects == 0)
+      this->DiscardView(pResourceView);
   }
 
   void STDMETHODCALLTYPE D3D11DeviceContext::SwapDeviceContextState(
@@ -191,6 +221,7 @@ namespace dxvk {
       
       if (queryPtr->HasBeginEnabled()) {
         const uint32_t revision = queryPtr->Reset();
+        m_csUsesDynamicResources = true;
         
         EmitCs([revision, queryPtr] (DxvkContext* ctx) {
           queryPtr->Begin(ctx, revision);
@@ -208,6 +239,7 @@ namespace dxvk {
    
     if (SUCCEEDED(pAsync->QueryInterface(__uuidof(ID3D11Query), reinterpret_cast<void**>(&query)))) {
       Com<D3D11Query> queryPtr = static_cast<D3D11Query*>(query.ptr());
+      m_csUsesDynamicResources = true;
       
       if (queryPtr->HasBeginEnabled()) {
         EmitCs([queryPtr] (DxvkContext* ctx) {
@@ -316,6 +348,9 @@ namespace dxvk {
       auto dstBuffer = static_cast<D3D11Buffer*>(pDstResource)->GetBufferSlice();
       auto srcBuffer = static_cast<D3D11Buffer*>(pSrcResource)->GetBufferSlice();
       
+      m_csUsesDynamicResources |= static_cast<D3D11Buffer*>(pDstResource)->IsDynamic()
+                               || static_cast<D3D11Buffer*>(pSrcResource)->IsDynamic();
+      
       VkDeviceSize srcOffset = 0;
       VkDeviceSize srcLength = srcBuffer.length();
       
@@ -445,6 +480,9 @@ namespace dxvk {
       auto dstBuffer = static_cast<D3D11Buffer*>(pDstResource)->GetBufferSlice();
       auto srcBuffer = static_cast<D3D11Buffer*>(pSrcResource)->GetBufferSlice();
       
+      m_csUsesDynamicResources |= static_cast<D3D11Buffer*>(pDstResource)->IsDynamic()
+                               || static_cast<D3D11Buffer*>(pSrcResource)->IsDynamic();
+      
       if (dstBuffer.length() != srcBuffer.length()) {
         Logger::err(str::format(
           "D3D11: CopyResource: Mismatched buffer size",
@@ -501,6 +539,8 @@ namespace dxvk {
     auto buf = static_cast<D3D11Buffer*>(pDstBuffer);
     auto uav = static_cast<D3D11UnorderedAccessView*>(pSrcView);
 
+    m_csUsesDynamicResources |= buf->IsDynamic();
+
     EmitCs([
       cDstSlice = buf->GetBufferSlice(DstAlignedByteOffset),
       cSrcSlice = uav->GetCounterSlice()
@@ -863,7 +903,8 @@ namespace dxvk {
         reinterpret_cast<char*>(imageDataBuffer.ptr()),
         reinterpret_cast<const char*>(pSrcData),
         regionExtent, formatInfo->elementSize,
-        SrcRowPitch, SrcDepthPitch);
+        SrcRowPitch, SrcDepthPitch,
+        util::CopyTarget::Cached);
       
       EmitCs([
         cDstImage         = textureInfo->GetImage(),
@@ -2320,7 +2361,7 @@ namespace dxvk {
             return { VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP_WITH_ADJACENCY, VK_TRUE, 0 };
           
           default:
-            Logger::err(str::format("D3D11: Invalid primitive topology: ", Topology));
+            Logger::errf("D3D11: Invalid primitive topology: ", Topology);
             return { };
         }
       }
@@ -2489,6 +2530,8 @@ namespace dxvk {
           D3D11Buffer*                      pBuffer,
           UINT                              Offset,
           UINT                              Stride) {
+    m_csUsesDynamicResources |= pBuffer != nullptr && pBuffer->IsDynamic();
+    
     EmitCs([
       cSlotId       = Slot,
       cBufferSlice  = pBuffer != nullptr ? pBuffer->GetBufferSlice(Offset) : DxvkBufferSlice(),
@@ -2508,10 +2551,12 @@ namespace dxvk {
     VkIndexType indexType = VK_INDEX_TYPE_UINT32;
     
     if (pBuffer != nullptr) {
+      m_csUsesDynamicResources |= pBuffer->IsDynamic();
+      
       switch (Format) {
         case DXGI_FORMAT_R16_UINT: indexType = VK_INDEX_TYPE_UINT16; break;
         case DXGI_FORMAT_R32_UINT: indexType = VK_INDEX_TYPE_UINT32; break;
-        default: Logger::err(str::format("D3D11: Invalid index format: ", Format));
+        default: Logger::errf("D3D11: Invalid index format: ", Format);
       }
     }
     
@@ -2524,60 +2569,132 @@ namespace dxvk {
   }
   
   
-  void D3D11DeviceContext::BindConstantBuffer(
+  void D3D11DeviceContext::BindConstantBuffers(
           UINT                              Slot,
-    const D3D11ConstantBufferBinding*       pBufferBinding) {
-    EmitCs([
-      cSlotId      = Slot,
-      cBufferSlice = pBufferBinding->buffer != nullptr
-        ? pBufferBinding->buffer->GetBufferSlice(
-            pBufferBinding->constantOffset * 16,
-            pBufferBinding->constantCount  * 16)
-        : DxvkBufferSlice()
-    ] (DxvkContext* ctx) {
-      ctx->bindResourceBuffer(cSlotId, cBufferSlice);
+          UINT                              Count,
+    const D3D11ConstantBufferBinding*       pBufferBindings) {
+    for (uint32_t i = 0; i < Count; i++) {
+      m_csUsesDynamicResources |= pBufferBindings[i].buffer != nullptr
+                               && pBufferBindings[i].buffer->IsDynamic();
+    }
+    
+    ForEachBindBatch(Count, [&] (auto batch, UINT First, UINT BatchCount) {
+      std::array<DxvkBufferSlice, decltype(batch)::value> bufferSlices;
+      
+      for (uint32_t i = 0; i < BatchCount; i++) {
+        const D3D11ConstantBufferBinding& binding = pBufferBindings[First + i];
+        
+        if (binding.buffer != nullptr) {
+          bufferSlices[i] = binding.buffer->GetBufferSlice(
+            binding.constantOffset * 16,
+            binding.constantCount  * 16);
+        }
+      }
+      
+      EmitCs([
+        cSlotId       = Slot + First,
+        cCount        = BatchCount,
+        cConsume      = m_csFlags.test(DxvkCsChunkFlag::SingleUse),
+        cBufferSlices = std::move(bufferSlices)
+      ] (DxvkContext* ctx) mutable {
+        ctx->bindResourceBuffers(cSlotId, cCount,
+          cBufferSlices.data(), cConsume);
+      });
     });
   }
   
   
-  void D3D11DeviceContext::BindSampler(
+  void D3D11DeviceContext::BindSamplers(
           UINT                              Slot,
-          D3D11SamplerState*                pSampler) {
-    EmitCs([
-      cSlotId   = Slot,
-      cSampler  = pSampler != nullptr ? pSampler->GetDXVKSampler() : nullptr
-    ] (DxvkContext* ctx) {
-      ctx->bindResourceSampler(cSlotId, cSampler);
+          UINT                              Count,
+    const Com<D3D11SamplerState>*           ppSamplers) {
+    ForEachBindBatch(Count, [&] (auto batch, UINT First, UINT BatchCount) {
+      std::array<Rc<DxvkSampler>, decltype(batch)::value> samplers;
+      
+      for (uint32_t i = 0; i < BatchCount; i++) {
+        if (ppSamplers[First + i] != nullptr)
+          samplers[i] = ppSamplers[First + i]->GetDXVKSampler();
+      }
+      
+      EmitCs([
+        cSlotId   = Slot + First,
+        cCount    = BatchCount,
+        cConsume  = m_csFlags.test(DxvkCsChunkFlag::SingleUse),
+        cSamplers = std::move(samplers)
+      ] (DxvkContext* ctx) mutable {
+        ctx->bindResourceSamplers(cSlotId, cCount,
+          cSamplers.data(), cConsume);
+      });
     });
   }
   
   
-  void D3D11DeviceContext::BindShaderResource(
+  void D3D11DeviceContext::BindShaderResources(
           UINT                              Slot,
-          D3D11ShaderResourceView*          pResource) {
-    EmitCs([
-      cSlotId     = Slot,
-      cImageView  = pResource != nullptr ? pResource->GetImageView()  : nullptr,
-      cBufferView = pResource != nullptr ? pResource->GetBufferView() : nullptr
-    ] (DxvkContext* ctx) {
-      ctx->bindResourceView(cSlotId, cImageView, cBufferView);
+          UINT                              Count,
+    const Com<D3D11ShaderResourceView>*     ppResources) {
+    for (uint32_t i = 0; i < Count; i++) {
+      m_csUsesDynamicResources |= ppResources[i] != nullptr
+                               && ppResources[i]->IsDynamicBuffer();
+    }
+    
+    ForEachBindBatch(Count, [&] (auto batch, UINT First, UINT BatchCount) {
+      std::array<Rc<DxvkImageView>,  decltype(batch)::value> imageViews;
+      std::array<Rc<DxvkBufferView>, decltype(batch)::value> bufferViews;
+      
+      for (uint32_t i = 0; i < BatchCount; i++) {
+        if (ppResources[First + i] != nullptr) {
+          imageViews [i] = ppResources[First + i]->GetImageView();
+          bufferViews[i] = ppResources[First + i]->GetBufferView();
+        }
+      }
+      
+      EmitCs([
+        cSlotId      = Slot + First,
+        cCount       = BatchCount,
+        cConsume     = m_csFlags.test(DxvkCsChunkFlag::SingleUse),
+        cImageViews  = std::move(imageViews),
+        cBufferViews = std::move(bufferViews)
+      ] (DxvkContext* ctx) mutable {
+        ctx->bindResourceViews(cSlotId, cCount,
+          cImageViews.data(), cBufferViews.data(), cConsume);
+      });
     });
   }
   
   
-  void D3D11DeviceContext::BindUnorderedAccessView(
+  void D3D11DeviceContext::BindUnorderedAccessViews(
           UINT                              UavSlot,
           UINT                              CtrSlot,
-          D3D11UnorderedAccessView*         pUav) {
-    EmitCs([
-      cUavSlotId    = UavSlot,
-      cCtrSlotId    = CtrSlot,
-      cImageView    = pUav != nullptr ? pUav->GetImageView()    : nullptr,
-      cBufferView   = pUav != nullptr ? pUav->GetBufferView()   : nullptr,
-      cCounterSlice = pUav != nullptr ? pUav->GetCounterSlice() : DxvkBufferSlice()
-    ] (DxvkContext* ctx) {
-      ctx->bindResourceView   (cUavSlotId, cImageView, cBufferView);
-      ctx->bindResourceBuffer (cCtrSlotId, cCounterSlice);
+          UINT                              Count,
+    const Com<D3D11UnorderedAccessView>*    ppUavs) {
+    ForEachBindBatch(Count, [&] (auto batch, UINT First, UINT BatchCount) {
+      std::array<Rc<DxvkImageView>,  decltype(batch)::value> imageViews;
+      std::array<Rc<DxvkBufferView>, decltype(batch)::value> bufferViews;
+      std::array<DxvkBufferSlice,    decltype(batch)::value> counterSlices;
+      
+      for (uint32_t i = 0; i < BatchCount; i++) {
+        if (ppUavs[First + i] != nullptr) {
+          imageViews   [i] = ppUavs[First + i]->GetImageView();
+          bufferViews  [i] = ppUavs[First + i]->GetBufferView();
+          counterSlices[i] = ppUavs[First + i]->GetCounterSlice();
+        }
+      }
+      
+      EmitCs([
+        cUavSlotId     = UavSlot + First,
+        cCtrSlotId     = CtrSlot + First,
+        cCount         = BatchCount,
+        cConsume       = m_csFlags.test(DxvkCsChunkFlag::SingleUse),
+        cImageViews    = std::move(imageViews),
+        cBufferViews   = std::move(bufferViews),
+        cCounterSlices = std::move(counterSlices)
+      ] (DxvkContext* ctx) mutable {
+        ctx->bindResourceViews(cUavSlotId, cCount,
+          cImageViews.data(), cBufferViews.data(), cConsume);
+        ctx->bindResourceBuffers(cCtrSlotId, cCount,
+          cCounterSlices.data(), cConsume);
+      });
     });
   }
   
@@ -2594,6 +2711,10 @@ namespace dxvk {
       ShaderStage, DxbcBindingType::ConstantBuffer,
       StartSlot);
     
+    // Consecutive changed slots are bound with one command
+    uint32_t rangeStart = 0;
+    uint32_t rangeCount = 0;
+    
     for (uint32_t i = 0; i < NumBuffers; i++) {
       auto newBuffer = static_cast<D3D11Buffer*>(ppConstantBuffers[i]);
       
@@ -2614,9 +2735,16 @@ namespace dxvk {
         Bindings[StartSlot + i].constantOffset = constantOffset;
         Bindings[StartSlot + i].constantCount  = constantCount;
         
-        BindConstantBuffer(slotId + i, &Bindings[StartSlot + i]);
+        if (rangeCount++ == 0)
+          rangeStart = i;
+      } else if (rangeCount != 0) {
+        BindConstantBuffers(slotId + rangeStart, rangeCount, &Bindings[StartSlot + rangeStart]);
+        rangeCount = 0;
       }
     }
+    
+    if (rangeCount != 0)
+      BindConstantBuffers(slotId + rangeStart, rangeCount, &Bindings[StartSlot + rangeStart]);
   }
   
   
@@ -2630,14 +2758,25 @@ namespace dxvk {
       ShaderStage, DxbcBindingType::ImageSampler,
       StartSlot);
     
+    uint32_t rangeStart = 0;
+    uint32_t rangeCount = 0;
+    
     for (uint32_t i = 0; i < NumSamplers; i++) {
       auto sampler = static_cast<D3D11SamplerState*>(ppSamplers[i]);
       
       if (Bindings[StartSlot + i] != sampler) {
         Bindings[StartSlot + i] = sampler;
-        BindSampler(slotId + i, sampler);
+        
+        if (rangeCount++ == 0)
+          rangeStart = i;
+      } else if (rangeCount != 0) {
+        BindSamplers(slotId + rangeStart, rangeCount, &Bindings[StartSlot + rangeStart]);
+        rangeCount = 0;
       }
     }
+    
+    if (rangeCount != 0)
+      BindSamplers(slotId + rangeStart, rangeCount, &Bindings[StartSlot + rangeStart]);
   }
   
   
@@ -2651,14 +2790,25 @@ namespace dxvk {
       ShaderStage, DxbcBindingType::ShaderResource,
       StartSlot);
     
+    uint32_t rangeStart = 0;
+    uint32_t rangeCount = 0;
+    
     for (uint32_t i = 0; i < NumResources; i++) {
       auto resView = static_cast<D3D11ShaderResourceView*>(ppResources[i]);
       
       if (Bindings[StartSlot + i] != resView) {
         Bindings[StartSlot + i] = resView;
-        BindShaderResource(slotId + i, resView);
+        
+        if (rangeCount++ == 0)
+          rangeStart = i;
+      } else if (rangeCount != 0) {
+        BindShaderResources(slotId + rangeStart, rangeCount, &Bindings[StartSlot + rangeStart]);
+        rangeCount = 0;
       }
     }
+    
+    if (rangeCount != 0)
+      BindShaderResources(slotId + rangeStart, rangeCount, &Bindings[StartSlot + rangeStart]);
   }
   
   
@@ -2676,14 +2826,28 @@ namespace dxvk {
       ShaderStage, DxbcBindingType::UavCounter,
       StartSlot);
     
+    uint32_t rangeStart = 0;
+    uint32_t rangeCount = 0;
+    
     for (uint32_t i = 0; i < NumUAVs; i++) {
       auto uav = static_cast<D3D11UnorderedAccessView*>(ppUnorderedAccessViews[i]);
       
       if (Bindings[StartSlot + i] != uav) {
         Bindings[StartSlot + i] = uav;
-        BindUnorderedAccessView(uavSlotId + i, ctrSlotId + i, uav);
+        
+        if (rangeCount++ == 0)
+          rangeStart = i;
+      } else if (rangeCount != 0) {
+        BindUnorderedAccessViews(uavSlotId + rangeStart, ctrSlotId + rangeStart,
+          rangeCount, &Bindings[StartSlot + rangeStart]);
+        rangeCount = 0;
       }
     }
+    
+    if (rangeCount != 0) {
+      BindUnorderedAccessViews(uavSlotId + rangeStart, ctrSlotId + rangeStart,
+        rangeCount, &Bindings[StartSlot + rangeStart]);
+    }
   }
   
   
@@ -2796,8 +2960,7 @@ namespace dxvk {
     const uint32_t slotId = computeResourceSlotId(
       Stage, DxbcBindingType::ConstantBuffer, 0);
     
-    for (uint32_t i = 0; i < Bindings.size(); i++)
-      BindConstantBuffer(slotId + i, &Bindings[i]);
+    BindConstantBuffers(slotId, Bindings.size(), Bindings.data());
   }
   
   
@@ -2807,8 +2970,7 @@ namespace dxvk {
     const uint32_t slotId = computeResourceSlotId(
       Stage, DxbcBindingType::ImageSampler, 0);
     
-    for (uint32_t i = 0; i < Bindings.size(); i++)
-      BindSampler(slotId + i, Bindings[i].ptr());
+    BindSamplers(slotId, Bindings.size(), Bindings.data());
   }
   
   
@@ -2818,8 +2980,7 @@ namespace dxvk {
     const uint32_t slotId = computeResourceSlotId(
       Stage, DxbcBindingType::ShaderResource, 0);
     
-    for (uint32_t i = 0; i < Bindings.size(); i++)
-      BindShaderResource(slotId + i, Bindings[i].ptr());
+    BindShaderResources(slotId, Bindings.size(), Bindings.data());
   }
   
   
@@ -2832,11 +2993,8 @@ namespace dxvk {
     const uint32_t ctrSlotId = computeResourceSlotId(
       Stage, DxbcBindingType::UavCounter, 0);
     
-    for (uint32_t i = 0; i < Bindings.size(); i++) {
-      BindUnorderedAccessView(
-        uavSlotId + i, ctrSlotId + i,
-        Bindings[i].ptr());
-    }
+    BindUnorderedAccessViews(uavSlotId, ctrSlotId,
+      Bindings.size(), Bindings.data());
   }
   
   
@@ -16,8 +16,10 @@ namespace dxvk {
   public:
     
     D3D11DeviceContext(
-      D3D11Device*    pParent,
-      Rc<DxvkDevice>  Device);
+      D3D11Device*      pParent,
+      Rc<DxvkDevice>    Device,
+      DxvkCsChunkFlags  CsFlags,
+      size_t            CsChunkSize);
     ~D3D11DeviceContext();
     
     HRESULT STDMETHODCALLTYPE QueryInterface(
@@ -640,7 +642,9 @@ namespace dxvk {
     D3D11Device* const m_parent;
     
     Rc<DxvkDevice>              m_device;
-    Rc<DxvkCsChunk>             m_csChunk;
+    DxvkCsChunkFlags            m_csFlags;
+    Rc<DxvkCsChunkPool>         m_csChunkPool;
+    DxvkCsChunkRef              m_csChunk;
     Rc<DxvkDataBuffer>          m_updateBuffer;
     
     Com<D3D11BlendState>        m_defaultBlendState;
@@ -650,6 +654,11 @@ namespace dxvk {
     D3D11ContextState           m_state;
     UINT                        m_drawCount = 0;
     
+    // Set when recorded commands use queries or dynamic
+    // buffers, which may change before the commands get
+    // executed. Only relevant for deferred contexts.
+    bool                        m_csUsesDynamicResources = false;
+    
     void ApplyInputLayout();
     
     void ApplyPrimitiveTopology();
@@ -691,22 +700,26 @@ namespace dxvk {
             UINT                              Offset,
             DXGI_FORMAT                       Format);
     
-    void BindConstantBuffer(
+    void BindConstantBuffers(
             UINT                              Slot,
-      const D3D11ConstantBufferBinding*       pBufferBinding);
+            UINT                              Count,
+      const D3D11ConstantBufferBinding*       pBufferBindings);
     
-    void BindSampler(
+    void BindSamplers(
             UINT                              Slot,
-            D3D11SamplerState*                pSampler);
+            UINT                              Count,
+      const Com<D3D11SamplerState>*           ppSamplers);
     
-    void BindShaderResource(
+    void BindShaderResources(
             UINT                              Slot,
-            D3D11ShaderResourceView*          pResource);
+            UINT                              Count,
+      const Com<D3D11ShaderResourceView>*     ppResources);
     
-    void BindUnorderedAccessView(
+    void BindUnorderedAccessViews(
             UINT                              UavSlot,
             UINT                              CtrSlot,
-            D3D11UnorderedAccessView*         pUav);
+            UINT                              Count,
+      const Com<D3D11UnorderedAccessView>*    ppUavs);
     
     void SetConstantBuffers(
             DxbcProgramType                   ShaderStage,
@@ -771,12 +784,34 @@ namespace dxvk {
     
     DxvkDataSlice AllocUpdateBufferSlice(size_t Size);
     
+    /**
+     * \brief Splits a binding range into batches
+     * 
+     * Ranged bind commands store their arguments in
+     * fixed-size arrays, so each batch is passed to the
+     * given function together with the smallest array
+     * size that can hold it, as an integral constant.
+     */
+    template<typename Fn>
+    static void ForEachBindBatch(UINT Count, const Fn& Func) {
+      for (UINT first = 0; first < Count; first += 16) {
+        UINT count = std::min(Count - first, 16u);
+        
+        if (count == 1)
+          Func(std::integral_constant<uint32_t,  1>(), first, count);
+        else if (count <= 4)
+          Func(std::integral_constant<uint32_t,  4>(), first, count);
+        else
+          Func(std::integral_constant<uint32_t, 16>(), first, count);
+      }
+    }
+    
     template<typename Cmd>
     void EmitCs(Cmd&& command) {
       if (!m_csChunk->push(command)) {
         EmitCsChunk(std::move(m_csChunk));
         
-        m_csChunk = new DxvkCsChunk();
+        m_csChunk = m_csChunkPool->allocChunk(m_csFlags);
         m_csChunk->push(command);
       }
     }
@@ -784,11 +819,11 @@ namespace dxvk {
     void FlushCsChunk() {
       if (m_csChunk->commandCount() != 0) {
         EmitCsChunk(std::move(m_csChunk));
-        m_csChunk = new DxvkCsChunk();
+        m_csChunk = m_csChunkPool->allocChunk(m_csFlags);
       }
     }
     
-    virtual void EmitCsChunk(Rc<DxvkCsChunk>&& chunk) = 0;
+    virtual void EmitCsChunk(DxvkCsChunkRef&& chunk) = 0;
     
   };
   
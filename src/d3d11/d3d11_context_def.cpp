@@ -6,9 +6,19 @@ namespace dxvk {
     D3D11Device*    pParent,
     Rc<DxvkDevice>  Device,
     UINT            ContextFlags)
-  : D3D11DeviceContext(pParent, Device),
+  : D3D11DeviceContext(pParent, Device, DxvkCsChunkFlags(),
+      DxvkCsChunkPool::getChunkSizeFromEnv(L"DXVK_CS_DEFERRED_CHUNK_SIZE",
+        DxvkCsChunkPool::DefaultDeferredChunkSize)),
     m_contextFlags(ContextFlags),
     m_commandList (CreateCommandList()) {
+    if (IsThreadedRecordingEnabled()) {
+      m_csThread = std::make_unique<DxvkCsThread>(Device->createContext());
+      
+      EmitCsWorker([cDevice = m_device] (DxvkContext* ctx) {
+        ctx->beginRecording(cDevice->createSecondaryCommandList());
+      });
+    }
+    
     ClearState();
   }
   
@@ -33,6 +43,10 @@ namespace dxvk {
           BOOL                RestoreContextState) {
     FlushCsChunk();
     
+    // Secondary command lists cannot be nested, so
+    // the command list has to be replayed instead
+    m_csUsesDynamicResources = true;
+    
     static_cast<D3D11CommandList*>(pCommandList)->EmitToCommandList(m_commandList.ptr());
     
     if (RestoreContextState)
@@ -47,9 +61,13 @@ namespace dxvk {
           ID3D11CommandList   **ppCommandList) {
     FlushCsChunk();
     
+    if (m_csThread != nullptr)
+      FinishSecondaryCommandList();
+    
     if (ppCommandList != nullptr)
       *ppCommandList = m_commandList.ref();
     m_commandList = CreateCommandList();
+    m_csUsesDynamicResources = false;
     
     if (RestoreDeferredContextState)
       RestoreState();
@@ -207,6 +225,10 @@ namespace dxvk {
     const D3D11DeferredContextMapEntry* pMapEntry) {
     D3D11Buffer* pBuffer = static_cast<D3D11Buffer*>(pResource);
     
+    // The buffer must not be renamed before
+    // the command list actually gets executed
+    m_csUsesDynamicResources = true;
+    
     EmitCs([
       cDstBuffer = pBuffer->GetBuffer(),
       cDataSlice = pMapEntry->DataSlice
@@ -255,9 +277,52 @@ namespace dxvk {
   }
   
   
-  void D3D11DeferredContext::EmitCsChunk(Rc<DxvkCsChunk>&& chunk) {
+  void D3D11DeferredContext::FinishSecondaryCommandList() {
+    if (m_csUsesDynamicResources) {
+      // Some commands were not sent to the worker, so the
+      // secondary command list is incomplete. The chunks
+      // will be replayed on the immediate context instead.
+      EmitCsWorker([cDevice = m_device] (DxvkContext* ctx) {
+        ctx->endRecording();
+        ctx->beginRecording(cDevice->createSecondaryCommandList());
+      });
+    } else {
+      Rc<D3D11CommandListRecording> recording = new D3D11CommandListRecording();
+      
+      EmitCsWorker([cDevice = m_device, cRecording = recording] (DxvkContext* ctx) {
+        cRecording->SetCommandList(ctx->endRecording());
+        ctx->beginRecording(cDevice->createSecondaryCommandList());
+      });
+      
+      // Replace the recorded chunks with a single
+      // command that executes the secondary list
+      auto command = [cRecording = std::move(recording)] (DxvkContext* ctx) {
+        ctx->executeCommandList(cRecording->GetCommandList());
+      };
+      
+      DxvkCsChunkRef chunk = m_csChunkPool->allocChunk(m_csFlags);
+      chunk->push(command);
+      
+      m_commandList->ClearChunks();
+      m_commandList->AddChunk(std::move(chunk), 0);
+    }
+  }
+  
+  
+  void D3D11DeferredContext::EmitCsChunk(DxvkCsChunkRef&& chunk) {
+    // Chunks recorded on deferred contexts are not single-use,
+    // so the worker can execute them while the command list
+    // keeps them around in case they need to be replayed.
+    if (m_csThread != nullptr && !m_csUsesDynamicResources)
+      m_csThread->dispatchChunk(DxvkCsChunkRef(chunk));
+    
     m_commandList->AddChunk(std::move(chunk), m_drawCount);
     m_drawCount = 0;
   }
-
+  
+  
+  bool D3D11DeferredContext::IsThreadedRecordingEnabled() {
+    return env::getEnvVar(L"DXVK_THREADED_DEFERRED_CONTEXTS") == "1";
+  }
+  
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "d3d11_texture.h"
 
 #include <algorithm>
+#include <memory>
 #include <vector>
 
 namespace dxvk {
@@ -60,6 +61,10 @@ namespace dxvk {
     // Command list that we're recording
     Com<D3D11CommandList> m_commandList;
     
+    // Worker thread which records the command list into
+    // a secondary command list in parallel, if enabled.
+    std::unique_ptr<DxvkCsThread> m_csThread;
+    
     // Info about currently mapped (sub)resources. Using a vector
     // here is reasonable since there will usually only be a small
     // number of mapped resources per command list.
@@ -89,7 +94,19 @@ namespace dxvk {
     
     Com<D3D11CommandList> CreateCommandList();
     
-    void EmitCsChunk(Rc<DxvkCsChunk>&& chunk) final;
+    void FinishSecondaryCommandList();
+    
+    void EmitCsChunk(DxvkCsChunkRef&& chunk) final;
+    
+    template<typename Cmd>
+    void EmitCsWorker(Cmd&& command) {
+      DxvkCsChunkRef chunk = m_csChunkPool->allocChunk(DxvkCsChunkFlag::SingleUse);
+      chunk->push(command);
+      
+      m_csThread->dispatchChunk(std::move(chunk));
+    }
+    
+    static bool IsThreadedRecordingEnabled();
     
     auto FindMapEntry(ID3D11Resource* pResource, UINT Subresource) {
       return std::find_if(m_mappedResources.rbegin(), m_mappedResources.rend(),
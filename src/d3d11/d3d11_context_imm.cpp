@@ -8,8 +8,10 @@ namespace dxvk {
   D3D11ImmediateContext::D3D11ImmediateContext(
     D3D11Device*    pParent,
     Rc<DxvkDevice>  Device)
-  : D3D11DeviceContext(pParent, Device),
-    m_csThread(Device->createContext()) {
+  : D3D11DeviceContext(pParent, Device, DxvkCsChunkFlag::SingleUse,
+      DxvkCsChunkPool::getChunkSizeFromEnv(L"DXVK_CS_CHUNK_SIZE",
+        DxvkCsChunkPool::DefaultChunkSize)),
+    m_csThread(Device->createContext(), Device->profiler()) {
     EmitCs([cDevice = m_device] (DxvkContext* ctx) {
       ctx->beginRecording(cDevice->createCommandList());
     });
@@ -368,20 +370,19 @@ namespace dxvk {
     Flush();
     SynchronizeCsThread();
     
-    if (Resource->isInUse()) {
-      if (MapFlags & D3D11_MAP_FLAG_DO_NOT_WAIT)
-        return false;
-      
-      // TODO implement properly in DxvkDevice
-      while (Resource->isInUse())
-        std::this_thread::yield();
-    }
+    if (MapFlags & D3D11_MAP_FLAG_DO_NOT_WAIT)
+      return m_device->waitForResource(Resource, 0);
+    
+    // Block until the last submission using the resource has
+    // completed. We cannot fail the map, so keep waiting.
+    while (!m_device->waitForResource(Resource, 1'000'000'000ull))
+      Logger::warn("D3D11: Resource still in use after one second");
     
     return true;
   }
   
   
-  void D3D11ImmediateContext::EmitCsChunk(Rc<DxvkCsChunk>&& chunk) {
+  void D3D11ImmediateContext::EmitCsChunk(DxvkCsChunkRef&& chunk) {
     m_csThread.dispatchChunk(std::move(chunk));
     m_csIsBusy = true;
   }
@@ -40,43 +40,115 @@ namespace dxvk {
   }
   
   
-  D3D11ShaderModule:: D3D11ShaderModule() { }
-  D3D11ShaderModule::~D3D11ShaderModule() { }
-  
-  
-  D3D11ShaderModule::D3D11ShaderModule(
+  D3D11ShaderCompileTask::D3D11ShaderCompileTask(
     const D3D11ShaderKey* pShaderKey,
     const DxbcOptions*    pDxbcOptions,
     const void*           pShaderBytecode,
           size_t          BytecodeLength)
-  : m_name(pShaderKey->GetName()) {
-    Logger::debug(str::format("Compiling shader ", m_name));
-    
+  : m_name    (pShaderKey->GetName()),
+    m_hash    (pShaderKey->GetSha1Hash()),
+    m_options (*pDxbcOptions) {
     DxbcReader reader(
       reinterpret_cast<const char*>(pShaderBytecode),
       BytecodeLength);
     
-    DxbcModule module(reader);
+    // The module copies all the data it needs, since the
+    // bytecode is only valid during shader creation. For
+    // the same reason, the raw DXBC shader is dumped here.
+    m_module = std::make_unique<DxbcModule>(reader);
     
-    // If requested by the user, dump both the raw DXBC
-    // shader and the compiled SPIR-V module to a file.
     const std::string dumpPath = env::getEnvVar(L"DXVK_SHADER_DUMP_PATH");
-    const std::string readPath = env::getEnvVar(L"DXVK_SHADER_READ_PATH");
     
     if (dumpPath.size() != 0) {
       reader.store(std::ofstream(str::format(dumpPath, "/", m_name, ".dxbc"),
         std::ios_base::binary | std::ios_base::trunc));
     }
+  }
+  
+  
+  D3D11ShaderCompileTask::~D3D11ShaderCompileTask() {
     
-    m_shader = module.compile(*pDxbcOptions, m_name);
-    m_shader->setDebugName(m_name);
+  }
+  
+  
+  bool D3D11ShaderCompileTask::Compile() {
+    State expected = State::Queued;
+    
+    if (!m_state.compare_exchange_strong(expected, State::Compiling))
+      return false;
+    
+    Rc<DxvkShader> shader;
+    std::string    error;
+    
+    try {
+      shader = this->CompileShader();
+    } catch (const DxvkError& e) {
+      error = e.message();
+    } catch (const std::exception& e) {
+      error = e.what();
+    }
+    
+    if (shader == nullptr)
+      Logger::err(str::format("Failed to compile shader ", m_name, ": ", error));
+    
+    // The DXBC module is no longer needed
+    m_module = nullptr;
+    
+    { std::unique_lock<std::mutex> lock(m_mutex);
+      m_shader = std::move(shader);
+      m_error  = std::move(error);
+      m_state.store(State::Done);
+    }
+    
+    m_condOnDone.notify_all();
+    return true;
+  }
+  
+  
+  Rc<DxvkShader> D3D11ShaderCompileTask::GetShader() {
+    if (m_state.load() != State::Done && !this->Compile()) {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      
+      m_condOnDone.wait(lock, [this] {
+        return m_state.load() == State::Done;
+      });
+    }
+    
+    // The shader behaves as if it was not bound at all,
+    // since we can no longer fail the creation call.
+    if (m_shader == nullptr && !m_reported.exchange(true)) {
+      Logger::err(str::format("Ignoring shader ", m_name,
+        ", which failed to compile: ", m_error));
+    }
+    
+    return m_shader;
+  }
+  
+  
+  bool D3D11ShaderCompileTask::Failed() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_state.load() == State::Done && m_shader == nullptr;
+  }
+  
+  
+  Rc<DxvkShader> D3D11ShaderCompileTask::CompileShader() const {
+    Logger::debugf("Compiling shader ", m_name);
+    
+    Rc<DxvkShader> shader = m_module->compile(m_options, m_name);
+    shader->setDebugName(m_name);
+    shader->setShaderKey(m_hash);
+    
+    // If requested by the user, dump the compiled
+    // SPIR-V module to a file.
+    const std::string dumpPath = env::getEnvVar(L"DXVK_SHADER_DUMP_PATH");
+    const std::string readPath = env::getEnvVar(L"DXVK_SHADER_READ_PATH");
     
     if (dumpPath.size() != 0) {
       std::ofstream dumpStream(
         str::format(dumpPath, "/", m_name, ".spv"),
         std::ios_base::binary | std::ios_base::trunc);
       
-      m_shader->dump(dumpStream);
+      shader->dump(dumpStream);
     }
     
     // If requested by the user, replace
@@ -88,7 +160,85 @@ namespace dxvk {
         std::ios_base::binary);
       
       if (readStream)
-        m_shader->read(readStream);
+        shader->read(readStream);
+    }
+    
+    return shader;
+  }
+  
+  
+  D3D11ShaderModule:: D3D11ShaderModule() { }
+  D3D11ShaderModule::~D3D11ShaderModule() { }
+  
+  
+  D3D11ShaderModule::D3D11ShaderModule(
+    const D3D11ShaderKey*               pShaderKey,
+    const Rc<D3D11ShaderCompileTask>&   pCompileTask)
+  : m_name(pShaderKey->GetName()),
+    m_task(pCompileTask) { }
+  
+  
+  D3D11ShaderCompiler::D3D11ShaderCompiler() {
+    uint32_t workerCount = std::max(1u, std::thread::hardware_concurrency());
+    
+    const std::string workerCountStr = env::getEnvVar(L"DXVK_SHADER_COMPILE_THREADS");
+    
+    if (!workerCountStr.empty())
+      workerCount = std::strtoul(workerCountStr.c_str(), nullptr, 10);
+    
+    if (workerCount != 0) {
+      Logger::info(str::format(
+        "D3D11ShaderCompiler: Using ", workerCount, " workers"));
+    }
+    
+    for (uint32_t i = 0; i < workerCount; i++)
+      m_workers.emplace_back([this] () { RunWorker(); });
+  }
+  
+  
+  D3D11ShaderCompiler::~D3D11ShaderCompiler() {
+    { std::unique_lock<std::mutex> lock(m_mutex);
+      m_stopped.store(true);
+    }
+    
+    m_condOnAdd.notify_all();
+    
+    for (auto& worker : m_workers)
+      worker.join();
+  }
+  
+  
+  void D3D11ShaderCompiler::QueueCompilation(
+    const Rc<D3D11ShaderCompileTask>& pTask) {
+    { std::unique_lock<std::mutex> lock(m_mutex);
+      m_tasks.push(pTask);
+    }
+    
+    m_condOnAdd.notify_one();
+  }
+  
+  
+  void D3D11ShaderCompiler::RunWorker() {
+    while (!m_stopped.load()) {
+      Rc<D3D11ShaderCompileTask> task;
+      
+      { std::unique_lock<std::mutex> lock(m_mutex);
+        
+        m_condOnAdd.wait(lock, [this] {
+          return m_stopped.load() || (m_tasks.size() != 0);
+        });
+        
+        if (m_tasks.size() != 0) {
+          task = std::move(m_tasks.front());
+          m_tasks.pop();
+        }
+      }
+      
+      // Tasks that are still queued when the compiler
+      // stops will be compiled by the first thread
+      // that tries to use the shader instead.
+      if (task != nullptr)
+        task->Compile();
     }
   }
   
@@ -112,12 +262,27 @@ namespace dxvk {
         return entry->second;
     }
     
-    // This shader has not been compiled yet, so we have to create a
-    // new module. This takes a while, so we won't lock the structure.
-    D3D11ShaderModule module(&key, pDxbcOptions, pShaderBytecode, BytecodeLength);
+    // This shader has not been created yet, so we have to create a new
+    // module. Parsing the DXBC module may throw if the bytecode is invalid,
+    // which is reported to the application. The SPIR-V shader itself is
+    // compiled in the background, or right away if that is disabled.
+    Rc<D3D11ShaderCompileTask> task = new D3D11ShaderCompileTask(
+      &key, pDxbcOptions, pShaderBytecode, BytecodeLength);
+    
+    // Without workers, compile the shader right away so
+    // that errors are reported to the application. With
+    // workers, errors are reported when the shader is used.
+    if (!m_compiler.IsAsync()) {
+      task->Compile();
+      
+      if (task->Failed())
+        throw DxvkError(str::format("Failed to compile shader ", key.GetName()));
+    }
+    
+    D3D11ShaderModule module(&key, task);
     
     // Insert the new module into the lookup table. If another thread
-    // has compiled the same shader in the meantime, we should return
+    // has created the same shader in the meantime, we should return
     // that object instead and discard the newly created module.
     { std::unique_lock<std::mutex> lock(m_mutex);
       
@@ -126,6 +291,9 @@ namespace dxvk {
         return status.first->second;
     }
     
+    if (m_compiler.IsAsync())
+      m_compiler.QueueCompilation(task);
+    
     return module;
   }
   
@@ -1,7 +1,13 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
+#include <queue>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "../dxbc/dxbc_module.h"
 #include "../dxvk/dxvk_device.h"
@@ -37,6 +43,10 @@ namespace dxvk {
     
     size_t GetHash() const;
     
+    const Sha1Hash& GetSha1Hash() const {
+      return m_hash;
+    }
+    
     bool operator == (const D3D11ShaderKey& other) const {
       return m_type == other.m_type
           && m_hash == other.m_hash;
@@ -56,12 +66,90 @@ namespace dxvk {
   };
   
   
+  /**
+   * \brief Shader compile task
+   * 
+   * Holds the parsed DXBC module and, once compiled,
+   * the resulting SPIR-V shader. Compilation can be
+   * performed by a worker thread or by the first
+   * thread that requests the shader, whichever
+   * comes first.
+   */
+  class D3D11ShaderCompileTask : public RcObject {
+    
+  public:
+    
+    D3D11ShaderCompileTask(
+      const D3D11ShaderKey* pShaderKey,
+      const DxbcOptions*    pDxbcOptions,
+      const void*           pShaderBytecode,
+            size_t          BytecodeLength);
+    ~D3D11ShaderCompileTask();
+    
+    /**
+     * \brief Compiles the shader
+     * 
+     * Does nothing if another thread has
+     * already started compiling the shader.
+     * \returns \c true if this thread compiled
+     *          the shader, \c false otherwise
+     */
+    bool Compile();
+    
+    /**
+     * \brief Retrieves the compiled shader
+     * 
+     * Compiles the shader on the calling thread if no
+     * worker has picked it up yet, and waits for the
+     * compilation to finish otherwise. If compilation
+     * failed, this logs an error the first time.
+     * \returns The compiled shader, or \c nullptr
+     *          if compilation failed
+     */
+    Rc<DxvkShader> GetShader();
+    
+    /**
+     * \brief Checks whether compilation failed
+     * 
+     * Does not wait for compilation to finish.
+     * \returns \c true if compilation has
+     *          finished without a shader
+     */
+    bool Failed();
+    
+  private:
+    
+    enum class State : uint32_t {
+      Queued, Compiling, Done,
+    };
+    
+    std::atomic<State>      m_state = { State::Queued };
+    
+    std::mutex              m_mutex;
+    std::condition_variable m_condOnDone;
+    
+    std::string             m_name;
+    Sha1Hash                m_hash;
+    DxbcOptions             m_options;
+    Rc<DxvkShader>          m_shader;
+    std::string             m_error;
+    std::atomic<bool>       m_reported = { false };
+    
+    std::unique_ptr<DxbcModule> m_module;
+    
+    Rc<DxvkShader> CompileShader() const;
+    
+  };
+  
+  
   /**
    * \brief Shader module
    * 
    * Stores the compiled SPIR-V shader and the SHA-1
    * hash of the original DXBC shader, which can be
-   * used to identify the shader.
+   * used to identify the shader. The SPIR-V shader
+   * may still be compiling in the background, in
+   * which case \ref GetShader will wait for it.
    */
   class D3D11ShaderModule {
     
@@ -69,24 +157,24 @@ namespace dxvk {
     
     D3D11ShaderModule();
     D3D11ShaderModule(
-      const D3D11ShaderKey* pShaderKey,
-      const DxbcOptions*    pDxbcOptions,
-      const void*           pShaderBytecode,
-            size_t          BytecodeLength);
+      const D3D11ShaderKey*               pShaderKey,
+      const Rc<D3D11ShaderCompileTask>&   pCompileTask);
     ~D3D11ShaderModule();
     
     Rc<DxvkShader> GetShader() const {
-      return m_shader;
+      return m_task != nullptr
+        ? m_task->GetShader()
+        : nullptr;
     }
     
-    std::string GetName() const {
+    const std::string& GetName() const {
       return m_name;
     }
     
   private:
     
-    std::string    m_name;
-    Rc<DxvkShader> m_shader;
+    std::string                 m_name;
+    Rc<D3D11ShaderCompileTask>  m_task;
     
   };
   
@@ -149,6 +237,54 @@ namespace dxvk {
   using D3D11ComputeShader  = D3D11Shader<ID3D11ComputeShader>;
   
   
+  /**
+   * \brief Shader compiler
+   * 
+   * Translates DXBC shaders to SPIR-V on a pool of worker
+   * threads, so that applications creating large numbers
+   * of shaders at once do not have to wait for each
+   * individual shader to be compiled.
+   */
+  class D3D11ShaderCompiler {
+    
+  public:
+    
+    D3D11ShaderCompiler();
+    ~D3D11ShaderCompiler();
+    
+    /**
+     * \brief Checks whether there are any workers
+     * 
+     * If this returns \c false, shaders must
+     * be compiled on the creating thread.
+     * \returns \c true if compilation is asynchronous
+     */
+    bool IsAsync() const {
+      return !m_workers.empty();
+    }
+    
+    /**
+     * \brief Queues a shader for compilation
+     * \param [in] pTask The compile task
+     */
+    void QueueCompilation(
+      const Rc<D3D11ShaderCompileTask>& pTask);
+    
+  private:
+    
+    std::atomic<bool>         m_stopped = { false };
+    
+    std::mutex                m_mutex;
+    std::condition_variable   m_condOnAdd;
+    
+    std::queue<Rc<D3D11ShaderCompileTask>> m_tasks;
+    std::vector<std::thread>  m_workers;
+    
+    void RunWorker();
+    
+  };
+  
+  
   /**
    * \brief Shader module set
    * 
@@ -179,6 +315,8 @@ namespace dxvk {
       D3D11ShaderModule,
       D3D11ShaderKeyHash> m_modules;
     
+    D3D11ShaderCompiler m_compiler;
+    
   };
   
 }
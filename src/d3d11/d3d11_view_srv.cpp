@@ -60,6 +60,12 @@ namespace dxvk {
   }
   
   
+  bool D3D11ShaderResourceView::IsDynamicBuffer() const {
+    return GetResourceType() == D3D11_RESOURCE_DIMENSION_BUFFER
+        && static_cast<D3D11Buffer*>(m_resource.ptr())->IsDynamic();
+  }
+  
+  
   HRESULT D3D11ShaderResourceView::GetDescFromResource(
           ID3D11Resource*                   pResource,
           D3D11_SHADER_RESOURCE_VIEW_DESC*  pDesc) {
@@ -51,6 +51,8 @@ namespace dxvk {
       return m_imageView;
     }
     
+    bool IsDynamicBuffer() const;
+    
     static HRESULT GetDescFromResource(
             ID3D11Resource*                   pResource,
             D3D11_SHADER_RESOURCE_VIEW_DESC*  pDesc);
@@ -186,13 +186,23 @@ namespace dxvk {
       m_entryPointInterfaces.data());
     m_module.setDebugName(m_entryPointId, "main");
     
+    SpirvCodeBuffer code = m_module.compile();
+    
+    // Temp registers are only ever accessed as whole
+    // vectors, so most accesses can be promoted to
+    // SSA values before handing the code to the driver
+    if (m_options.promoteTempRegisters) {
+      SpirvRegisterPromotion pass(m_rRegs.size(), m_rRegs.data());
+      code = pass.run(code);
+    }
+    
     // Create the shader module object
     return new DxvkShader(
       m_version.shaderStage(),
       m_resourceSlots.size(),
       m_resourceSlots.data(),
       m_interfaceSlots,
-      m_module.compile());
+      code);
   }
   
   
@@ -20,6 +20,9 @@ namespace dxvk {
     
     // Enable certain features if they are supported by the device
     this->useStorageImageReadWithoutFormat = devFeatures.shaderStorageImageReadWithoutFormat;
+    
+    // Optional SPIR-V optimizations
+    this->promoteTempRegisters = env::getEnvVar(L"DXVK_SHADER_PROMOTE_TEMPS") == "1";
   }
   
 }
\ No newline at end of file
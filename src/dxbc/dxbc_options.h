@@ -24,6 +24,10 @@ namespace dxvk {
     /// If \c false, image read operations can only be performed
     /// on storage images with a scalar 32-bit image formats.
     bool useStorageImageReadWithoutFormat = false;
+    
+    /// Promote temp registers to SSA values where
+    /// possible instead of relying on the driver
+    bool promoteTempRegisters = false;
   };
   
 }
\ No newline at end of file
@@ -5,6 +5,81 @@ namespace dxvk {
   DxvkBarrierSet:: DxvkBarrierSet() { }
   DxvkBarrierSet::~DxvkBarrierSet() { }
   
+  namespace {
+    
+    // A length of zero refers to the remainder of the buffer,
+    // as seen with slices that only provide a start offset.
+    bool overlaps(
+            VkDeviceSize a, VkDeviceSize aLength,
+            VkDeviceSize b, VkDeviceSize bLength) {
+      return (aLength == 0 || b < a + aLength)
+          && (bLength == 0 || a < b + bLength);
+    }
+    
+    bool overlaps(
+            uint32_t a, uint32_t aCount,
+            uint32_t b, uint32_t bCount) {
+      const uint64_t aEnd = aCount == ~0u ? ~0ull : uint64_t(a) + aCount;
+      const uint64_t bEnd = bCount == ~0u ? ~0ull : uint64_t(b) + bCount;
+      return b < aEnd && a < bEnd;
+    }
+    
+    bool isHazard(
+            DxvkResourceAccessTypes prevAccess,
+            DxvkResourceAccessTypes nextAccess) {
+      return prevAccess.test(DxvkResourceAccessType::Write)
+          || nextAccess.test(DxvkResourceAccessType::Write);
+    }
+    
+  }
+  
+  
+  bool DxvkBarrierSet::isBufferDirty(
+    const DxvkPhysicalBufferSlice&  bufSlice,
+          DxvkResourceAccessTypes   bufAccess) const {
+    auto head = m_bufHeads.find(bufSlice.handle());
+    
+    if (head == m_bufHeads.end())
+      return false;
+    
+    for (uint32_t i = head->second; i != ~0u; i = m_bufSlices[i].next) {
+      const BufSlice& slice = m_bufSlices[i];
+      
+      if (isHazard(slice.access, bufAccess)
+       && overlaps(slice.offset, slice.length, bufSlice.offset(), bufSlice.length()))
+        return true;
+    }
+    
+    return false;
+  }
+  
+  
+  bool DxvkBarrierSet::isImageDirty(
+    const Rc<DxvkImage>&            image,
+    const VkImageSubresourceRange&  imgSubres,
+          DxvkResourceAccessTypes   imgAccess) const {
+    auto head = m_imgHeads.find(image->handle());
+    
+    if (head == m_imgHeads.end())
+      return false;
+    
+    // Barriers always apply to all aspects of
+    // the image, so we do not compare those.
+    for (uint32_t i = head->second; i != ~0u; i = m_imgSlices[i].next) {
+      const ImgSlice& slice = m_imgSlices[i];
+      
+      if (isHazard(slice.access, imgAccess)
+       && overlaps(slice.subres.baseMipLevel,   slice.subres.levelCount,
+                   imgSubres.baseMipLevel,      imgSubres.levelCount)
+       && overlaps(slice.subres.baseArrayLayer, slice.subres.layerCount,
+                   imgSubres.baseArrayLayer,    imgSubres.layerCount))
+        return true;
+    }
+    
+    return false;
+  }
+  
+  
   void DxvkBarrierSet::accessBuffer(
     const DxvkPhysicalBufferSlice&  bufSlice,
           VkPipelineStageFlags      srcStages,
@@ -17,6 +92,9 @@ namespace dxvk {
     m_srcStages |= srcStages;
     m_dstStages |= dstStages;
     
+    this->trackBuffer(bufSlice.handle(),
+      { bufSlice.offset(), bufSlice.length(), accessTypes, ~0u });
+    
     if (accessTypes.test(DxvkResourceAccessType::Write)) {
       VkBufferMemoryBarrier barrier;
       barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
@@ -27,7 +105,8 @@ namespace dxvk {
       barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
       barrier.buffer              = bufSlice.handle();
       barrier.offset              = bufSlice.offset();
-      barrier.size                = bufSlice.length();
+      barrier.size                = bufSlice.length() != 0
+        ? bufSlice.length() : VK_WHOLE_SIZE;
       m_bufBarriers.push_back(barrier);
     }
   }
@@ -42,12 +121,20 @@ namespace dxvk {
           VkImageLayout             dstLayout,
           VkPipelineStageFlags      dstStages,
           VkAccessFlags             dstAccess) {
-    const DxvkResourceAccessTypes accessTypes
+    DxvkResourceAccessTypes accessTypes
       = this->getAccessTypes(srcAccess);
     
+    // Layout transitions modify the image, and any
+    // access has to wait until they are executed
+    if (srcLayout != dstLayout)
+      accessTypes.set(DxvkResourceAccessType::Write);
+    
     m_srcStages |= srcStages;
     m_dstStages |= dstStages;
     
+    this->trackImage(image->handle(),
+      { subresources, accessTypes, ~0u });
+    
     if ((srcLayout != dstLayout) || accessTypes.test(DxvkResourceAccessType::Write)) {
       VkImageMemoryBarrier barrier;
       barrier.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -92,6 +179,56 @@ namespace dxvk {
     m_memBarriers.resize(0);
     m_bufBarriers.resize(0);
     m_imgBarriers.resize(0);
+    
+    m_bufSlices.resize(0);
+    m_imgSlices.resize(0);
+    
+    m_bufHeads.clear();
+    m_imgHeads.clear();
+  }
+  
+  
+  void DxvkBarrierSet::trackBuffer(
+          VkBuffer                  handle,
+          BufSlice                  slice) {
+    auto head = m_bufHeads.insert({ handle, ~0u }).first;
+    
+    // Resources that are read by a large number of commands
+    // would otherwise add the same entry over and over again
+    for (uint32_t i = head->second; i != ~0u; i = m_bufSlices[i].next) {
+      const BufSlice& entry = m_bufSlices[i];
+      
+      if (entry.offset       == slice.offset
+       && entry.length       == slice.length
+       && entry.access.raw() == slice.access.raw())
+        return;
+    }
+    
+    slice.next   = head->second;
+    head->second = m_bufSlices.size();
+    m_bufSlices.push_back(slice);
+  }
+  
+  
+  void DxvkBarrierSet::trackImage(
+          VkImage                   handle,
+          ImgSlice                  slice) {
+    auto head = m_imgHeads.insert({ handle, ~0u }).first;
+    
+    for (uint32_t i = head->second; i != ~0u; i = m_imgSlices[i].next) {
+      const ImgSlice& entry = m_imgSlices[i];
+      
+      if (entry.subres.baseMipLevel   == slice.subres.baseMipLevel
+       && entry.subres.levelCount     == slice.subres.levelCount
+       && entry.subres.baseArrayLayer == slice.subres.baseArrayLayer
+       && entry.subres.layerCount     == slice.subres.layerCount
+       && entry.access.raw()          == slice.access.raw())
+        return;
+    }
+    
+    slice.next   = head->second;
+    head->second = m_imgSlices.size();
+    m_imgSlices.push_back(slice);
   }
   
   
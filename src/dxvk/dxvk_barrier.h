@@ -1,5 +1,7 @@
 #pragma once
 
+#include <unordered_map>
+
 #include "dxvk_buffer.h"
 #include "dxvk_cmdlist.h"
 #include "dxvk_image.h"
@@ -12,6 +14,14 @@ namespace dxvk {
    * Accumulates memory barriers and provides a
    * method to record all those barriers into a
    * command buffer at once.
+   * 
+   * The barrier set also keeps track of the buffer
+   * ranges and image subresources that have been
+   * accessed since barriers were last recorded, so
+   * that recording can be delayed until a command
+   * actually depends on one of those accesses. These
+   * accesses are looked up by resource handle, so that
+   * long runs of independent commands stay cheap.
    */
   class DxvkBarrierSet {
     
@@ -19,7 +29,46 @@ namespace dxvk {
     
     DxvkBarrierSet();
     ~DxvkBarrierSet();
-        
+    
+    /**
+     * \brief Checks whether barriers are pending
+     * \returns \c true if there are any accesses
+     *    that have not been recorded yet
+     */
+    bool isPending() const {
+      return (m_srcStages | m_dstStages) != 0;
+    }
+    
+    /**
+     * \brief Checks for a hazard on a buffer range
+     * 
+     * A hazard exists if a pending access overlaps with the
+     * given range and either of the two accesses is a write.
+     * \param [in] bufSlice The buffer range to access
+     * \param [in] bufAccess Access types of the new access
+     * \returns \c true if pending barriers must be
+     *    recorded before the buffer can be accessed
+     */
+    bool isBufferDirty(
+      const DxvkPhysicalBufferSlice&  bufSlice,
+            DxvkResourceAccessTypes   bufAccess) const;
+    
+    /**
+     * \brief Checks for a hazard on image subresources
+     * 
+     * Same as \ref isBufferDirty for images. Pending
+     * layout transitions always count as writes.
+     * \param [in] image The image to access
+     * \param [in] imgSubres Subresources to access
+     * \param [in] imgAccess Access types of the new access
+     * \returns \c true if pending barriers must be
+     *    recorded before the image can be accessed
+     */
+    bool isImageDirty(
+      const Rc<DxvkImage>&            image,
+      const VkImageSubresourceRange&  imgSubres,
+            DxvkResourceAccessTypes   imgAccess) const;
+    
     void accessBuffer(
       const DxvkPhysicalBufferSlice&  bufSlice,
             VkPipelineStageFlags      srcStages,
@@ -44,6 +93,19 @@ namespace dxvk {
     
   private:
     
+    struct BufSlice {
+      VkDeviceSize            offset;
+      VkDeviceSize            length;
+      DxvkResourceAccessTypes access;
+      uint32_t                next;
+    };
+    
+    struct ImgSlice {
+      VkImageSubresourceRange subres;
+      DxvkResourceAccessTypes access;
+      uint32_t                next;
+    };
+    
     VkPipelineStageFlags m_srcStages = 0;
     VkPipelineStageFlags m_dstStages = 0;
     
@@ -51,6 +113,22 @@ namespace dxvk {
     std::vector<VkBufferMemoryBarrier>  m_bufBarriers;
     std::vector<VkImageMemoryBarrier>   m_imgBarriers;
     
+    // Pending accesses to the same resource form a list,
+    // starting at the index stored for the resource handle
+    std::vector<BufSlice>               m_bufSlices;
+    std::vector<ImgSlice>               m_imgSlices;
+    
+    std::unordered_map<VkBuffer, uint32_t> m_bufHeads;
+    std::unordered_map<VkImage,  uint32_t> m_imgHeads;
+    
+    void trackBuffer(
+            VkBuffer                  handle,
+            BufSlice                  slice);
+    
+    void trackImage(
+            VkImage                   handle,
+            ImgSlice                  slice);
+    
     DxvkResourceAccessTypes getAccessTypes(VkAccessFlags flags) const;
     
   };
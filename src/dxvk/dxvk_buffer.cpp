@@ -16,8 +16,22 @@ namespace dxvk {
     m_physSliceStride = align(createInfo.size, 256);
     
     // Allocate a single buffer slice
-    m_physSlice = this->allocPhysicalBuffer(1)
-      ->slice(0, m_physSliceStride);
+    Rc<DxvkPhysicalBuffer> buffer = this->allocPhysicalBuffer(1);
+    m_physSlice = buffer->slice(0, m_physSliceStride);
+    
+    m_frameId = m_device->currentFrameId();
+    m_physBuffers.push_back({ buffer, 1, m_frameId, { } });
+    m_renameStats.sliceCount = 1;
+    
+    // Small dynamic buffers get their slices from the device's
+    // upload ring rather than a slice pool of their own
+    m_useUploadRing = DxvkUploadRing::isSupported(createInfo, memoryType);
+  }
+  
+  
+  DxvkBuffer::~DxvkBuffer() {
+    if (m_trimmable)
+      m_device->unregisterTrimmableBuffer(this);
   }
   
   
@@ -33,41 +47,133 @@ namespace dxvk {
   DxvkPhysicalBufferSlice DxvkBuffer::allocPhysicalSlice() {
     std::unique_lock<std::mutex> freeLock(m_freeMutex);
     
-    // If no slices are available, swap the two free lists.
-    if (m_freeSlices.size() == 0) {
-      std::unique_lock<std::mutex> swapLock(m_swapMutex);
-      std::swap(m_freeSlices, m_nextSlices);
+    const uint64_t frameId = m_device->currentFrameId();
+    
+    if (m_frameId != frameId) {
+      m_renameStats.slicesInFlight = m_frameInFlight;
+      m_frameInFlight = 0;
+      m_frameId       = frameId;
     }
+    
+    // If the upload ring is exhausted, fall back
+    // to allocating slices for this buffer only
+    if (m_useUploadRing) {
+      DxvkPhysicalBufferSlice slice = m_device->allocUploadSlice(m_physSliceLength);
       
+      if (slice.defined()) {
+        m_renameStats.renameCount += 1;
+        return slice;
+      }
+    }
+    
+    // If no slices are available, pick up the slices that
+    // have been returned since the last time we checked.
+    PhysicalBuffer* physBuffer = this->findFreeSlice();
+    
+    if (physBuffer == nullptr) {
+      this->reclaimSlices();
+      physBuffer = this->findFreeSlice();
+    }
+    
     // If there are still no slices available, create a new
-    // physical buffer and add all slices to the free list.
-    if (m_freeSlices.size() == 0) {
-      const Rc<DxvkPhysicalBuffer> buffer
-        = this->allocPhysicalBuffer(m_physSliceCount);
+    // physical buffer which holds as many slices as all the
+    // existing physical buffers combined.
+    bool registerBuffer = false;
+    
+    if (physBuffer == nullptr) {
+      const uint32_t sliceCount = std::max(2u, m_renameStats.sliceCount);
+      
+      PhysicalBuffer entry;
+      entry.buffer       = this->allocPhysicalBuffer(sliceCount);
+      entry.sliceCount   = sliceCount;
+      entry.lastUseFrame = frameId;
       
-      for (uint32_t i = 0; i < m_physSliceCount; i++) {
-        m_freeSlices.push_back(buffer->slice(
+      for (uint32_t i = 0; i < sliceCount; i++) {
+        entry.freeSlices.push_back(entry.buffer->slice(
           m_physSliceStride * i,
           m_physSliceLength));
       }
       
-      m_physSliceCount *= 2;
+      m_physBuffers.push_back(std::move(entry));
+      physBuffer = &m_physBuffers.back();
+      
+      m_renameStats.sliceCount += sliceCount;
+      m_freeSliceCount         += sliceCount;
+      
+      registerBuffer = !std::exchange(m_trimmable, true);
     }
     
-    // Take the first slice from the queue
-    DxvkPhysicalBufferSlice result = std::move(m_freeSlices.back());
-    m_freeSlices.pop_back();
+    // Take the last slice from the physical buffer
+    DxvkPhysicalBufferSlice result = std::move(physBuffer->freeSlices.back());
+    physBuffer->freeSlices.pop_back();
+    physBuffer->lastUseFrame = frameId;
+    
+    m_freeSliceCount          -= 1;
+    m_renameStats.renameCount += 1;
+    
+    { std::unique_lock<std::mutex> swapLock(m_swapMutex);
+      m_frameInFlight = std::max<uint32_t>(m_frameInFlight,
+        m_renameStats.sliceCount - m_freeSliceCount - m_nextSlices.size());
+    }
+    
+    freeLock.unlock();
+    
+    if (registerBuffer)
+      m_device->registerTrimmableBuffer(this);
+    
     return result;
   }
   
   
   void DxvkBuffer::freePhysicalSlice(const DxvkPhysicalBufferSlice& slice) {
+    // Upload ring slices return to the ring on their own once
+    // the last command list using them has completed
+    if (slice.isSuballocated())
+      return;
+    
     // Add slice to a separate free list to reduce lock contention.
     std::unique_lock<std::mutex> swapLock(m_swapMutex);
     m_nextSlices.push_back(slice);
   }
   
   
+  void DxvkBuffer::trimPhysicalSlices(
+          uint64_t        frameId,
+          uint32_t        idleFrames) {
+    std::unique_lock<std::mutex> freeLock(m_freeMutex, std::try_to_lock);
+    
+    if (!freeLock)
+      return;
+    
+    this->reclaimSlices();
+    
+    // Only release physical buffers that are not used by the
+    // GPU anymore. The buffer backing the current slice will
+    // never be released since that slice is not free.
+    for (auto entry = m_physBuffers.begin(); entry != m_physBuffers.end(); ) {
+      if (entry->freeSlices.size() == entry->sliceCount
+       && frameId - entry->lastUseFrame >= idleFrames) {
+        m_renameStats.sliceCount -= entry->sliceCount;
+        m_renameStats.trimCount  += 1;
+        m_freeSliceCount         -= entry->sliceCount;
+        
+        entry = m_physBuffers.erase(entry);
+      } else {
+        entry++;
+      }
+    }
+  }
+  
+  
+  DxvkBufferRenameStats DxvkBuffer::getRenameStats() {
+    std::unique_lock<std::mutex> freeLock(m_freeMutex);
+    
+    DxvkBufferRenameStats result = m_renameStats;
+    result.physBufferCount = m_physBuffers.size();
+    return result;
+  }
+  
+  
   Rc<DxvkPhysicalBuffer> DxvkBuffer::allocPhysicalBuffer(VkDeviceSize sliceCount) const {
     DxvkBufferCreateInfo createInfo = m_info;
     createInfo.size = sliceCount * m_physSliceStride;
@@ -76,6 +182,37 @@ namespace dxvk {
   }
   
   
+  DxvkBuffer::PhysicalBuffer* DxvkBuffer::findFreeSlice() {
+    // Prefer the most recently created physical buffers. Those
+    // are the largest ones, so that older ones can go idle.
+    for (auto entry = m_physBuffers.rbegin(); entry != m_physBuffers.rend(); entry++) {
+      if (entry->freeSlices.size() != 0)
+        return &(*entry);
+    }
+    
+    return nullptr;
+  }
+  
+  
+  void DxvkBuffer::reclaimSlices() {
+    { std::unique_lock<std::mutex> swapLock(m_swapMutex);
+      std::swap(m_reclaimedSlices, m_nextSlices);
+    }
+    
+    for (auto& slice : m_reclaimedSlices) {
+      for (auto entry = m_physBuffers.rbegin(); entry != m_physBuffers.rend(); entry++) {
+        if (entry->buffer->handle() == slice.handle()) {
+          entry->freeSlices.push_back(std::move(slice));
+          m_freeSliceCount += 1;
+          break;
+        }
+      }
+    }
+    
+    m_reclaimedSlices.clear();
+  }
+  
+  
   DxvkBufferView::DxvkBufferView(
     const Rc<vk::DeviceFn>&         vkd,
     const Rc<DxvkBuffer>&           buffer,
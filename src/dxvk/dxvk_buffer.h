@@ -7,6 +7,22 @@
 
 namespace dxvk {
   
+  /**
+   * \brief Buffer rename stats
+   * 
+   * Describes how a buffer's pool of physical
+   * slices is used. Slices are allocated every
+   * time the buffer gets invalidated.
+   */
+  struct DxvkBufferRenameStats {
+    uint64_t renameCount      = 0;  ///< Number of slices handed out so far
+    uint32_t sliceCount       = 0;  ///< Number of slices currently allocated
+    uint32_t slicesInFlight   = 0;  ///< Peak number of slices in use during the last frame
+    uint32_t physBufferCount  = 0;  ///< Number of physical buffers backing the slices
+    uint32_t trimCount        = 0;  ///< Number of physical buffers released so far
+  };
+  
+  
   /**
    * \brief Virtual buffer resource
    * 
@@ -23,6 +39,8 @@ namespace dxvk {
       const DxvkBufferCreateInfo& createInfo,
             VkMemoryPropertyFlags memoryType);
     
+    ~DxvkBuffer();
+    
     /**
      * \brief Buffer properties
      * \returns Buffer properties
@@ -131,8 +149,36 @@ namespace dxvk {
     void freePhysicalSlice(
       const DxvkPhysicalBufferSlice& slice);
     
+    /**
+     * \brief Releases idle physical buffers
+     * 
+     * Frees physical buffers whose slices have all
+     * been returned and none of which have been used
+     * for the given number of frames. Called by the
+     * device once per frame. Does nothing if the slice
+     * pool is currently being accessed by another thread.
+     * \param [in] frameId Current frame number
+     * \param [in] idleFrames Number of idle frames
+     */
+    void trimPhysicalSlices(
+            uint64_t        frameId,
+            uint32_t        idleFrames);
+    
+    /**
+     * \brief Queries rename stats
+     * \returns Rename stats for this buffer
+     */
+    DxvkBufferRenameStats getRenameStats();
+    
   private:
     
+    struct PhysicalBuffer {
+      Rc<DxvkPhysicalBuffer>               buffer;
+      uint32_t                             sliceCount;
+      uint64_t                             lastUseFrame;
+      std::vector<DxvkPhysicalBufferSlice> freeSlices;
+    };
+    
     DxvkDevice*             m_device;
     DxvkBufferCreateInfo    m_info;
     VkMemoryPropertyFlags   m_memFlags;
@@ -143,16 +189,29 @@ namespace dxvk {
     std::mutex m_freeMutex;
     std::mutex m_swapMutex;
     
-    std::vector<DxvkPhysicalBufferSlice> m_freeSlices;
+    std::vector<PhysicalBuffer>          m_physBuffers;
     std::vector<DxvkPhysicalBufferSlice> m_nextSlices;
+    std::vector<DxvkPhysicalBufferSlice> m_reclaimedSlices;
     
     VkDeviceSize m_physSliceLength  = 0;
     VkDeviceSize m_physSliceStride  = 0;
-    VkDeviceSize m_physSliceCount   = 2;
+    
+    uint32_t     m_freeSliceCount   = 0;
+    uint32_t     m_frameInFlight    = 0;
+    uint64_t     m_frameId          = 0;
+    bool         m_trimmable        = false;
+    
+    DxvkBufferRenameStats m_renameStats;
+    
+    bool                  m_useUploadRing = false;
     
     Rc<DxvkPhysicalBuffer> allocPhysicalBuffer(
             VkDeviceSize    sliceCount) const;
     
+    PhysicalBuffer* findFreeSlice();
+    
+    void reclaimSlices();
+    
     void lock();
     void unlock();
     
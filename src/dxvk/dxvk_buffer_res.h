@@ -128,6 +128,24 @@ namespace dxvk {
       m_offset(offset),
       m_length(length) { }
     
+    DxvkPhysicalBufferSlice(
+      const Rc<DxvkPhysicalBuffer>& buffer,
+            VkDeviceSize            offset,
+            VkDeviceSize            length,
+      const Rc<DxvkResource>&       owner)
+    : m_buffer(buffer),
+      m_offset(offset),
+      m_length(length),
+      m_owner (owner) { }
+    
+    /**
+     * \brief Checks whether the slice is valid
+     * \returns \c true if the slice has a buffer
+     */
+    bool defined() const {
+      return m_buffer != nullptr;
+    }
+    
     /**
      * \brief Buffer handle
      * \returns Buffer handle
@@ -165,7 +183,7 @@ namespace dxvk {
      * \returns The sub slice
      */
     DxvkPhysicalBufferSlice subSlice(VkDeviceSize offset, VkDeviceSize length) const {
-      return DxvkPhysicalBufferSlice(m_buffer, m_offset + offset, length);
+      return DxvkPhysicalBufferSlice(m_buffer, m_offset + offset, length, m_owner);
     }
     
     /**
@@ -183,17 +201,37 @@ namespace dxvk {
     
     /**
      * \brief The buffer resource
+     * 
+     * For sub-allocated slices, this is the resource
+     * that owns the slice rather than the buffer, so
+     * that tracking it keeps the slice itself alive.
      * \returns Buffer resource
      */
     Rc<DxvkResource> resource() const {
+      if (m_owner != nullptr)
+        return m_owner;
       return m_buffer;
     }
     
+    /**
+     * \brief Checks whether the slice is sub-allocated
+     * 
+     * Sub-allocated slices are returned to their allocator
+     * once the owning resource is destroyed, i.e. when no
+     * copy of the slice exists and no command list that
+     * uses the slice is still in flight.
+     * \returns \c true if the slice has an owner
+     */
+    bool isSuballocated() const {
+      return m_owner != nullptr;
+    }
+    
   private:
     
     Rc<DxvkPhysicalBuffer> m_buffer = nullptr;
     VkDeviceSize           m_offset = 0;
     VkDeviceSize           m_length = 0;
+    Rc<DxvkResource>       m_owner  = nullptr;
     
   };
   
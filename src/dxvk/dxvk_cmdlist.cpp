@@ -4,12 +4,15 @@
 namespace dxvk {
     
   DxvkCommandList::DxvkCommandList(
-    const Rc<vk::DeviceFn>& vkd,
-          DxvkDevice*       device,
-          uint32_t          queueFamily)
+    const Rc<vk::DeviceFn>&     vkd,
+          DxvkDevice*           device,
+          uint32_t              queueFamily,
+          VkCommandBufferLevel  level)
   : m_vkd         (vkd),
-    m_descAlloc   (vkd),
-    m_stagingAlloc(device) {
+    m_level       (level),
+    m_descAlloc   (device),
+    m_stagingAlloc(device),
+    m_profiler    (device->profiler()) {
     VkFenceCreateInfo fenceInfo;
     fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
     fenceInfo.pNext = nullptr;
@@ -27,6 +30,11 @@ namespace dxvk {
     if (m_vkd->vkCreateCommandPool(m_vkd->device(), &poolInfo, nullptr, &m_pool) != VK_SUCCESS)
       throw DxvkError("DxvkCommandList: Failed to create command pool");
     
+    // Secondary command lists allocate their
+    // command buffers on demand, one per segment
+    if (this->isSecondary())
+      return;
+    
     VkCommandBufferAllocateInfo cmdInfo;
     cmdInfo.sType             = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     cmdInfo.pNext             = nullptr;
@@ -82,7 +90,25 @@ namespace dxvk {
   }
   
   
+  void DxvkCommandList::setSequenceNumber(uint64_t sequence) {
+    m_sequence = sequence;
+    m_resources.setLastUse(sequence);
+    
+    for (const auto& cmdList : m_secondaryLists)
+      cmdList->m_resources.setLastUse(sequence);
+  }
+  
+  
   void DxvkCommandList::beginRecording() {
+    if (this->isSecondary()) {
+      if (m_vkd->vkResetCommandPool(m_vkd->device(), m_pool, 0) != VK_SUCCESS)
+        Logger::err("DxvkCommandList: Failed to reset command buffer");
+      
+      m_segments.clear();
+      this->beginSegment(VK_NULL_HANDLE, VK_NULL_HANDLE, VkRect2D());
+      return;
+    }
+    
     VkCommandBufferBeginInfo info;
     info.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     info.pNext            = nullptr;
@@ -97,26 +123,208 @@ namespace dxvk {
     
     if (m_vkd->vkResetFences(m_vkd->device(), 1, &m_fence) != VK_SUCCESS)
       Logger::err("DxvkCommandList: Failed to reset fence");
+    
+    if (m_profiler->isGpuEnabled())
+      this->beginTimestamps();
   }
   
   
   void DxvkCommandList::endRecording() {
+    if (m_timestampCount != 0) {
+      this->cmdWriteTimestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        m_timestampPool->handle(), m_timestampCount++);
+    }
+    
     if (m_vkd->vkEndCommandBuffer(m_buffer) != VK_SUCCESS)
       Logger::err("DxvkCommandList::endRecording: Failed to record command buffer");
   }
   
   
+  void DxvkCommandList::cmdBeginRenderPass(
+    const VkRenderPassBeginInfo*  pRenderPassBegin,
+          VkSubpassContents       contents) {
+    if (this->isSecondary()) {
+      this->endSegment();
+      this->beginSegment(
+        pRenderPassBegin->renderPass,
+        pRenderPassBegin->framebuffer,
+        pRenderPassBegin->renderArea);
+      
+      // Clear values are needed when the primary
+      // command list begins the render pass
+      DxvkCommandListSegment& segment = m_segments.back();
+      segment.clearValueCount = pRenderPassBegin->clearValueCount;
+      
+      for (uint32_t i = 0; i < segment.clearValueCount; i++)
+        segment.clearValues[i] = pRenderPassBegin->pClearValues[i];
+    } else {
+      this->beginTimestampRegion();
+      
+      m_vkd->vkCmdBeginRenderPass(m_buffer,
+        pRenderPassBegin, contents);
+    }
+  }
+  
+  
+  void DxvkCommandList::cmdEndRenderPass() {
+    if (this->isSecondary()) {
+      this->endSegment();
+      this->beginSegment(VK_NULL_HANDLE, VK_NULL_HANDLE, VkRect2D());
+    } else {
+      m_vkd->vkCmdEndRenderPass(m_buffer);
+      
+      this->endTimestampRegion();
+    }
+  }
+  
+  
+  void DxvkCommandList::cmdExecuteCommands(
+    const Rc<DxvkCommandList>&    cmdList) {
+    for (const DxvkCommandListSegment& segment : cmdList->m_segments) {
+      if (segment.renderPass != VK_NULL_HANDLE) {
+        VkRenderPassBeginInfo info;
+        info.sType            = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        info.pNext            = nullptr;
+        info.renderPass       = segment.renderPass;
+        info.framebuffer      = segment.framebuffer;
+        info.renderArea       = segment.renderArea;
+        info.clearValueCount  = segment.clearValueCount;
+        info.pClearValues     = segment.clearValues.data();
+        
+        this->beginTimestampRegion();
+        
+        m_vkd->vkCmdBeginRenderPass(m_buffer, &info,
+          VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        m_vkd->vkCmdExecuteCommands(m_buffer, 1, &segment.cmdBuffer);
+        m_vkd->vkCmdEndRenderPass(m_buffer);
+        
+        this->endTimestampRegion();
+      } else {
+        m_vkd->vkCmdExecuteCommands(m_buffer, 1, &segment.cmdBuffer);
+      }
+    }
+    
+    // Stat counters of secondary command lists are only
+    // meaningful for commands that actually get executed
+    for (DxvkStatCounter ctr : {
+        DxvkStatCounter::CmdDrawCalls,
+        DxvkStatCounter::CmdDispatchCalls,
+        DxvkStatCounter::CmdRenderPassCount,
+        DxvkStatCounter::DescriptorSetCount,
+        DxvkStatCounter::DescriptorSetReused })
+      m_statCounters.addCtr(ctr, cmdList->m_statCounters.getCtr(ctr));
+    
+    m_secondaryLists.push_back(cmdList);
+  }
+  
+  
+  void DxvkCommandList::writeProfilerData() {
+    if (!m_profilerSubmitted)
+      return;
+    
+    DxvkProfilerGpuTimes gpuTimes;
+    
+    // The first and last timestamp enclose the entire command
+    // list, everything in between are render pass begin/end
+    // pairs. Command lists recorded while the profiler was
+    // disabled do not have any timestamps.
+    if (m_timestampCount >= 2) {
+      std::array<uint64_t, DxvkProfiler::MaxTimestamps> timestamps;
+      
+      if (m_timestampPool->getTimestamps(0, m_timestampCount, timestamps.data()) == VK_SUCCESS) {
+        const uint32_t last = m_timestampCount - 1;
+        
+        gpuTimes.gpuTime = timestamps[last] - timestamps[0];
+        
+        for (uint32_t i = 1; i + 1 < last; i += 2) {
+          gpuTimes.gpuRenderPassTime += timestamps[i + 1] - timestamps[i];
+          gpuTimes.renderPassCount   += 1;
+        }
+      }
+    }
+    
+    m_profiler->endSubmission(m_profilerFrameId, gpuTimes);
+    m_profilerSubmitted = false;
+  }
+  
+  
   void DxvkCommandList::reset() {
+    m_timestampCount  = 0;
+    m_timestampRegion = false;
+    
+    m_secondaryLists.clear();
     m_statCounters.reset();
     m_bufferTracker.reset();
     m_eventTracker.reset();
     m_queryTracker.reset();
     m_stagingAlloc.reset();
     m_descAlloc.reset();
+    m_descCache.reset();
     m_resources.reset();
   }
   
   
+  void DxvkCommandList::beginSegment(
+          VkRenderPass            renderPass,
+          VkFramebuffer           framebuffer,
+    const VkRect2D&               renderArea) {
+    const size_t segmentId = m_segments.size();
+    
+    if (segmentId == m_segmentBuffers.size()) {
+      VkCommandBufferAllocateInfo cmdInfo;
+      cmdInfo.sType             = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+      cmdInfo.pNext             = nullptr;
+      cmdInfo.commandPool       = m_pool;
+      cmdInfo.level             = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+      cmdInfo.commandBufferCount = 1;
+      
+      VkCommandBuffer cmdBuffer = VK_NULL_HANDLE;
+      
+      if (m_vkd->vkAllocateCommandBuffers(m_vkd->device(), &cmdInfo, &cmdBuffer) != VK_SUCCESS)
+        throw DxvkError("DxvkCommandList: Failed to allocate command buffer");
+      
+      m_segmentBuffers.push_back(cmdBuffer);
+    }
+    
+    m_buffer = m_segmentBuffers[segmentId];
+    m_segments.push_back({ m_buffer, renderPass, framebuffer, renderArea });
+    
+    // Render pass segments must be compatible with the render pass
+    // that the primary command list begins. Since both use the same
+    // render pass object, created by the device's render pass pool,
+    // this is always the case.
+    VkCommandBufferInheritanceInfo inheritInfo;
+    inheritInfo.sType                 = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritInfo.pNext                 = nullptr;
+    inheritInfo.renderPass            = renderPass;
+    inheritInfo.subpass               = 0;
+    inheritInfo.framebuffer           = framebuffer;
+    inheritInfo.occlusionQueryEnable  = VK_FALSE;
+    inheritInfo.queryFlags            = 0;
+    inheritInfo.pipelineStatistics    = 0;
+    
+    // The command list may be executed again before
+    // a previous submission using it has completed
+    VkCommandBufferBeginInfo info;
+    info.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    info.pNext            = nullptr;
+    info.flags            = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+    info.pInheritanceInfo = &inheritInfo;
+    
+    if (renderPass != VK_NULL_HANDLE)
+      info.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    
+    if (m_vkd->vkBeginCommandBuffer(m_buffer, &info) != VK_SUCCESS)
+      Logger::err("DxvkCommandList: Failed to begin command buffer");
+  }
+  
+  
+  void DxvkCommandList::endSegment() {
+    if (m_vkd->vkEndCommandBuffer(m_buffer) != VK_SUCCESS)
+      Logger::err("DxvkCommandList::endSegment: Failed to record command buffer");
+  }
+  
+  
   DxvkStagingBufferSlice DxvkCommandList::stagedAlloc(VkDeviceSize size) {
     return m_stagingAlloc.alloc(size);
   }
@@ -137,6 +345,44 @@ namespace dxvk {
   }
   
   
+  void DxvkCommandList::beginTimestamps() {
+    if (m_timestampPool == nullptr) {
+      m_timestampPool = new DxvkQueryPool(m_vkd,
+        VK_QUERY_TYPE_TIMESTAMP, DxvkProfiler::MaxTimestamps);
+    }
+    
+    // Timestamps are written at the bottom of the pipe so
+    // that each one waits for all previous work to finish
+    this->cmdResetQueryPool(m_timestampPool->handle(),
+      0, DxvkProfiler::MaxTimestamps);
+    
+    this->cmdWriteTimestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+      m_timestampPool->handle(), m_timestampCount++);
+  }
+  
+  
+  void DxvkCommandList::beginTimestampRegion() {
+    // Keep one query for the end of the command list
+    if (m_timestampCount == 0
+     || m_timestampCount + 3 > DxvkProfiler::MaxTimestamps)
+      return;
+    
+    this->cmdWriteTimestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+      m_timestampPool->handle(), m_timestampCount++);
+    m_timestampRegion = true;
+  }
+  
+  
+  void DxvkCommandList::endTimestampRegion() {
+    if (!m_timestampRegion)
+      return;
+    
+    this->cmdWriteTimestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+      m_timestampPool->handle(), m_timestampCount++);
+    m_timestampRegion = false;
+  }
+  
+  
   void DxvkCommandList::stagedBufferImageCopy(
           VkImage                 dstImage,
           VkImageLayout           dstImageLayout,
@@ -9,6 +9,8 @@
 #include "dxvk_lifetime.h"
 #include "dxvk_limits.h"
 #include "dxvk_pipelayout.h"
+#include "dxvk_profiler.h"
+#include "dxvk_query_pool.h"
 #include "dxvk_query_tracker.h"
 #include "dxvk_staging.h"
 #include "dxvk_stats.h"
@@ -16,6 +18,26 @@
 
 namespace dxvk {
   
+  /**
+   * \brief Command list segment
+   * 
+   * Secondary command lists are split into one Vulkan
+   * command buffer per render pass instance, and one
+   * command buffer for each sequence of commands that
+   * are recorded outside of a render pass. This is
+   * necessary because render passes can only be begun
+   * in primary command buffers.
+   */
+  struct DxvkCommandListSegment {
+    VkCommandBuffer cmdBuffer;
+    VkRenderPass    renderPass;
+    VkFramebuffer   framebuffer;
+    VkRect2D        renderArea;
+    uint32_t        clearValueCount;
+    std::array<VkClearValue, MaxNumRenderTargets + 1> clearValues;
+  };
+  
+  
   /**
    * \brief DXVK command list
    * 
@@ -24,17 +46,30 @@ namespace dxvk {
    * used by the recorded commands for automatic lifetime tracking.
    * When the command list has completed execution, resources that
    * are no longer used may get destroyed.
+   * 
+   * Secondary command lists cannot be submitted directly. Instead,
+   * they are recorded once and can then be executed any number of
+   * times from a primary command list via \ref cmdExecuteCommands.
    */
   class DxvkCommandList : public RcObject {
     
   public:
     
     DxvkCommandList(
-      const Rc<vk::DeviceFn>& vkd,
-            DxvkDevice*       device,
-            uint32_t          queueFamily);
+      const Rc<vk::DeviceFn>&     vkd,
+            DxvkDevice*           device,
+            uint32_t              queueFamily,
+            VkCommandBufferLevel  level);
     ~DxvkCommandList();
     
+    /**
+     * \brief Checks whether this is a secondary command list
+     * \returns \c true for secondary command lists
+     */
+    bool isSecondary() const {
+      return m_level == VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    }
+    
     /**
      * \brief Submits command list
      * 
@@ -57,6 +92,27 @@ namespace dxvk {
      */
     VkResult synchronize();
     
+    /**
+     * \brief Submission sequence number
+     * 
+     * Assigned by the device when the command
+     * list gets submitted to the device queue.
+     * \returns Sequence number
+     */
+    uint64_t sequenceNumber() const {
+      return m_sequence;
+    }
+    
+    /**
+     * \brief Sets submission sequence number
+     * 
+     * Also stores the sequence number in all resources
+     * used by this command list, including resources
+     * used by executed secondary command lists.
+     * \param [in] sequence Sequence number
+     */
+    void setSequenceNumber(uint64_t sequence);
+    
     /**
      * \brief Stat counters
      * 
@@ -153,6 +209,9 @@ namespace dxvk {
      */
     void signalEvents() {
       m_eventTracker.signalEvents();
+      
+      for (const auto& cmdList : m_secondaryLists)
+        cmdList->signalEvents();
     }
     
     /**
@@ -164,8 +223,34 @@ namespace dxvk {
      */
     void writeQueryData() {
       m_queryTracker.writeQueryData();
+      
+      for (const auto& cmdList : m_secondaryLists)
+        cmdList->writeQueryData();
     }
     
+    /**
+     * \brief Sets profiler frame
+     * 
+     * Called by the device when submitting the command
+     * list while the profiler is enabled. GPU timings
+     * will be added to the given frame.
+     * \param [in] frameId Profiler frame number
+     */
+    void setProfilerFrameId(uint64_t frameId) {
+      m_profilerFrameId    = frameId;
+      m_profilerSubmitted  = true;
+    }
+    
+    /**
+     * \brief Writes back profiler data
+     * 
+     * Reads back the timestamps written for the profiler
+     * and adds the GPU timings to the frame during which
+     * the command list was submitted. Call this after
+     * synchronizing with a fence for this command list.
+     */
+    void writeProfilerData();
+    
     /**
      * \brief Resets the command list
      * 
@@ -181,6 +266,49 @@ namespace dxvk {
       return m_descAlloc.alloc(descriptorLayout);
     }
     
+    /**
+     * \brief Looks up a descriptor set
+     * 
+     * Finds a descriptor set with the given contents that
+     * was written earlier during recording. Such sets can
+     * be bound again without having to allocate a new set.
+     * \param [in] descriptorLayout Descriptor set layout
+     * \param [in] descriptorCount Number of descriptors
+     * \param [in] descriptorInfos Descriptor infos
+     * \param [in] hash Hash of the descriptor infos
+     * \returns Matching descriptor set, or \c VK_NULL_HANDLE
+     */
+    VkDescriptorSet findDescriptorSet(
+            VkDescriptorSetLayout   descriptorLayout,
+            uint32_t                descriptorCount,
+      const DxvkDescriptorInfo*     descriptorInfos,
+            size_t                  hash) const {
+      return m_descCache.find(descriptorLayout,
+        descriptorCount, descriptorInfos, hash);
+    }
+    
+    /**
+     * \brief Adds a descriptor set to the cache
+     * 
+     * The set must have been allocated from this command
+     * list and must not be updated after this call.
+     * \param [in] descriptorLayout Descriptor set layout
+     * \param [in] descriptorCount Number of descriptors
+     * \param [in] descriptorInfos Descriptor infos
+     * \param [in] hash Hash of the descriptor infos
+     * \param [in] descriptorSet The descriptor set
+     */
+    void cacheDescriptorSet(
+            VkDescriptorSetLayout   descriptorLayout,
+            uint32_t                descriptorCount,
+      const DxvkDescriptorInfo*     descriptorInfos,
+            size_t                  hash,
+            VkDescriptorSet         descriptorSet) {
+      m_descCache.insert(descriptorLayout,
+        descriptorCount, descriptorInfos,
+        hash, descriptorSet);
+    }
+    
     
     void updateDescriptorSets(
             uint32_t                      descriptorWriteCount,
@@ -211,10 +339,7 @@ namespace dxvk {
     
     void cmdBeginRenderPass(
       const VkRenderPassBeginInfo*  pRenderPassBegin,
-            VkSubpassContents       contents) {
-      m_vkd->vkCmdBeginRenderPass(m_buffer,
-        pRenderPassBegin, contents);
-    }
+            VkSubpassContents       contents);
     
     
     void cmdBindDescriptorSet(
@@ -420,9 +545,11 @@ namespace dxvk {
     }
     
     
-    void cmdEndRenderPass() {
-      m_vkd->vkCmdEndRenderPass(m_buffer);
-    }
+    void cmdEndRenderPass();
+    
+    
+    void cmdExecuteCommands(
+      const Rc<DxvkCommandList>&    cmdList);
     
     
     void cmdFillBuffer(
@@ -558,19 +685,46 @@ namespace dxvk {
     
     Rc<vk::DeviceFn>    m_vkd;
     
+    VkCommandBufferLevel m_level;
     VkFence             m_fence;
+    uint64_t            m_sequence = 0;
     
     VkCommandPool       m_pool;
-    VkCommandBuffer     m_buffer;
+    VkCommandBuffer     m_buffer = VK_NULL_HANDLE;
+    
+    std::vector<VkCommandBuffer>        m_segmentBuffers;
+    std::vector<DxvkCommandListSegment> m_segments;
+    std::vector<Rc<DxvkCommandList>>    m_secondaryLists;
     
     DxvkLifetimeTracker m_resources;
     DxvkDescriptorAlloc m_descAlloc;
+    DxvkDescriptorSetCache m_descCache;
     DxvkStagingAlloc    m_stagingAlloc;
     DxvkQueryTracker    m_queryTracker;
     DxvkEventTracker    m_eventTracker;
     DxvkBufferTracker   m_bufferTracker;
     DxvkStatCounters    m_statCounters;
     
+    Rc<DxvkProfiler>    m_profiler;
+    Rc<DxvkQueryPool>   m_timestampPool;
+    uint32_t            m_timestampCount    = 0;
+    bool                m_timestampRegion   = false;
+    uint64_t            m_profilerFrameId   = 0;
+    bool                m_profilerSubmitted = false;
+    
+    void beginSegment(
+            VkRenderPass            renderPass,
+            VkFramebuffer           framebuffer,
+      const VkRect2D&               renderArea);
+    
+    void endSegment();
+    
+    void beginTimestamps();
+    
+    void beginTimestampRegion();
+    
+    void endTimestampRegion();
+    
   };
   
 }
\ No newline at end of file
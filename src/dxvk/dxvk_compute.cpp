@@ -106,7 +106,7 @@ namespace dxvk {
     
     auto t1 = std::chrono::high_resolution_clock::now();
     auto td = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0);
-    Logger::debug(str::format("DxvkComputePipeline: Finished in ", td.count(), " ms"));
+    Logger::debugf("DxvkComputePipeline: Finished in ", td.count(), " ms");
     return pipeline;
   }
   
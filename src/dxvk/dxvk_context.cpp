@@ -31,15 +31,7 @@ namespace dxvk {
     m_flags.clr(
       DxvkContextFlag::GpRenderPassBound);
     
-    m_flags.set(
-      DxvkContextFlag::GpDirtyPipeline,
-      DxvkContextFlag::GpDirtyPipelineState,
-      DxvkContextFlag::GpDirtyResources,
-      DxvkContextFlag::GpDirtyVertexBuffers,
-      DxvkContextFlag::GpDirtyIndexBuffer,
-      DxvkContextFlag::CpDirtyPipeline,
-      DxvkContextFlag::CpDirtyPipelineState,
-      DxvkContextFlag::CpDirtyResources);
+    this->invalidateState();
     
     // Restart queries that were active during
     // the last command buffer submission.
@@ -51,6 +43,8 @@ namespace dxvk {
     this->renderPassEnd();
     this->endActiveQueries();
     
+    m_barriers.recordCommands(m_cmd);
+    
     this->trackQueryPool(m_queryPools[VK_QUERY_TYPE_OCCLUSION]);
     this->trackQueryPool(m_queryPools[VK_QUERY_TYPE_PIPELINE_STATISTICS]);
     this->trackQueryPool(m_queryPools[VK_QUERY_TYPE_TIMESTAMP]);
@@ -87,7 +81,12 @@ namespace dxvk {
   
   void DxvkContext::bindFramebuffer(const Rc<DxvkFramebuffer>& fb) {
     if (m_state.om.framebuffer != fb) {
-      this->renderPassEnd();
+      // Keep pending clears around so that they can be
+      // folded into the next render pass that uses them
+      if (m_flags.test(DxvkContextFlag::GpRenderPassBound)) {
+        m_flags.clr(DxvkContextFlag::GpRenderPassBound);
+        this->renderPassUnbindFramebuffer();
+      }
       
       if (fb != nullptr) {
         m_state.gp.state.msSampleCount = fb->sampleCount();
@@ -178,6 +177,89 @@ namespace dxvk {
   }
   
   
+  void DxvkContext::bindResourceBuffers(
+          uint32_t              startSlot,
+          uint32_t              count,
+          DxvkBufferSlice*      buffers,
+          bool                  consume) {
+    bool dirty = false;
+    
+    for (uint32_t i = 0; i < count; i++) {
+      DxvkShaderResourceSlot& rc = m_rc[startSlot + i];
+      
+      if (!rc.bufferSlice.matches(buffers[i])) {
+        rc.sampler     = nullptr;
+        rc.imageView   = nullptr;
+        rc.bufferView  = nullptr;
+        rc.bufferSlice = consume ? std::move(buffers[i]) : buffers[i];
+        dirty = true;
+      }
+    }
+    
+    if (dirty) {
+      m_flags.set(
+        DxvkContextFlag::CpDirtyResources,
+        DxvkContextFlag::GpDirtyResources);
+    }
+  }
+  
+  
+  void DxvkContext::bindResourceViews(
+          uint32_t              startSlot,
+          uint32_t              count,
+          Rc<DxvkImageView>*    imageViews,
+          Rc<DxvkBufferView>*   bufferViews,
+          bool                  consume) {
+    bool dirty = false;
+    
+    for (uint32_t i = 0; i < count; i++) {
+      DxvkShaderResourceSlot& rc = m_rc[startSlot + i];
+      
+      if (rc.imageView  != imageViews[i]
+       || rc.bufferView != bufferViews[i]) {
+        rc.sampler     = nullptr;
+        rc.imageView   = consume ? std::move(imageViews [i]) : imageViews [i];
+        rc.bufferView  = consume ? std::move(bufferViews[i]) : bufferViews[i];
+        rc.bufferSlice = DxvkBufferSlice();
+        dirty = true;
+      }
+    }
+    
+    if (dirty) {
+      m_flags.set(
+        DxvkContextFlag::CpDirtyResources,
+        DxvkContextFlag::GpDirtyResources);
+    }
+  }
+  
+  
+  void DxvkContext::bindResourceSamplers(
+          uint32_t              startSlot,
+          uint32_t              count,
+          Rc<DxvkSampler>*      samplers,
+          bool                  consume) {
+    bool dirty = false;
+    
+    for (uint32_t i = 0; i < count; i++) {
+      DxvkShaderResourceSlot& rc = m_rc[startSlot + i];
+      
+      if (rc.sampler != samplers[i]) {
+        rc.sampler     = consume ? std::move(samplers[i]) : samplers[i];
+        rc.imageView   = nullptr;
+        rc.bufferView  = nullptr;
+        rc.bufferSlice = DxvkBufferSlice();
+        dirty = true;
+      }
+    }
+    
+    if (dirty) {
+      m_flags.set(
+        DxvkContextFlag::CpDirtyResources,
+        DxvkContextFlag::GpDirtyResources);
+    }
+  }
+  
+  
   void DxvkContext::bindShader(
           VkShaderStageFlagBits stage,
     const Rc<DxvkShader>&       shader) {
@@ -236,6 +318,9 @@ namespace dxvk {
     
     auto slice = buffer->subSlice(offset, length);
     
+    if (m_barriers.isBufferDirty(slice, DxvkResourceAccessType::Write))
+      m_barriers.recordCommands(m_cmd);
+    
     m_cmd->cmdFillBuffer(
       slice.handle(),
       slice.offset(),
@@ -247,7 +332,6 @@ namespace dxvk {
       VK_ACCESS_TRANSFER_WRITE_BIT,
       buffer->info().stages,
       buffer->info().access);
-    m_barriers.recordCommands(m_cmd);
     
     m_cmd->trackResource(slice.resource());
   }
@@ -293,6 +377,9 @@ namespace dxvk {
     VkExtent3D workgroups = util::computeBlockCount(
       pushArgs.extent, pipeInfo.workgroupSize);
     
+    if (m_barriers.isBufferDirty(bufferView->physicalSlice(), DxvkResourceAccessType::Write))
+      m_barriers.recordCommands(m_cmd);
+    
     m_cmd->cmdBindPipeline(
       VK_PIPELINE_BIND_POINT_COMPUTE,
       pipeInfo.pipeline);
@@ -314,7 +401,6 @@ namespace dxvk {
       VK_ACCESS_SHADER_WRITE_BIT,
       bufferView->bufferInfo().stages,
       bufferView->bufferInfo().access);
-    m_barriers.recordCommands(m_cmd);
     
     m_cmd->trackResource(bufferView->viewResource());
     m_cmd->trackResource(bufferView->bufferResource());
@@ -327,6 +413,9 @@ namespace dxvk {
     const VkImageSubresourceRange&  subresources) {
     this->renderPassEnd();
     
+    if (m_barriers.isImageDirty(image, subresources, DxvkResourceAccessType::Write))
+      m_barriers.recordCommands(m_cmd);
+    
     m_barriers.accessImage(image, subresources,
       VK_IMAGE_LAYOUT_UNDEFINED,
       image->info().stages,
@@ -347,7 +436,6 @@ namespace dxvk {
       image->info().layout,
       image->info().stages,
       image->info().access);
-    m_barriers.recordCommands(m_cmd);
     
     m_cmd->trackResource(image);
   }
@@ -359,6 +447,9 @@ namespace dxvk {
     const VkImageSubresourceRange&  subresources) {
     this->renderPassEnd();
     
+    if (m_barriers.isImageDirty(image, subresources, DxvkResourceAccessType::Write))
+      m_barriers.recordCommands(m_cmd);
+    
     m_barriers.accessImage(
       image, subresources,
       VK_IMAGE_LAYOUT_UNDEFINED,
@@ -381,7 +472,6 @@ namespace dxvk {
       image->info().layout,
       image->info().stages,
       image->info().access);
-    m_barriers.recordCommands(m_cmd);
     
     m_cmd->trackResource(image);
   }
@@ -400,6 +490,33 @@ namespace dxvk {
     if (m_state.om.framebuffer != nullptr)
       attachmentIndex = m_state.om.framebuffer->findAttachment(imageView);
     
+    // Clears that cover the entire view can be performed by the
+    // next render pass that uses the view, unless the view is an
+    // attachment of the render pass that is currently active.
+    const VkExtent3D viewExtent = imageView->mipLevelExtent(0);
+    
+    const bool isFullClear = clearRect.rect.offset.x      == 0
+                          && clearRect.rect.offset.y      == 0
+                          && clearRect.rect.extent.width  == viewExtent.width
+                          && clearRect.rect.extent.height == viewExtent.height
+                          && clearRect.baseArrayLayer     == 0
+                          && clearRect.layerCount         == imageView->info().numLayers;
+    
+    const bool isActiveAttachment = attachmentIndex != MaxNumRenderTargets
+      && m_flags.test(DxvkContextFlag::GpRenderPassBound);
+    
+    if (isFullClear && !isActiveAttachment) {
+      // Ending the render pass normally would flush
+      // the clears that we are trying to accumulate
+      if (m_flags.test(DxvkContextFlag::GpRenderPassBound)) {
+        m_flags.clr(DxvkContextFlag::GpRenderPassBound);
+        this->renderPassUnbindFramebuffer();
+      }
+      
+      this->deferClear(imageView, clearAspects, clearValue);
+      return;
+    }
+    
     if (attachmentIndex == MaxNumRenderTargets) {
       this->renderPassEnd();
       
@@ -415,7 +532,8 @@ namespace dxvk {
       }
       
       this->renderPassBindFramebuffer(
-        m_device->createFramebuffer(attachments));
+        m_device->createFramebuffer(attachments),
+        DxvkRenderPassOps(), 0, nullptr);
     } else {
       // Make sure that the currently bound
       // framebuffer can be rendered to
@@ -441,6 +559,18 @@ namespace dxvk {
   }
   
   
+  void DxvkContext::discardRenderTarget(
+    const Rc<DxvkImageView>&    imageView,
+          VkImageAspectFlags    discardAspects) {
+    // We cannot change the load ops of a render pass that has
+    // already begun, and ending it would defeat the purpose.
+    if (m_flags.test(DxvkContextFlag::GpRenderPassBound))
+      return;
+    
+    this->deferDiscard(imageView, discardAspects);
+  }
+  
+  
   void DxvkContext::clearImageView(
     const Rc<DxvkImageView>&    imageView,
           VkOffset3D            offset,
@@ -489,6 +619,9 @@ namespace dxvk {
     else if (imageView->type() == VK_IMAGE_VIEW_TYPE_2D_ARRAY)
       workgroups.depth = imageView->subresources().layerCount;
     
+    if (m_barriers.isImageDirty(imageView->image(), imageView->subresources(), DxvkResourceAccessType::Write))
+      m_barriers.recordCommands(m_cmd);
+    
     m_cmd->cmdBindPipeline(
       VK_PIPELINE_BIND_POINT_COMPUTE,
       pipeInfo.pipeline);
@@ -513,7 +646,6 @@ namespace dxvk {
       imageView->imageInfo().layout,
       imageView->imageInfo().stages,
       imageView->imageInfo().access);
-    m_barriers.recordCommands(m_cmd);
     
     m_cmd->trackResource(imageView);
     m_cmd->trackResource(imageView->image());
@@ -533,6 +665,10 @@ namespace dxvk {
     
     auto dstSlice = dstBuffer->subSlice(dstOffset, numBytes);
     auto srcSlice = srcBuffer->subSlice(srcOffset, numBytes);
+    
+    if (m_barriers.isBufferDirty(srcSlice, DxvkResourceAccessType::Read)
+     || m_barriers.isBufferDirty(dstSlice, DxvkResourceAccessType::Write))
+      m_barriers.recordCommands(m_cmd);
 
     VkBufferCopy bufferRegion;
     bufferRegion.srcOffset = srcSlice.offset();
@@ -556,8 +692,6 @@ namespace dxvk {
       dstBuffer->info().stages,
       dstBuffer->info().access);
 
-    m_barriers.recordCommands(m_cmd);
-
     m_cmd->trackResource(dstBuffer->resource());
     m_cmd->trackResource(srcBuffer->resource());
   }
@@ -581,6 +715,12 @@ namespace dxvk {
       dstSubresource.baseArrayLayer,
       dstSubresource.layerCount };
     
+    // Pending transitions must be executed before we
+    // can change the layout again, everything else
+    // is recorded together with the layout change.
+    if (m_barriers.isImageDirty(dstImage, dstSubresourceRange, DxvkResourceAccessType::Write))
+      m_barriers.recordCommands(m_cmd);
+    
     m_barriers.accessImage(
       dstImage, dstSubresourceRange,
       dstImage->mipLevelExtent(dstSubresource.mipLevel) == dstExtent
@@ -620,7 +760,6 @@ namespace dxvk {
       VK_ACCESS_TRANSFER_READ_BIT,
       srcBuffer->info().stages,
       srcBuffer->info().access);
-    m_barriers.recordCommands(m_cmd);
     
     m_cmd->trackResource(dstImage);
     m_cmd->trackResource(srcSlice.resource());
@@ -649,6 +788,10 @@ namespace dxvk {
       srcSubresource.baseArrayLayer,
       srcSubresource.layerCount };
     
+    if (m_barriers.isImageDirty(dstImage, dstSubresourceRange, DxvkResourceAccessType::Write)
+     || m_barriers.isImageDirty(srcImage, srcSubresourceRange, DxvkResourceAccessType::Read))
+      m_barriers.recordCommands(m_cmd);
+    
     m_barriers.accessImage(
       dstImage, dstSubresourceRange,
       dstImage->mipLevelExtent(dstSubresource.mipLevel) == extent
@@ -752,7 +895,6 @@ namespace dxvk {
       srcImage->info().layout,
       srcImage->info().stages,
       srcImage->info().access);
-    m_barriers.recordCommands(m_cmd);
     
     m_cmd->trackResource(dstImage);
     m_cmd->trackResource(srcImage);
@@ -777,6 +919,9 @@ namespace dxvk {
       srcSubresource.baseArrayLayer,
       srcSubresource.layerCount };
     
+    if (m_barriers.isImageDirty(srcImage, srcSubresourceRange, DxvkResourceAccessType::Read))
+      m_barriers.recordCommands(m_cmd);
+    
     m_barriers.accessImage(
       srcImage, srcSubresourceRange,
       srcImage->info().layout,
@@ -814,7 +959,6 @@ namespace dxvk {
       VK_ACCESS_TRANSFER_WRITE_BIT,
       dstBuffer->info().stages,
       dstBuffer->info().access);
-    m_barriers.recordCommands(m_cmd);
     
     m_cmd->trackResource(srcImage);
     m_cmd->trackResource(dstSlice.resource());
@@ -828,9 +972,11 @@ namespace dxvk {
     this->commitComputeState();
     
     if (this->validateComputeState()) {
+      this->commitComputeInitBarriers();
+      
       m_cmd->cmdDispatch(x, y, z);
       
-      this->commitComputeBarriers();
+      this->commitComputePostBarriers();
     }
     
     m_cmd->addStatCtr(DxvkStatCounter::CmdDispatchCalls, 1);
@@ -844,11 +990,16 @@ namespace dxvk {
     auto physicalSlice = buffer.physicalSlice();
     
     if (this->validateComputeState()) {
+      this->commitComputeInitBarriers();
+      
+      if (m_barriers.isBufferDirty(physicalSlice, DxvkResourceAccessType::Read))
+        m_barriers.recordCommands(m_cmd);
+      
       m_cmd->cmdDispatchIndirect(
         physicalSlice.handle(),
         physicalSlice.offset());
       
-      this->commitComputeBarriers();
+      this->commitComputePostBarriers();
     }
     
     m_cmd->addStatCtr(DxvkStatCounter::CmdDispatchCalls, 1);
@@ -929,6 +1080,43 @@ namespace dxvk {
   }
   
   
+  void DxvkContext::executeCommandList(
+    const Rc<DxvkCommandList>&  cmdList) {
+    this->renderPassEnd();
+    
+    // Secondary command buffers can only inherit active
+    // queries if the inheritedQueries feature is enabled
+    // and the query type is declared at record time.
+    this->endActiveQueries();
+    
+    m_barriers.recordCommands(m_cmd);
+    
+    VkMemoryBarrier barrier;
+    barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.pNext         = nullptr;
+    barrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    
+    m_cmd->cmdPipelineBarrier(
+      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+      0, 1, &barrier, 0, nullptr, 0, nullptr);
+    
+    m_cmd->cmdExecuteCommands(cmdList);
+    
+    m_cmd->cmdPipelineBarrier(
+      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+      0, 1, &barrier, 0, nullptr, 0, nullptr);
+    
+    this->beginActiveQueries();
+    
+    // The secondary command list leaves the
+    // bound pipeline and resources undefined
+    this->invalidateState();
+  }
+  
+  
   void DxvkContext::initImage(
     const Rc<DxvkImage>&           image,
     const VkImageSubresourceRange& subresources) {
@@ -951,6 +1139,9 @@ namespace dxvk {
       return;
     
     this->renderPassEnd();
+    
+    if (m_barriers.isImageDirty(image, subresources, DxvkResourceAccessType::Write))
+      m_barriers.recordCommands(m_cmd);
 
     // The top-most level will only be read. We can
     // discard the contents of all the lower levels
@@ -1061,7 +1252,7 @@ namespace dxvk {
       image->info().stages,
       image->info().access);
     
-    m_barriers.recordCommands(m_cmd);
+    m_cmd->trackResource(image);
   }
   
   
@@ -1118,6 +1309,10 @@ namespace dxvk {
         srcSubresources.baseArrayLayer,
         srcSubresources.layerCount };
       
+      if (m_barriers.isImageDirty(dstImage, dstSubresourceRange, DxvkResourceAccessType::Write)
+       || m_barriers.isImageDirty(srcImage, srcSubresourceRange, DxvkResourceAccessType::Read))
+        m_barriers.recordCommands(m_cmd);
+      
       // We only support resolving to the entire image
       // area, so we might as well discard its contents
       m_barriers.accessImage(
@@ -1168,7 +1363,6 @@ namespace dxvk {
         srcImage->info().layout,
         srcImage->info().stages,
         srcImage->info().access);
-      m_barriers.recordCommands(m_cmd);
     } else {
       // The trick here is to submit an empty render pass which
       // performs the resolve op on properly typed image views.
@@ -1188,6 +1382,8 @@ namespace dxvk {
       info.clearValueCount  = 0;
       info.pClearValues     = nullptr;
       
+      m_barriers.recordCommands(m_cmd);
+      
       m_cmd->cmdBeginRenderPass(&info, VK_SUBPASS_CONTENTS_INLINE);
       m_cmd->cmdEndRenderPass();
       
@@ -1213,6 +1409,9 @@ namespace dxvk {
     // reasonably small, we do not know how much data apps may upload.
     auto physicalSlice = buffer->subSlice(offset, size);
     
+    if (m_barriers.isBufferDirty(physicalSlice, DxvkResourceAccessType::Write))
+      m_barriers.recordCommands(m_cmd);
+    
     if ((size <= 4096) && ((size & 0x3) == 0) && ((offset & 0x3) == 0)) {
       m_cmd->cmdUpdateBuffer(
         physicalSlice.handle(),
@@ -1236,7 +1435,6 @@ namespace dxvk {
       VK_ACCESS_TRANSFER_WRITE_BIT,
       buffer->info().stages,
       buffer->info().access);
-    m_barriers.recordCommands(m_cmd);
 
     m_cmd->trackResource(buffer->resource());
   }
@@ -1273,7 +1471,8 @@ namespace dxvk {
     
     util::packImageData(dstData, srcData,
       elementCount, formatInfo->elementSize,
-      pitchPerRow, pitchPerLayer);
+      pitchPerRow, pitchPerLayer,
+      util::CopyTarget::WriteCombined);
     
     // Prepare the image layout. If the given extent covers
     // the entire image, we may discard its previous contents.
@@ -1284,6 +1483,9 @@ namespace dxvk {
     subresourceRange.baseArrayLayer = subresources.baseArrayLayer;
     subresourceRange.layerCount     = subresources.layerCount;
     
+    if (m_barriers.isImageDirty(image, subresourceRange, DxvkResourceAccessType::Write))
+      m_barriers.recordCommands(m_cmd);
+    
     m_barriers.accessImage(
       image, subresourceRange,
       image->mipLevelExtent(subresources.mipLevel) == imageExtent
@@ -1311,7 +1513,8 @@ namespace dxvk {
       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
       region, slice);
     
-    // Transition image back into its optimal layout
+    // Transition image back into its optimal layout. This
+    // is recorded once the image actually gets used again.
     m_barriers.accessImage(
       image, subresourceRange,
       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
@@ -1320,7 +1523,6 @@ namespace dxvk {
       image->info().layout,
       image->info().stages,
       image->info().access);
-    m_barriers.recordCommands(m_cmd);
     
     m_cmd->trackResource(image);
   }
@@ -1490,11 +1692,47 @@ namespace dxvk {
   }
   
   
+  void DxvkContext::invalidateState() {
+    m_flags.set(
+      DxvkContextFlag::GpDirtyPipeline,
+      DxvkContextFlag::GpDirtyPipelineState,
+      DxvkContextFlag::GpDirtyResources,
+      DxvkContextFlag::GpDirtyVertexBuffers,
+      DxvkContextFlag::GpDirtyIndexBuffer,
+      DxvkContextFlag::CpDirtyPipeline,
+      DxvkContextFlag::CpDirtyPipelineState,
+      DxvkContextFlag::CpDirtyResources);
+  }
+  
+  
   void DxvkContext::renderPassBegin() {
-    if (!m_flags.test(DxvkContextFlag::GpRenderPassBound)
-     && (m_state.om.framebuffer != nullptr)) {
+    if (m_flags.test(DxvkContextFlag::GpRenderPassBound))
+      return;
+    
+    DxvkRenderPassOps ops;
+    
+    std::array<VkClearValue, MaxNumRenderTargets + 1> clearValues;
+    uint32_t clearValueCount = 0;
+    
+    // Pending clears of the attachments are performed by the
+    // render pass itself. All other clears must be executed
+    // before the render pass begins since draws may read
+    // the cleared images.
+    if (m_state.om.framebuffer != nullptr) {
+      clearValueCount = this->foldDeferredClears(
+        m_state.om.framebuffer, ops, clearValues.data());
+    }
+    
+    this->flushDeferredClears();
+    
+    if (m_state.om.framebuffer != nullptr) {
       m_flags.set(DxvkContextFlag::GpRenderPassBound);
-      this->renderPassBindFramebuffer(m_state.om.framebuffer);
+      this->renderPassBindFramebuffer(m_state.om.framebuffer,
+        ops, clearValueCount, clearValues.data());
+      
+      // Storage resources that remain bound may
+      // be written again during this render pass
+      m_flags.set(DxvkContextFlag::GpDirtyBarriers);
     }
   }
   
@@ -1504,10 +1742,18 @@ namespace dxvk {
       m_flags.clr(DxvkContextFlag::GpRenderPassBound);
       this->renderPassUnbindFramebuffer();
     }
+    
+    // Subsequent commands may access images
+    // with pending clears, so execute them
+    this->flushDeferredClears();
   }
   
   
-  void DxvkContext::renderPassBindFramebuffer(const Rc<DxvkFramebuffer>& framebuffer) {
+  void DxvkContext::renderPassBindFramebuffer(
+    const Rc<DxvkFramebuffer>&  framebuffer,
+    const DxvkRenderPassOps&    ops,
+          uint32_t              clearValueCount,
+    const VkClearValue*         clearValues) {
     const DxvkFramebufferSize fbSize = framebuffer->size();
     
     VkRect2D renderArea;
@@ -1517,21 +1763,191 @@ namespace dxvk {
     VkRenderPassBeginInfo info;
     info.sType                = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     info.pNext                = nullptr;
-    info.renderPass           = framebuffer->renderPass();
+    info.renderPass           = framebuffer->renderPass(ops);
     info.framebuffer          = framebuffer->handle();
     info.renderArea           = renderArea;
-    info.clearValueCount      = 0;
-    info.pClearValues         = nullptr;
+    info.clearValueCount      = clearValueCount;
+    info.pClearValues         = clearValues;
+    
+    // Barriers cannot be recorded inside the render pass,
+    // and any of the pending ones may affect its draws
+    m_barriers.recordCommands(m_cmd);
     
     m_cmd->cmdBeginRenderPass(&info,
       VK_SUBPASS_CONTENTS_INLINE);
     m_cmd->trackResource(framebuffer);
     m_cmd->addStatCtr(DxvkStatCounter::CmdRenderPassCount, 1);
+    
+    // Secondary command lists record each render pass
+    // instance into a new command buffer, which does
+    // not inherit any state from the previous one.
+    if (m_cmd->isSecondary())
+      this->invalidateState();
   }
   
   
   void DxvkContext::renderPassUnbindFramebuffer() {
     m_cmd->cmdEndRenderPass();
+    
+    if (m_cmd->isSecondary())
+      this->invalidateState();
+  }
+  
+  
+  void DxvkContext::deferClear(
+    const Rc<DxvkImageView>&    imageView,
+          VkImageAspectFlags    clearAspects,
+    const VkClearValue&         clearValue) {
+    DxvkDeferredClear* entry = this->findDeferredClear(imageView);
+    
+    entry->clearAspects   |=  clearAspects;
+    entry->discardAspects &= ~clearAspects;
+    
+    if (clearAspects & VK_IMAGE_ASPECT_COLOR_BIT)
+      entry->clearValue.color = clearValue.color;
+    
+    if (clearAspects & VK_IMAGE_ASPECT_DEPTH_BIT)
+      entry->clearValue.depthStencil.depth = clearValue.depthStencil.depth;
+    
+    if (clearAspects & VK_IMAGE_ASPECT_STENCIL_BIT)
+      entry->clearValue.depthStencil.stencil = clearValue.depthStencil.stencil;
+  }
+  
+  
+  void DxvkContext::deferDiscard(
+    const Rc<DxvkImageView>&    imageView,
+          VkImageAspectFlags    discardAspects) {
+    DxvkDeferredClear* entry = this->findDeferredClear(imageView);
+    
+    entry->clearAspects   &= ~discardAspects;
+    entry->discardAspects |=  discardAspects;
+  }
+  
+  
+  DxvkDeferredClear* DxvkContext::findDeferredClear(
+    const Rc<DxvkImageView>&    imageView) {
+    auto& clears = m_state.om.deferredClears;
+    
+    for (auto& entry : clears) {
+      if (entry.imageView == imageView)
+        return &entry;
+    }
+    
+    // Clears on different views of the same image may overlap,
+    // so we must not reorder them by folding only one of them.
+    for (const auto& entry : clears) {
+      if (entry.imageView->image() == imageView->image()) {
+        this->flushDeferredClears();
+        break;
+      }
+    }
+    
+    DxvkDeferredClear entry;
+    entry.imageView      = imageView;
+    entry.discardAspects = ~imageFormatInfo(imageView->info().format)->aspectMask;
+    
+    clears.push_back(entry);
+    return &clears.back();
+  }
+  
+  
+  uint32_t DxvkContext::foldDeferredClears(
+    const Rc<DxvkFramebuffer>&  framebuffer,
+          DxvkRenderPassOps&    ops,
+          VkClearValue*         clearValues) {
+    auto& clears = m_state.om.deferredClears;
+    
+    auto getLoadOp = [] (const DxvkDeferredClear& clear, VkImageAspectFlags aspect) {
+      if (clear.clearAspects & aspect)
+        return VK_ATTACHMENT_LOAD_OP_CLEAR;
+      
+      return (clear.discardAspects & aspect)
+        ? VK_ATTACHMENT_LOAD_OP_DONT_CARE
+        : VK_ATTACHMENT_LOAD_OP_LOAD;
+    };
+    
+    // Attachments and clear values are in framebuffer
+    // order, i.e. depth first, then all color targets.
+    auto foldClear = [&] (const Rc<DxvkImageView>& view, VkClearValue& clearValue) {
+      clearValue = VkClearValue();
+      
+      for (auto entry = clears.begin(); entry != clears.end(); entry++) {
+        if (entry->imageView == view) {
+          DxvkDeferredClear clear = *entry;
+          clears.erase(entry);
+          clearValue = clear.clearValue;
+          return clear;
+        }
+      }
+      
+      return DxvkDeferredClear();
+    };
+    
+    const DxvkRenderTargets& targets = framebuffer->renderTargets();
+    uint32_t attachmentCount = 0;
+    
+    if (clears.size() == 0)
+      return attachmentCount;
+    
+    const Rc<DxvkImageView> depthView = targets.getDepthTarget().view;
+    
+    if (depthView != nullptr) {
+      DxvkDeferredClear clear = foldClear(depthView, clearValues[attachmentCount++]);
+      ops.depthOps  .loadOp = getLoadOp(clear, VK_IMAGE_ASPECT_DEPTH_BIT);
+      ops.stencilOps.loadOp = getLoadOp(clear, VK_IMAGE_ASPECT_STENCIL_BIT);
+    }
+    
+    for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
+      const Rc<DxvkImageView> colorView = targets.getColorTarget(i).view;
+      
+      if (colorView != nullptr) {
+        DxvkDeferredClear clear = foldClear(colorView, clearValues[attachmentCount++]);
+        ops.colorOps[i].loadOp = getLoadOp(clear, VK_IMAGE_ASPECT_COLOR_BIT);
+      }
+    }
+    
+    return attachmentCount;
+  }
+  
+  
+  void DxvkContext::flushDeferredClears() {
+    auto& clears = m_state.om.deferredClears;
+    
+    // Discarded views do not need to be
+    // touched, but clears must be executed
+    for (const auto& clear : clears) {
+      if (clear.clearAspects == 0)
+        continue;
+      
+      DxvkRenderTargets attachments;
+      DxvkRenderPassOps ops;
+      
+      if (clear.clearAspects & VK_IMAGE_ASPECT_COLOR_BIT) {
+        attachments.setColorTarget(0, clear.imageView,
+          VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+        ops.colorOps[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+      } else {
+        attachments.setDepthTarget(clear.imageView,
+          VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+        
+        if (clear.clearAspects & VK_IMAGE_ASPECT_DEPTH_BIT)
+          ops.depthOps.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        else if (clear.discardAspects & VK_IMAGE_ASPECT_DEPTH_BIT)
+          ops.depthOps.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        
+        if (clear.clearAspects & VK_IMAGE_ASPECT_STENCIL_BIT)
+          ops.stencilOps.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        else if (clear.discardAspects & VK_IMAGE_ASPECT_STENCIL_BIT)
+          ops.stencilOps.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+      }
+      
+      this->renderPassBindFramebuffer(
+        m_device->createFramebuffer(attachments),
+        ops, 1, &clear.clearValue);
+      this->renderPassUnbindFramebuffer();
+    }
+    
+    clears.clear();
   }
   
   
@@ -1608,10 +2024,18 @@ namespace dxvk {
       for (uint32_t i = m_state.gp.state.ilBindingCount; i < MaxNumVertexBindings; i++)
         m_state.gp.state.ilBindings[i].stride = 0;
       
+      bool pending = false;
+      
       m_gpActivePipeline = m_state.gp.pipeline != nullptr
-        ? m_state.gp.pipeline->getPipelineHandle(m_state.gp.state, m_cmd->statCounters())
+        ? m_state.gp.pipeline->getPipelineHandle(m_state.gp.state,
+            m_cmd->statCounters(), !m_cmd->isSecondary(), pending)
         : VK_NULL_HANDLE;
       
+      // If the pipeline is still being compiled in the
+      // background, check again on the next draw call
+      if (pending)
+        m_flags.set(DxvkContextFlag::GpDirtyPipelineState);
+      
       if (m_gpActivePipeline != VK_NULL_HANDLE) {
         m_cmd->cmdBindPipeline(
           VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -1658,6 +2082,8 @@ namespace dxvk {
   
   void DxvkContext::updateGraphicsShaderResources() {
     if (m_flags.test(DxvkContextFlag::GpDirtyResources)) {
+      m_flags.set(DxvkContextFlag::GpDirtyBarriers);
+      
       if (m_state.gp.pipeline != nullptr) {
         this->updateShaderResources(
           VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -1700,6 +2126,10 @@ namespace dxvk {
       const auto& binding = layout->binding(i);
       const auto& res     = m_rc[binding.slot];
       
+      // Clear bytes not used by the descriptor so that identical
+      // bindings can be matched by the descriptor set cache
+      m_descInfos[i] = DxvkDescriptorInfo();
+      
       switch (binding.type) {
         case VK_DESCRIPTOR_TYPE_SAMPLER:
           if (res.sampler != nullptr) {
@@ -1784,13 +2214,32 @@ namespace dxvk {
     const DxvkBindingState&       bindingState,
     const Rc<DxvkPipelineLayout>& layout) {
     if (layout->bindingCount() != 0) {
-      const VkDescriptorSet dset =
-        m_cmd->allocateDescriptorSet(
+      // Reuse a descriptor set written earlier in this command
+      // list if the descriptors are the same, which is common
+      // when a draw-heavy application rebinds the same state
+      const size_t hash = DxvkDescriptorSetCache::hash(
+        layout->bindingCount(), m_descInfos.data());
+      
+      VkDescriptorSet dset = m_cmd->findDescriptorSet(
+        layout->descriptorSetLayout(), layout->bindingCount(),
+        m_descInfos.data(), hash);
+      
+      if (dset == VK_NULL_HANDLE) {
+        dset = m_cmd->allocateDescriptorSet(
           layout->descriptorSetLayout());
-      
-      m_cmd->updateDescriptorSetWithTemplate(
-        dset, layout->descriptorTemplate(),
-        m_descInfos.data());
+        
+        m_cmd->updateDescriptorSetWithTemplate(
+          dset, layout->descriptorTemplate(),
+          m_descInfos.data());
+        
+        m_cmd->cacheDescriptorSet(
+          layout->descriptorSetLayout(), layout->bindingCount(),
+          m_descInfos.data(), hash, dset);
+        
+        m_cmd->addStatCtr(DxvkStatCounter::DescriptorSetCount, 1);
+      } else {
+        m_cmd->addStatCtr(DxvkStatCounter::DescriptorSetReused, 1);
+      }
       
       m_cmd->cmdBindDescriptorSet(bindPoint,
         layout->pipelineLayout(), dset);
@@ -1888,53 +2337,171 @@ namespace dxvk {
     this->updateGraphicsShaderResources();
     this->updateGraphicsPipelineState();
     this->updateGraphicsShaderDescriptors();
+    this->commitGraphicsPostBarriers();
   }
   
   
-  void DxvkContext::commitComputeBarriers() {
-    // TODO optimize. Each pipeline layout should
-    // hold a list of resource that can be written.
-    // TODO generalize so that this can be used for
-    // graphics pipelines as well
+  void DxvkContext::commitComputeInitBarriers() {
+    if (!m_barriers.isPending())
+      return;
+    
     auto layout = m_state.cp.pipeline->layout();
     
-    for (uint32_t i = 0; i < layout->bindingCount(); i++) {
+    bool requiresBarrier = false;
+    
+    for (uint32_t i = 0; i < layout->bindingCount() && !requiresBarrier; i++) {
       if (m_state.cp.state.bsBindingState.isBound(i)) {
         const DxvkDescriptorSlot binding = layout->binding(i);
         const DxvkShaderResourceSlot& slot = m_rc[binding.slot];
         
-        if (binding.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) {
-          m_barriers.accessBuffer(
-            slot.bufferSlice.physicalSlice(),
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-            VK_ACCESS_SHADER_READ_BIT | 
-            VK_ACCESS_SHADER_WRITE_BIT,
-            slot.bufferSlice.bufferInfo().stages,
-            slot.bufferSlice.bufferInfo().access);
-        } else if (binding.type == VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER) {
-          m_barriers.accessBuffer(
-            slot.bufferView->physicalSlice(),
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-            VK_ACCESS_SHADER_READ_BIT | 
-            VK_ACCESS_SHADER_WRITE_BIT,
-            slot.bufferView->bufferInfo().stages,
-            slot.bufferView->bufferInfo().access);
-        } else if (binding.type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE) {
-          m_barriers.accessImage(
-            slot.imageView->image(),
-            slot.imageView->subresources(),
-            slot.imageView->imageInfo().layout,
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-            VK_ACCESS_SHADER_READ_BIT | 
-            VK_ACCESS_SHADER_WRITE_BIT,
-            slot.imageView->imageInfo().layout,
-            slot.imageView->imageInfo().stages,
-            slot.imageView->imageInfo().access);
+        DxvkResourceAccessTypes access = DxvkResourceAccessType::Read;
+        
+        switch (binding.type) {
+          case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+            access.set(DxvkResourceAccessType::Write);
+            /* fall through */
+          
+          case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+            requiresBarrier = m_barriers.isBufferDirty(
+              slot.bufferSlice.physicalSlice(), access);
+            break;
+          
+          case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+            access.set(DxvkResourceAccessType::Write);
+            /* fall through */
+          
+          case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+            requiresBarrier = m_barriers.isBufferDirty(
+              slot.bufferView->physicalSlice(), access);
+            break;
+          
+          case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+            access.set(DxvkResourceAccessType::Write);
+            /* fall through */
+          
+          case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+            requiresBarrier = m_barriers.isImageDirty(
+              slot.imageView->image(),
+              slot.imageView->subresources(), access);
+            break;
+          
+          default:
+            break;
         }
       }
     }
     
-    m_barriers.recordCommands(m_cmd);
+    if (requiresBarrier)
+      m_barriers.recordCommands(m_cmd);
+  }
+  
+  
+  void DxvkContext::commitComputePostBarriers() {
+    this->trackShaderResourceAccess(
+      m_state.cp.pipeline->layout(),
+      m_state.cp.state.bsBindingState,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      false);
+  }
+  
+  
+  void DxvkContext::commitGraphicsPostBarriers() {
+    if (m_flags.test(DxvkContextFlag::GpDirtyBarriers)) {
+      m_flags.clr(DxvkContextFlag::GpDirtyBarriers);
+      
+      // Barriers for these are recorded once the render pass
+      // has ended, and only read-write resources need one. We
+      // do not know which stage writes them, so use all.
+      if (m_state.gp.pipeline != nullptr) {
+        this->trackShaderResourceAccess(
+          m_state.gp.pipeline->layout(),
+          m_state.gp.state.bsBindingState,
+          VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT,
+          true);
+      }
+    }
+  }
+  
+  
+  void DxvkContext::trackShaderResourceAccess(
+    const Rc<DxvkPipelineLayout>& layout,
+    const DxvkBindingState&       bindingState,
+          VkPipelineStageFlags    stages,
+          bool                    storageOnly) {
+    for (uint32_t i = 0; i < layout->bindingCount(); i++) {
+      if (bindingState.isBound(i)) {
+        const DxvkDescriptorSlot binding = layout->binding(i);
+        const DxvkShaderResourceSlot& slot = m_rc[binding.slot];
+        
+        const VkAccessFlags storageAccess
+          = VK_ACCESS_SHADER_READ_BIT
+          | VK_ACCESS_SHADER_WRITE_BIT;
+        
+        switch (binding.type) {
+          case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+            m_barriers.accessBuffer(
+              slot.bufferSlice.physicalSlice(),
+              stages, storageAccess,
+              slot.bufferSlice.bufferInfo().stages,
+              slot.bufferSlice.bufferInfo().access);
+            break;
+          
+          case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+            m_barriers.accessBuffer(
+              slot.bufferView->physicalSlice(),
+              stages, storageAccess,
+              slot.bufferView->bufferInfo().stages,
+              slot.bufferView->bufferInfo().access);
+            break;
+          
+          case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+            m_barriers.accessImage(
+              slot.imageView->image(),
+              slot.imageView->subresources(),
+              slot.imageView->imageInfo().layout,
+              stages, storageAccess,
+              slot.imageView->imageInfo().layout,
+              slot.imageView->imageInfo().stages,
+              slot.imageView->imageInfo().access);
+            break;
+          
+          // Read-only resources do not need a barrier, but
+          // writes must not be reordered with the reads.
+          case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+            if (!storageOnly) {
+              m_barriers.accessBuffer(
+                slot.bufferSlice.physicalSlice(),
+                stages, VK_ACCESS_UNIFORM_READ_BIT,
+                slot.bufferSlice.bufferInfo().stages,
+                slot.bufferSlice.bufferInfo().access);
+            } break;
+          
+          case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+            if (!storageOnly) {
+              m_barriers.accessBuffer(
+                slot.bufferView->physicalSlice(),
+                stages, VK_ACCESS_SHADER_READ_BIT,
+                slot.bufferView->bufferInfo().stages,
+                slot.bufferView->bufferInfo().access);
+            } break;
+          
+          case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+            if (!storageOnly) {
+              m_barriers.accessImage(
+                slot.imageView->image(),
+                slot.imageView->subresources(),
+                slot.imageView->imageInfo().layout,
+                stages, VK_ACCESS_SHADER_READ_BIT,
+                slot.imageView->imageInfo().layout,
+                slot.imageView->imageInfo().stages,
+                slot.imageView->imageInfo().access);
+            } break;
+          
+          default:
+            break;
+        }
+      }
+    }
   }
   
   
@@ -139,6 +139,61 @@ namespace dxvk {
             uint32_t              slot,
       const Rc<DxvkSampler>&      sampler);
     
+    /**
+     * \brief Binds a range of buffers
+     * 
+     * Equivalent to calling \ref bindResourceBuffer
+     * for each slot in the given range. If \c consume
+     * is set, the buffer slices are moved out of the
+     * array instead of being copied, which saves one
+     * reference count update per buffer.
+     * \param [in] startSlot First resource binding slot
+     * \param [in] count Number of slots to bind
+     * \param [in] buffers Buffers to bind
+     * \param [in] consume Whether to move the buffers
+     */
+    void bindResourceBuffers(
+            uint32_t              startSlot,
+            uint32_t              count,
+            DxvkBufferSlice*      buffers,
+            bool                  consume);
+    
+    /**
+     * \brief Binds a range of image or buffer views
+     * 
+     * Equivalent to calling \ref bindResourceView
+     * for each slot in the given range. If \c consume
+     * is set, the views are moved out of the arrays.
+     * \param [in] startSlot First resource binding slot
+     * \param [in] count Number of slots to bind
+     * \param [in] imageViews Image views to bind
+     * \param [in] bufferViews Buffer views to bind
+     * \param [in] consume Whether to move the views
+     */
+    void bindResourceViews(
+            uint32_t              startSlot,
+            uint32_t              count,
+            Rc<DxvkImageView>*    imageViews,
+            Rc<DxvkBufferView>*   bufferViews,
+            bool                  consume);
+    
+    /**
+     * \brief Binds a range of image samplers
+     * 
+     * Equivalent to calling \ref bindResourceSampler
+     * for each slot in the given range. If \c consume
+     * is set, the samplers are moved out of the array.
+     * \param [in] startSlot First resource binding slot
+     * \param [in] count Number of slots to bind
+     * \param [in] samplers Samplers to bind
+     * \param [in] consume Whether to move the samplers
+     */
+    void bindResourceSamplers(
+            uint32_t              startSlot,
+            uint32_t              count,
+            Rc<DxvkSampler>*      samplers,
+            bool                  consume);
+    
     /**
      * \brief Binds a shader to a given state
      * 
@@ -221,6 +276,9 @@ namespace dxvk {
     /**
      * \brief Clears an active render target
      * 
+     * Clears that cover the entire view are deferred
+     * until the next render pass that uses the view
+     * begins, where they are performed via load ops.
      * \param [in] imageView Render target view to clear
      * \param [in] clearArea Image area to clear
      * \param [in] clearAspects Image aspects to clear
@@ -232,6 +290,20 @@ namespace dxvk {
             VkImageAspectFlags    clearAspects,
       const VkClearValue&         clearValue);
     
+    /**
+     * \brief Discards a render target
+     * 
+     * Marks the contents of the given image view as
+     * undefined, so that the next render pass that
+     * uses the view does not need to load them. This
+     * is only a hint and may be ignored.
+     * \param [in] imageView Render target view to discard
+     * \param [in] discardAspects Image aspects to discard
+     */
+    void discardRenderTarget(
+      const Rc<DxvkImageView>&    imageView,
+            VkImageAspectFlags    discardAspects);
+    
     /**
      * \brief Clears an image view
      * 
@@ -405,6 +477,22 @@ namespace dxvk {
             uint32_t          count,
             uint32_t          stride);
     
+    /**
+     * \brief Executes a secondary command list
+     * 
+     * Executes commands that were recorded into a secondary
+     * command list by another context. Since that context
+     * cannot know about the commands recorded here, this
+     * inserts full memory barriers before and after the
+     * secondary command list, and invalidates all state.
+     * 
+     * Queries that are active on this context will not
+     * include results from the secondary command list.
+     * \param [in] cmdList The secondary command list
+     */
+    void executeCommandList(
+      const Rc<DxvkCommandList>&  cmdList);
+    
     /**
      * \brief Generates mip maps
      * 
@@ -632,13 +720,37 @@ namespace dxvk {
     std::array<DxvkShaderResourceSlot, MaxNumResourceSlots>  m_rc;
     std::array<DxvkDescriptorInfo,     MaxNumActiveBindings> m_descInfos;
     
+    void invalidateState();
+    
     void renderPassBegin();
     void renderPassEnd();
     
     void renderPassBindFramebuffer(
-      const Rc<DxvkFramebuffer>& framebuffer);
+      const Rc<DxvkFramebuffer>&  framebuffer,
+      const DxvkRenderPassOps&    ops,
+            uint32_t              clearValueCount,
+      const VkClearValue*         clearValues);
     void renderPassUnbindFramebuffer();
     
+    void deferClear(
+      const Rc<DxvkImageView>&    imageView,
+            VkImageAspectFlags    clearAspects,
+      const VkClearValue&         clearValue);
+    
+    void deferDiscard(
+      const Rc<DxvkImageView>&    imageView,
+            VkImageAspectFlags    discardAspects);
+    
+    DxvkDeferredClear* findDeferredClear(
+      const Rc<DxvkImageView>&    imageView);
+    
+    uint32_t foldDeferredClears(
+      const Rc<DxvkFramebuffer>&  framebuffer,
+            DxvkRenderPassOps&    ops,
+            VkClearValue*         clearValues);
+    
+    void flushDeferredClears();
+    
     void unbindComputePipeline();
     
     void updateComputePipeline();
@@ -675,7 +787,16 @@ namespace dxvk {
     void commitComputeState();
     void commitGraphicsState();
     
-    void commitComputeBarriers();
+    void commitComputeInitBarriers();
+    void commitComputePostBarriers();
+    
+    void commitGraphicsPostBarriers();
+    
+    void trackShaderResourceAccess(
+      const Rc<DxvkPipelineLayout>& layout,
+      const DxvkBindingState&       bindingState,
+            VkPipelineStageFlags    stages,
+            bool                    storageOnly);
     
     DxvkQueryHandle allocQuery(
       const DxvkQueryRevision& query);
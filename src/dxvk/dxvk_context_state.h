@@ -27,6 +27,7 @@ namespace dxvk {
     GpDirtyResources,           ///< Graphics pipeline resource bindings are out of date
     GpDirtyVertexBuffers,       ///< Vertex buffer bindings are out of date
     GpDirtyIndexBuffer,         ///< Index buffer binding are out of date
+    GpDirtyBarriers,            ///< Graphics storage resource accesses are not tracked
     
     CpDirtyPipeline,            ///< Compute pipeline binding are out of date
     CpDirtyPipelineState,       ///< Compute pipeline needs to be recompiled
@@ -52,11 +53,28 @@ namespace dxvk {
   };
   
   
+  /**
+   * \brief Deferred clear
+   * 
+   * A clear or discard of an entire image view that
+   * has not been executed yet. Aspects that are not
+   * part of the view's format count as discarded.
+   */
+  struct DxvkDeferredClear {
+    Rc<DxvkImageView>   imageView;
+    VkImageAspectFlags  clearAspects    = 0;
+    VkImageAspectFlags  discardAspects  = 0;
+    VkClearValue        clearValue      = { };
+  };
+  
+  
   struct DxvkOutputMergerState {
     Rc<DxvkFramebuffer> framebuffer       = nullptr;
     
     DxvkBlendConstants  blendConstants    = { 0.0f, 0.0f, 0.0f, 0.0f };
     uint32_t            stencilReference  = 0;
+    
+    std::vector<DxvkDeferredClear> deferredClears;
   };
   
   
@@ -1,29 +1,55 @@
+#include <cstdlib>
+
 #include "dxvk_cs.h"
 
 namespace dxvk {
   
-  DxvkCsChunk::DxvkCsChunk() {
-    
+  DxvkCsChunk::DxvkCsChunk(size_t size)
+  : m_size(size),
+    m_data(static_cast<char*>(::operator new(size, std::align_val_t(64)))) {
+      
   }
   
   
   DxvkCsChunk::~DxvkCsChunk() {
+    this->reset();
+    
+    ::operator delete(m_data, std::align_val_t(64));
+  }
+  
+  
+  void DxvkCsChunk::executeAll(DxvkContext* ctx) {
     auto cmd = m_head;
     
+    if (!m_flags.test(DxvkCsChunkFlag::SingleUse)) {
+      while (cmd != nullptr) {
+        cmd->exec(ctx);
+        cmd = cmd->next();
+      }
+      
+      return;
+    }
+    
     while (cmd != nullptr) {
       auto next = cmd->next();
+      cmd->exec(ctx);
       cmd->~DxvkCsCmd();
       cmd = next;
     }
+    
+    m_commandCount  = 0;
+    m_commandOffset = 0;
+    
+    m_head = nullptr;
+    m_tail = nullptr;
   }
   
   
-  void DxvkCsChunk::executeAll(DxvkContext* ctx) {
+  void DxvkCsChunk::reset() {
     auto cmd = m_head;
     
     while (cmd != nullptr) {
       auto next = cmd->next();
-      cmd->exec(ctx);
       cmd->~DxvkCsCmd();
       cmd = next;
     }
@@ -36,68 +62,170 @@ namespace dxvk {
   }
   
   
-  DxvkCsThread::DxvkCsThread(const Rc<DxvkContext>& context)
-  : m_context(context), m_thread([this] { threadFunc(); }) {
+  DxvkCsChunkPool::DxvkCsChunkPool(size_t chunkSize)
+  : m_chunkSize(chunkSize) {
+    
+  }
+  
+  
+  DxvkCsChunkPool::~DxvkCsChunkPool() {
+    for (DxvkCsChunk* chunk : m_chunks)
+      delete chunk;
+  }
+  
+  
+  DxvkCsChunkRef DxvkCsChunkPool::allocChunk(DxvkCsChunkFlags flags) {
+    DxvkCsChunk* chunk = nullptr;
+    
+    { std::lock_guard<std::mutex> lock(m_mutex);
+    
+      if (!m_chunks.empty()) {
+        chunk = m_chunks.back();
+        m_chunks.pop_back();
+      }
+    }
+    
+    if (chunk == nullptr)
+      chunk = new DxvkCsChunk(m_chunkSize);
+    
+    chunk->init(flags);
+    return DxvkCsChunkRef(chunk, this);
+  }
+  
+  
+  void DxvkCsChunkPool::freeChunk(DxvkCsChunk* chunk) {
+    chunk->reset();
+    
+    { std::lock_guard<std::mutex> lock(m_mutex);
+    
+      if (m_chunks.size() < MaxPooledChunks) {
+        m_chunks.push_back(chunk);
+        return;
+      }
+    }
+    
+    delete chunk;
+  }
+  
+  
+  size_t DxvkCsChunkPool::getChunkSizeFromEnv(
+    const wchar_t*  name,
+          size_t    defaultSize) {
+    const std::string value = env::getEnvVar(name);
+    
+    if (value.empty())
+      return defaultSize;
+    
+    // Chunks must be large enough to hold the largest command
+    // that any context may record, which is well below 4 kB.
+    const size_t size = std::strtoul(value.c_str(), nullptr, 10) * 1024;
+    return std::min<size_t>(std::max<size_t>(size, 4096), 1 << 20);
+  }
+  
+  
+  DxvkCsThread::DxvkCsThread(
+    const Rc<DxvkContext>&  context,
+    const Rc<DxvkProfiler>& profiler)
+  : m_context(context), m_profiler(profiler),
+    m_thread([this] { threadFunc(); }) {
     
   }
   
   
   DxvkCsThread::~DxvkCsThread() {
+    m_stopped.store(true);
+    
     { std::unique_lock<std::mutex> lock(m_mutex);
-      m_stopped.store(true);
+      m_condOnAdd.notify_one();
     }
     
-    m_condOnAdd.notify_one();
     m_thread.join();
   }
   
   
-  void DxvkCsThread::dispatchChunk(Rc<DxvkCsChunk>&& chunk) {
-    { std::unique_lock<std::mutex> lock(m_mutex);
-      m_chunksQueued.push(std::move(chunk));
-      m_chunksPending += 1;
-    }
+  void DxvkCsThread::dispatchChunk(DxvkCsChunkRef&& chunk) {
+    const uint32_t queued = m_chunksQueued.load(std::memory_order_relaxed);
     
-    m_condOnAdd.notify_one();
+    // Wait for the consumer to free up a slot
+    this->waitFor(m_producerWaiting, m_condOnExec, [this, queued] {
+      return queued - m_chunksExecuted.load() < MaxChunksInFlight;
+    });
+    
+    m_chunks[queued % MaxChunksInFlight] = std::move(chunk);
+    m_chunksQueued.store(queued + 1);
+    
+    this->notify(m_consumerWaiting, m_condOnAdd);
   }
   
   
   void DxvkCsThread::synchronize() {
-    std::unique_lock<std::mutex> lock(m_mutex);
+    const uint32_t queued = m_chunksQueued.load(std::memory_order_relaxed);
     
-    m_condOnSync.wait(lock, [this] {
-      return m_chunksPending == 0;
+    this->waitFor(m_producerWaiting, m_condOnExec, [this, queued] {
+      return m_chunksExecuted.load() == queued;
     });
   }
   
   
+  template<typename Pred>
+  void DxvkCsThread::waitFor(
+          std::atomic<bool>&        waiting,
+          std::condition_variable&  cond,
+    const Pred&                     pred) {
+    for (uint32_t i = 0; i < SpinCount; i++) {
+      if (pred())
+        return;
+    }
+    
+    // The waiting flag and the ring indices are accessed with
+    // sequentially consistent ordering, so that either the
+    // other side sees the flag, or we see the new index.
+    std::unique_lock<std::mutex> lock(m_mutex);
+    waiting.store(true);
+    cond.wait(lock, pred);
+    waiting.store(false);
+  }
+  
+  
+  void DxvkCsThread::notify(
+          std::atomic<bool>&        waiting,
+          std::condition_variable&  cond) {
+    if (waiting.load()) {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      cond.notify_one();
+    }
+  }
+  
+  
   void DxvkCsThread::threadFunc() {
-    Rc<DxvkCsChunk> chunk;
-    
-    while (!m_stopped.load()) {
-      { std::unique_lock<std::mutex> lock(m_mutex);
-        if (chunk != nullptr) {
-          if (--m_chunksPending == 0)
-            m_condOnSync.notify_one();
-          
-          chunk = nullptr;
-        }
-        
-        if (m_chunksQueued.size() == 0) {
-          m_condOnAdd.wait(lock, [this] {
-            return (m_chunksQueued.size() != 0)
-                || (m_stopped.load());
-          });
-        }
+    uint32_t executed = 0;
+    
+    while (true) {
+      this->waitFor(m_consumerWaiting, m_condOnAdd, [this, executed] {
+        return m_chunksQueued.load() != executed
+            || m_stopped.load();
+      });
+      
+      if (m_chunksQueued.load() == executed)
+        break;
+      
+      DxvkCsChunkRef chunk = std::move(m_chunks[executed % MaxChunksInFlight]);
+      
+      if (m_profiler != nullptr && m_profiler->isEnabled()) {
+        auto t0 = DxvkProfiler::Clock::now();
+        chunk->executeAll(m_context.ptr());
+        auto t1 = DxvkProfiler::Clock::now();
         
-        if (m_chunksQueued.size() != 0) {
-          chunk = std::move(m_chunksQueued.front());
-          m_chunksQueued.pop();
-        }
+        m_profiler->addCpuTime(DxvkProfilerStage::CsThread, t1 - t0);
+      } else {
+        chunk->executeAll(m_context.ptr());
       }
       
-      if (chunk != nullptr)
-        chunk->executeAll(m_context.ptr());
+      chunk = DxvkCsChunkRef();
+      
+      m_chunksExecuted.store(++executed);
+      
+      this->notify(m_producerWaiting, m_condOnExec);
     }
   }
   
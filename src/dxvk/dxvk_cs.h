@@ -1,10 +1,11 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
-#include <queue>
 #include <thread>
+#include <vector>
 
 #include "dxvk_context.h"
 
@@ -43,9 +44,13 @@ namespace dxvk {
     
     /**
      * \brief Executes embedded commands
+     * 
+     * Commands recorded into single-use chunks are
+     * executed exactly once, so they may move their
+     * arguments into the context instead of copying.
      * \param [in] ctx The target context
      */
-    virtual void exec(DxvkContext* ctx) const = 0;
+    virtual void exec(DxvkContext* ctx) = 0;
     
   private:
     
@@ -71,7 +76,7 @@ namespace dxvk {
     DxvkCsTypedCmd             (DxvkCsTypedCmd&&) = delete;
     DxvkCsTypedCmd& operator = (DxvkCsTypedCmd&&) = delete;
     
-    void exec(DxvkContext* ctx) const {
+    void exec(DxvkContext* ctx) {
       m_command(ctx);
     }
     
@@ -82,18 +87,45 @@ namespace dxvk {
   };
   
   
+  /**
+   * \brief Command chunk flags
+   */
+  enum class DxvkCsChunkFlag : uint32_t {
+    /// Commands are destroyed as soon as they have been
+    /// executed. Chunks without this flag can be executed
+    /// any number of times, and their commands are only
+    /// destroyed when the chunk is returned to its pool.
+    SingleUse,
+  };
+  
+  using DxvkCsChunkFlags = Flags<DxvkCsChunkFlag>;
+  
+  
   /**
    * \brief Command chunk
    * 
-   * Stores a list of commands.
+   * Stores a list of commands. Chunks are allocated
+   * from a \ref DxvkCsChunkPool and returned to it
+   * once the last reference runs out of scope.
    */
   class DxvkCsChunk : public RcObject {
-    constexpr static size_t MaxBlockSize = 16384;
+    
   public:
     
-    DxvkCsChunk();
+    DxvkCsChunk(size_t size);
     ~DxvkCsChunk();
     
+    DxvkCsChunk             (const DxvkCsChunk&) = delete;
+    DxvkCsChunk& operator = (const DxvkCsChunk&) = delete;
+    
+    /**
+     * \brief Size of the command buffer
+     * \returns Size of the command buffer, in bytes
+     */
+    size_t size() const {
+      return m_size;
+    }
+    
     /**
      * \brief Number of commands recorded to the chunk
      * 
@@ -118,7 +150,7 @@ namespace dxvk {
     bool push(T& command) {
       using FuncType = DxvkCsTypedCmd<T>;
       
-      if (m_commandOffset + sizeof(FuncType) > MaxBlockSize)
+      if (m_commandOffset + sizeof(FuncType) > m_size)
         return false;
       
       DxvkCsCmd* tail = m_tail;
@@ -136,25 +168,204 @@ namespace dxvk {
       return true;
     }
     
+    /**
+     * \brief Initializes chunk for recording
+     * \param [in] flags Chunk flags
+     */
+    void init(DxvkCsChunkFlags flags) {
+      m_flags = flags;
+    }
+    
     /**
      * \brief Executes all commands
      * 
-     * This will also reset the chunk
-     * so that it can be reused.
+     * If the chunk is marked as single-use, this will
+     * also reset the chunk so that it can be reused.
+     * Otherwise, the commands are kept so that the
+     * chunk can be executed again.
      * \param [in] ctx The context
      */
     void executeAll(DxvkContext* ctx);
     
+    /**
+     * \brief Resets the chunk
+     * 
+     * Destroys all commands without
+     * executing them.
+     */
+    void reset();
+    
   private:
     
+    size_t m_size;
     size_t m_commandCount  = 0;
     size_t m_commandOffset = 0;
     
     DxvkCsCmd* m_head = nullptr;
     DxvkCsCmd* m_tail = nullptr;
     
-    alignas(64)
-    char m_data[MaxBlockSize];
+    DxvkCsChunkFlags m_flags;
+    
+    char* m_data;
+    
+  };
+  
+  
+  class DxvkCsChunkRef;
+  
+  
+  /**
+   * \brief Command chunk pool
+   * 
+   * Implements a thread-safe pool of command chunks
+   * of a fixed size. Chunks are allocated by the thread
+   * that records commands and are returned to the pool
+   * by whichever thread drops the last reference, which
+   * usually is the CS thread. This avoids a pair of
+   * large allocations per chunk.
+   */
+  class DxvkCsChunkPool : public RcObject {
+    constexpr static size_t MaxPooledChunks = 64;
+  public:
+    
+    constexpr static size_t DefaultChunkSize          = 16384;
+    constexpr static size_t DefaultDeferredChunkSize  = 65536;
+    
+    DxvkCsChunkPool(size_t chunkSize);
+    ~DxvkCsChunkPool();
+    
+    /**
+     * \brief Size of the chunks in this pool
+     * \returns Chunk size, in bytes
+     */
+    size_t chunkSize() const {
+      return m_chunkSize;
+    }
+    
+    /**
+     * \brief Allocates a chunk
+     * 
+     * Takes an existing chunk from the pool if
+     * possible, or creates a new one otherwise.
+     * \param [in] flags Chunk flags
+     * \returns An empty command chunk
+     */
+    DxvkCsChunkRef allocChunk(DxvkCsChunkFlags flags);
+    
+    /**
+     * \brief Returns a chunk to the pool
+     * 
+     * Called when the last reference to a chunk is
+     * dropped. Resets the chunk, and destroys it if
+     * the pool already holds enough chunks.
+     * \param [in] chunk The chunk to return
+     */
+    void freeChunk(DxvkCsChunk* chunk);
+    
+    /**
+     * \brief Reads chunk size from the environment
+     * 
+     * The given variable specifies the chunk size in
+     * kilobytes. The result is clamped to a sensible
+     * range so that any single command fits a chunk.
+     * \param [in] name Environment variable name
+     * \param [in] defaultSize Default chunk size, in bytes
+     * \returns Chunk size, in bytes
+     */
+    static size_t getChunkSizeFromEnv(
+      const wchar_t*  name,
+            size_t    defaultSize);
+            
+  private:
+    
+    const size_t m_chunkSize;
+    
+    std::mutex                m_mutex;
+    std::vector<DxvkCsChunk*> m_chunks;
+    
+  };
+  
+  
+  /**
+   * \brief Command chunk reference
+   * 
+   * Reference-counted pointer to a command chunk
+   * which returns the chunk to the pool it was
+   * allocated from when the last reference is
+   * dropped, rather than destroying it.
+   */
+  class DxvkCsChunkRef {
+    
+  public:
+    
+    DxvkCsChunkRef() { }
+    DxvkCsChunkRef(
+            DxvkCsChunk*          chunk,
+      const Rc<DxvkCsChunkPool>&  pool)
+    : m_chunk(chunk), m_pool(pool) {
+      this->incRef();
+    }
+    
+    DxvkCsChunkRef(const DxvkCsChunkRef& other)
+    : m_chunk(other.m_chunk), m_pool(other.m_pool) {
+      this->incRef();
+    }
+    
+    DxvkCsChunkRef(DxvkCsChunkRef&& other)
+    : m_chunk(other.m_chunk), m_pool(std::move(other.m_pool)) {
+      other.m_chunk = nullptr;
+    }
+    
+    DxvkCsChunkRef& operator = (const DxvkCsChunkRef& other) {
+      if (other.m_chunk != nullptr)
+        other.m_chunk->incRef();
+      
+      this->decRef();
+      
+      m_chunk = other.m_chunk;
+      m_pool  = other.m_pool;
+      return *this;
+    }
+    
+    DxvkCsChunkRef& operator = (DxvkCsChunkRef&& other) {
+      if (this == &other)
+        return *this;
+      
+      this->decRef();
+      
+      m_chunk = other.m_chunk;
+      m_pool  = std::move(other.m_pool);
+      
+      other.m_chunk = nullptr;
+      return *this;
+    }
+    
+    ~DxvkCsChunkRef() {
+      this->decRef();
+    }
+    
+    DxvkCsChunk* operator -> () const {
+      return m_chunk;
+    }
+    
+    explicit operator bool () const {
+      return m_chunk != nullptr;
+    }
+    
+  private:
+    
+    DxvkCsChunk*        m_chunk = nullptr;
+    Rc<DxvkCsChunkPool> m_pool;
+    
+    void incRef() {
+      if (m_chunk != nullptr)
+        m_chunk->incRef();
+    }
+    
+    void decRef() {
+      if (m_chunk != nullptr && m_chunk->decRef() == 0)
+        m_pool->freeChunk(m_chunk);
+    }
     
   };
   
@@ -164,12 +375,29 @@ namespace dxvk {
    * 
    * Spawns a thread that will execute
    * commands on a DXVK context. 
+   * 
+   * Chunks are passed to the thread through a bounded
+   * lock-free ring buffer. Only one thread may dispatch
+   * chunks or synchronize with the thread at a time.
+   * Both sides spin briefly before going to sleep when
+   * they have to wait for the other side.
    */
   class DxvkCsThread {
-    
+    constexpr static uint32_t MaxChunksInFlight = 256;
+    constexpr static uint32_t SpinCount         = 200;
   public:
     
-    DxvkCsThread(const Rc<DxvkContext>& context);
+    /**
+     * \brief Creates the thread
+     * 
+     * \param [in] context The context
+     * \param [in] profiler (Optional) Profiler to report
+     *    the time spent executing commands to. Should
+     *    only be set for the immediate context.
+     */
+    DxvkCsThread(
+      const Rc<DxvkContext>&  context,
+      const Rc<DxvkProfiler>& profiler = nullptr);
     ~DxvkCsThread();
     
     /**
@@ -179,7 +407,7 @@ namespace dxvk {
      * command lists recorded on another thread.
      * \param [in] chunk The chunk to dispatch
      */
-    void dispatchChunk(Rc<DxvkCsChunk>&& chunk);
+    void dispatchChunk(DxvkCsChunkRef&& chunk);
     
     /**
      * \brief Synchronizes with the thread
@@ -194,15 +422,37 @@ namespace dxvk {
   private:
     
     const Rc<DxvkContext>       m_context;
+    const Rc<DxvkProfiler>      m_profiler;
     
     std::atomic<bool>           m_stopped = { false };
+    
+    // Ring buffer indices. The producer only writes the
+    // number of queued chunks, the consumer only writes
+    // the number of executed chunks. Kept in separate
+    // cache lines to avoid false sharing.
+    alignas(64) std::atomic<uint32_t> m_chunksQueued   = { 0u };
+    alignas(64) std::atomic<uint32_t> m_chunksExecuted = { 0u };
+    
+    alignas(64) std::array<DxvkCsChunkRef, MaxChunksInFlight> m_chunks;
+    
+    // Slow path for when either side has to sleep
+    std::atomic<bool>           m_producerWaiting = { false };
+    std::atomic<bool>           m_consumerWaiting = { false };
     std::mutex                  m_mutex;
     std::condition_variable     m_condOnAdd;
-    std::condition_variable     m_condOnSync;
-    std::queue<Rc<DxvkCsChunk>> m_chunksQueued;
+    std::condition_variable     m_condOnExec;
+    
     std::thread                 m_thread;
     
-    uint32_t                    m_chunksPending = 0;
+    template<typename Pred>
+    void waitFor(
+            std::atomic<bool>&        waiting,
+            std::condition_variable&  cond,
+      const Pred&                     pred);
+    
+    void notify(
+            std::atomic<bool>&        waiting,
+            std::condition_variable&  cond);
     
     void threadFunc();
     
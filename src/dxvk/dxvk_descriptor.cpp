@@ -1,78 +1,174 @@
+#include <cstring>
+
 #include "dxvk_descriptor.h"
+#include "dxvk_device.h"
+#include "dxvk_hash.h"
 
 namespace dxvk {
   
-  DxvkDescriptorAlloc::DxvkDescriptorAlloc(
+  DxvkDescriptorPoolManager::DxvkDescriptorPoolManager(
     const Rc<vk::DeviceFn>& vkd)
   : m_vkd(vkd) {
-    // Allocate one pool right away so that there
-    // is always at least one pool available when
-    // allocating a descriptor set
-    m_pools.push_back(createDescriptorPool());
+    
   }
   
   
-  DxvkDescriptorAlloc::~DxvkDescriptorAlloc() {
-    for (auto p : m_pools) {
-      m_vkd->vkDestroyDescriptorPool(
-        m_vkd->device(), p, nullptr);
+  DxvkDescriptorPoolManager::~DxvkDescriptorPoolManager() {
+    for (const auto& pool : m_idlePools)
+      this->destroyPool(pool);
+  }
+  
+  
+  DxvkDescriptorPool DxvkDescriptorPoolManager::allocPool() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    m_poolsInUse += 1;
+    
+    if (m_idlePools.size() != 0) {
+      DxvkDescriptorPool pool = m_idlePools.back();
+      m_idlePools.pop_back();
+      return pool;
     }
+    
+    m_poolCount += 1;
+    return this->createPool(this->getPoolSize());
   }
   
   
-  VkDescriptorSet DxvkDescriptorAlloc::alloc(VkDescriptorSetLayout layout) {
-    VkDescriptorSet set = allocFrom(m_pools[m_poolId], layout);
+  void DxvkDescriptorPoolManager::recyclePools(
+          uint32_t            poolCount,
+    const DxvkDescriptorPool* pools,
+          uint32_t            setCount) {
+    std::lock_guard<std::mutex> lock(m_mutex);
     
-    if (set == VK_NULL_HANDLE) {
-      if (++m_poolId >= m_pools.size())
-        m_pools.push_back(createDescriptorPool());
+    // Grow immediately if a command list needed more sets than
+    // expected, but only shrink slowly in order to not throw
+    // away pools just because a single command list was small.
+    m_setDemand = setCount > m_setDemand
+      ? setCount : (15 * m_setDemand + setCount) / 16;
+    
+    const uint32_t poolSize = this->getPoolSize();
+    
+    for (uint32_t i = 0; i < poolCount; i++) {
+      const bool keep = pools[i].maxSets >= poolSize
+                     && pools[i].maxSets <= poolSize * 4
+                     && m_idlePools.size() < MaxIdlePools;
       
-      set = allocFrom(m_pools[m_poolId], layout);
+      if (keep) {
+        m_vkd->vkResetDescriptorPool(
+          m_vkd->device(), pools[i].handle, 0);
+        m_idlePools.push_back(pools[i]);
+      } else {
+        this->destroyPool(pools[i]);
+        m_poolCount -= 1;
+      }
     }
     
-    return set;
+    m_poolsInUse -= poolCount;
   }
   
   
-  void DxvkDescriptorAlloc::reset() {
-    for (auto p : m_pools) {
-      m_vkd->vkResetDescriptorPool(
-        m_vkd->device(), p, 0);
-    }
+  DxvkDescriptorPoolStats DxvkDescriptorPoolManager::getStats() {
+    std::lock_guard<std::mutex> lock(m_mutex);
     
-    m_poolId = 0;
+    DxvkDescriptorPoolStats result;
+    result.poolCount   = m_poolCount;
+    result.poolsInUse  = m_poolsInUse;
+    result.poolMaxSets = this->getPoolSize();
+    return result;
   }
   
   
-  VkDescriptorPool DxvkDescriptorAlloc::createDescriptorPool() {
-    constexpr uint32_t MaxSets = 256;
-    constexpr uint32_t MaxDesc = 2048;
+  uint32_t DxvkDescriptorPoolManager::getPoolSize() const {
+    uint32_t result = MinPoolSets;
+    
+    while (result < m_setDemand && result < MaxPoolSets)
+      result *= 2;
+    
+    return result;
+  }
+  
+  
+  DxvkDescriptorPool DxvkDescriptorPoolManager::createPool(
+          uint32_t            maxSets) {
+    const uint32_t maxDesc = maxSets * DescriptorsPerSet;
     
     std::array<VkDescriptorPoolSize, 7> pools = {{
-      { VK_DESCRIPTOR_TYPE_SAMPLER,               MaxDesc },
-      { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,         MaxDesc },
-      { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,         MaxDesc },
-      { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,        MaxDesc },
-      { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,        MaxDesc },
-      { VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER,  MaxDesc },
-      { VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER,  MaxDesc } }};
+      { VK_DESCRIPTOR_TYPE_SAMPLER,               maxDesc },
+      { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,         maxDesc },
+      { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,         maxDesc },
+      { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,        maxDesc },
+      { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,        maxDesc },
+      { VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER,  maxDesc },
+      { VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER,  maxDesc } }};
     
     VkDescriptorPoolCreateInfo info;
     info.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     info.pNext         = nullptr;
     info.flags         = 0;
-    info.maxSets       = MaxSets;
+    info.maxSets       = maxSets;
     info.poolSizeCount = pools.size();
     info.pPoolSizes    = pools.data();
     
-    VkDescriptorPool pool = VK_NULL_HANDLE;
+    DxvkDescriptorPool pool;
+    pool.maxSets = maxSets;
+    
     if (m_vkd->vkCreateDescriptorPool(m_vkd->device(),
-          &info, nullptr, &pool) != VK_SUCCESS)
-      throw DxvkError("DxvkDescriptorAlloc: Failed to create descriptor pool");
+          &info, nullptr, &pool.handle) != VK_SUCCESS)
+      throw DxvkError("DxvkDescriptorPoolManager: Failed to create descriptor pool");
     return pool;
   }
   
   
+  void DxvkDescriptorPoolManager::destroyPool(
+    const DxvkDescriptorPool& pool) {
+    m_vkd->vkDestroyDescriptorPool(
+      m_vkd->device(), pool.handle, nullptr);
+  }
+  
+  
+  DxvkDescriptorAlloc::DxvkDescriptorAlloc(
+          DxvkDevice*           device)
+  : m_device(device), m_vkd(device->vkd()) {
+    
+  }
+  
+  
+  DxvkDescriptorAlloc::~DxvkDescriptorAlloc() {
+    this->reset();
+  }
+  
+  
+  VkDescriptorSet DxvkDescriptorAlloc::alloc(VkDescriptorSetLayout layout) {
+    if (m_pools.size() == 0)
+      m_pools.push_back(m_device->allocDescriptorPool());
+    
+    VkDescriptorSet set = allocFrom(m_pools[m_poolId].handle, layout);
+    
+    if (set == VK_NULL_HANDLE) {
+      if (++m_poolId >= m_pools.size())
+        m_pools.push_back(m_device->allocDescriptorPool());
+      
+      set = allocFrom(m_pools[m_poolId].handle, layout);
+    }
+    
+    m_setCount += 1;
+    return set;
+  }
+  
+  
+  void DxvkDescriptorAlloc::reset() {
+    if (m_pools.size() != 0) {
+      m_device->recycleDescriptorPools(
+        m_pools.size(), m_pools.data(), m_setCount);
+    }
+    
+    m_pools.clear();
+    m_poolId   = 0;
+    m_setCount = 0;
+  }
+  
+  
   VkDescriptorSet DxvkDescriptorAlloc::allocFrom(
           VkDescriptorPool      pool,
           VkDescriptorSetLayout layout) const {
@@ -89,4 +185,74 @@ namespace dxvk {
     return set;
   }
   
-}
\ No newline at end of file
+  
+  DxvkDescriptorSetCache::DxvkDescriptorSetCache() {
+    
+  }
+  
+  
+  DxvkDescriptorSetCache::~DxvkDescriptorSetCache() {
+    
+  }
+  
+  
+  size_t DxvkDescriptorSetCache::hash(
+          uint32_t              count,
+    const DxvkDescriptorInfo*   infos) {
+    // Hash the raw bytes since we do not know which
+    // union member is in use. Bytes not used by the
+    // descriptor only lead to spurious cache misses.
+    const size_t* data = reinterpret_cast<const size_t*>(infos);
+    const size_t  size = count * sizeof(DxvkDescriptorInfo) / sizeof(size_t);
+    
+    DxvkHashState result;
+    
+    for (size_t i = 0; i < size; i++)
+      result.add(data[i]);
+    
+    return result;
+  }
+  
+  
+  VkDescriptorSet DxvkDescriptorSetCache::find(
+          VkDescriptorSetLayout layout,
+          uint32_t              count,
+    const DxvkDescriptorInfo*   infos,
+          size_t                hash) const {
+    auto range = m_entries.equal_range(hash);
+    
+    for (auto e = range.first; e != range.second; e++) {
+      const Entry& entry = e->second;
+      
+      if (entry.layout == layout && entry.infoCount == count
+       && !std::memcmp(&m_infos[entry.infoIndex], infos, count * sizeof(DxvkDescriptorInfo)))
+        return entry.set;
+    }
+    
+    return VK_NULL_HANDLE;
+  }
+  
+  
+  void DxvkDescriptorSetCache::insert(
+          VkDescriptorSetLayout layout,
+          uint32_t              count,
+    const DxvkDescriptorInfo*   infos,
+          size_t                hash,
+          VkDescriptorSet       set) {
+    Entry entry;
+    entry.layout    = layout;
+    entry.set       = set;
+    entry.infoIndex = m_infos.size();
+    entry.infoCount = count;
+    
+    m_infos.insert(m_infos.end(), infos, infos + count);
+    m_entries.insert({ hash, entry });
+  }
+  
+  
+  void DxvkDescriptorSetCache::reset() {
+    m_entries.clear();
+    m_infos.clear();
+  }
+  
+}
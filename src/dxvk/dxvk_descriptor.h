@@ -1,9 +1,15 @@
 #pragma once
 
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 #include "dxvk_include.h"
 
 namespace dxvk {
   
+  class DxvkDevice;
+  
   /**
    * \brief Descriptor info
    * 
@@ -17,18 +23,122 @@ namespace dxvk {
   };
   
   
+  /**
+   * \brief Descriptor pool
+   * 
+   * Stores a descriptor pool handle along with the
+   * number of descriptor sets the pool can hold.
+   */
+  struct DxvkDescriptorPool {
+    VkDescriptorPool handle  = VK_NULL_HANDLE;
+    uint32_t         maxSets = 0;
+  };
+  
+  
+  /**
+   * \brief Descriptor pool stats
+   * 
+   * Reports the number of descriptor pools that
+   * currently exist, how many of them are owned by
+   * command lists, and the number of sets that newly
+   * created pools can hold.
+   */
+  struct DxvkDescriptorPoolStats {
+    uint32_t poolCount   = 0;
+    uint32_t poolsInUse  = 0;
+    uint32_t poolMaxSets = 0;
+  };
+  
+  
+  /**
+   * \brief Descriptor pool manager
+   * 
+   * Creates descriptor pools for all command lists of
+   * a device and recycles them once command lists are
+   * reset. Pools are sized according to the number of
+   * descriptor sets that command lists have recently
+   * allocated, so that a typical command list needs
+   * only one pool. Pools that no longer match that size,
+   * or that are not needed because too many pools are
+   * idle, are destroyed.
+   */
+  class DxvkDescriptorPoolManager : public RcObject {
+    constexpr static uint32_t MinPoolSets       = 64;
+    constexpr static uint32_t MaxPoolSets       = 4096;
+    constexpr static uint32_t DescriptorsPerSet = 8;
+    constexpr static uint32_t MaxIdlePools      = 8;
+  public:
+    
+    DxvkDescriptorPoolManager(
+      const Rc<vk::DeviceFn>& vkd);
+    ~DxvkDescriptorPoolManager();
+    
+    /**
+     * \brief Retrieves a descriptor pool
+     * 
+     * Returns an idle pool if one is available,
+     * or creates a new one otherwise.
+     * \returns The descriptor pool
+     */
+    DxvkDescriptorPool allocPool();
+    
+    /**
+     * \brief Returns descriptor pools
+     * 
+     * Resets the given pools so that they can be
+     * handed out again. None of the descriptor sets
+     * allocated from them may be in use.
+     * \param [in] poolCount Number of pools
+     * \param [in] pools The pools to recycle
+     * \param [in] setCount Number of descriptor sets
+     *    that were allocated from the pools
+     */
+    void recyclePools(
+            uint32_t            poolCount,
+      const DxvkDescriptorPool* pools,
+            uint32_t            setCount);
+    
+    /**
+     * \brief Queries descriptor pool stats
+     * \returns Descriptor pool stats
+     */
+    DxvkDescriptorPoolStats getStats();
+    
+  private:
+    
+    Rc<vk::DeviceFn> m_vkd;
+    
+    std::mutex                      m_mutex;
+    std::vector<DxvkDescriptorPool> m_idlePools;
+    
+    uint32_t m_poolCount  = 0;
+    uint32_t m_poolsInUse = 0;
+    uint32_t m_setDemand  = MinPoolSets;
+    
+    uint32_t getPoolSize() const;
+    
+    DxvkDescriptorPool createPool(
+            uint32_t            maxSets);
+    
+    void destroyPool(
+      const DxvkDescriptorPool& pool);
+    
+  };
+  
+  
   /**
    * \brief Descriptor set allocator
    * 
-   * Creates descriptor pools on demand and
-   * allocates descriptor sets from those pools.
+   * Retrieves descriptor pools from the device on demand
+   * and allocates descriptor sets from those pools. The
+   * pools are returned to the device on reset.
    */
   class DxvkDescriptorAlloc {
     
   public:
     
     DxvkDescriptorAlloc(
-      const Rc<vk::DeviceFn>& vkd);
+            DxvkDevice*           device);
     ~DxvkDescriptorAlloc();
     
     DxvkDescriptorAlloc             (const DxvkDescriptorAlloc&) = delete;
@@ -46,19 +156,19 @@ namespace dxvk {
     /**
      * \brief Resets descriptor set allocator
      * 
-     * Destroys all descriptor sets and
-     * resets the Vulkan descriptor pools.
+     * Destroys all descriptor sets and returns
+     * the descriptor pools to the device.
      */
     void reset();
     
   private:
     
-    Rc<vk::DeviceFn> m_vkd;
-    
-    std::vector<VkDescriptorPool> m_pools;
-    size_t                        m_poolId = 0;
+    DxvkDevice* const m_device;
+    Rc<vk::DeviceFn>  m_vkd;
     
-    VkDescriptorPool createDescriptorPool();
+    std::vector<DxvkDescriptorPool> m_pools;
+    size_t                          m_poolId   = 0;
+    uint32_t                        m_setCount = 0;
     
     VkDescriptorSet allocFrom(
       VkDescriptorPool      pool,
@@ -66,4 +176,85 @@ namespace dxvk {
     
   };
   
+  
+  /**
+   * \brief Descriptor set cache
+   * 
+   * Remembers the contents of descriptor sets that
+   * have been written, so that a set can be reused
+   * if the same descriptors are to be bound again
+   * with the same layout. Sets must not be updated
+   * once they have been added to the cache, and the
+   * cache must be reset along with the allocator
+   * that the sets were allocated from.
+   */
+  class DxvkDescriptorSetCache {
+    
+  public:
+    
+    DxvkDescriptorSetCache();
+    ~DxvkDescriptorSetCache();
+    
+    /**
+     * \brief Computes hash of descriptor infos
+     * 
+     * \param [in] count Number of descriptors
+     * \param [in] infos Descriptor infos
+     * \returns Hash of the descriptor infos
+     */
+    static size_t hash(
+            uint32_t              count,
+      const DxvkDescriptorInfo*   infos);
+    
+    /**
+     * \brief Looks up a descriptor set
+     * 
+     * \param [in] layout Descriptor set layout
+     * \param [in] count Number of descriptors
+     * \param [in] infos Descriptor infos
+     * \param [in] hash Hash of the descriptor infos
+     * \returns Descriptor set with the given contents,
+     *    or \c VK_NULL_HANDLE if there is none.
+     */
+    VkDescriptorSet find(
+            VkDescriptorSetLayout layout,
+            uint32_t              count,
+      const DxvkDescriptorInfo*   infos,
+            size_t                hash) const;
+    
+    /**
+     * \brief Adds a descriptor set to the cache
+     * 
+     * \param [in] layout Descriptor set layout
+     * \param [in] count Number of descriptors
+     * \param [in] infos Descriptor infos
+     * \param [in] hash Hash of the descriptor infos
+     * \param [in] set Descriptor set
+     */
+    void insert(
+            VkDescriptorSetLayout layout,
+            uint32_t              count,
+      const DxvkDescriptorInfo*   infos,
+            size_t                hash,
+            VkDescriptorSet       set);
+    
+    /**
+     * \brief Removes all descriptor sets
+     */
+    void reset();
+    
+  private:
+    
+    struct Entry {
+      VkDescriptorSetLayout layout;
+      VkDescriptorSet       set;
+      size_t                infoIndex;
+      uint32_t              infoCount;
+    };
+    
+    std::unordered_multimap<size_t, Entry> m_entries;
+    std::vector<DxvkDescriptorInfo>        m_infos;
+    
+  };
+  
 }
\ No newline at end of file
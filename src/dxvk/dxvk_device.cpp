@@ -14,8 +14,12 @@ namespace dxvk {
     m_features        (features),
     m_memory          (new DxvkMemoryAllocator  (adapter, vkd)),
     m_renderPassPool  (new DxvkRenderPassPool   (vkd)),
-    m_pipelineCache   (new DxvkPipelineCache    (vkd)),
+    m_framebufferCache(new DxvkFramebufferCache (vkd)),
+    m_pipelineCache   (new DxvkPipelineCache    (adapter, vkd)),
     m_metaClearObjects(new DxvkMetaClearObjects (vkd)),
+    m_uploadRing      (new DxvkUploadRing       (this)),
+    m_descriptorPools (new DxvkDescriptorPoolManager(vkd)),
+    m_profiler        (new DxvkProfiler         (adapter)),
     m_unboundResources(this),
     m_submissionQueue (this) {
     m_vkd->vkGetDeviceQueue(m_vkd->device(),
@@ -24,10 +28,34 @@ namespace dxvk {
     m_vkd->vkGetDeviceQueue(m_vkd->device(),
       m_adapter->presentQueueFamily(), 0,
       &m_presentQueue);
+    
+    const std::string trimFrames = env::getEnvVar(L"DXVK_BUFFER_TRIM_FRAMES");
+    
+    if (!trimFrames.empty())
+      m_bufferTrimFrames = std::strtoul(trimFrames.c_str(), nullptr, 10);
+    
+    // Setting the cache path to 0 disables the state cache
+    const std::string stateCacheFile = DxvkPipelineCache::getFileName(".dxvk-state");
+    
+    if (!stateCacheFile.empty())
+      m_stateCache = new DxvkStateCache(m_renderPassPool, stateCacheFile);
+    
+    DxvkAsyncPipelineMode asyncMode = DxvkPipelineCompiler::getModeFromEnv();
+    
+    // The state cache needs worker threads in order to
+    // compile pipelines ahead of time in the background
+    if (asyncMode != DxvkAsyncPipelineMode::Disabled
+     || (m_stateCache != nullptr && m_stateCache->entryCount() != 0))
+      m_pipelineCompiler = new DxvkPipelineCompiler(asyncMode);
   }
   
   
   DxvkDevice::~DxvkDevice() {
+    // Make sure that no worker thread creates
+    // pipelines while the device is destroyed
+    if (m_pipelineCompiler != nullptr)
+      m_pipelineCompiler->stop();
+    
     // Wait for all pending Vulkan commands to be
     // executed before we destroy any resources.
     m_vkd->vkDeviceWaitIdle(m_vkd->device());
@@ -86,18 +114,44 @@ namespace dxvk {
   }
   
   
+  DxvkDescriptorPool DxvkDevice::allocDescriptorPool() {
+    return m_descriptorPools->allocPool();
+  }
+  
+  
+  void DxvkDevice::recycleDescriptorPools(
+          uint32_t            poolCount,
+    const DxvkDescriptorPool* pools,
+          uint32_t            setCount) {
+    m_descriptorPools->recyclePools(poolCount, pools, setCount);
+  }
+  
+  
+  DxvkPhysicalBufferSlice DxvkDevice::allocUploadSlice(VkDeviceSize length) {
+    return m_uploadRing->alloc(length);
+  }
+  
+  
   Rc<DxvkCommandList> DxvkDevice::createCommandList() {
     Rc<DxvkCommandList> cmdList = m_recycledCommandLists.retrieveObject();
     
     if (cmdList == nullptr) {
       cmdList = new DxvkCommandList(m_vkd,
-        this, m_adapter->graphicsQueueFamily());
+        this, m_adapter->graphicsQueueFamily(),
+        VK_COMMAND_BUFFER_LEVEL_PRIMARY);
     }
     
     return cmdList;
   }
   
   
+  Rc<DxvkCommandList> DxvkDevice::createSecondaryCommandList() {
+    return new DxvkCommandList(m_vkd,
+      this, m_adapter->graphicsQueueFamily(),
+      VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+  }
+  
+  
   Rc<DxvkContext> DxvkDevice::createContext() {
     return new DxvkContext(this,
       m_pipelineCache,
@@ -109,7 +163,8 @@ namespace dxvk {
     const DxvkRenderTargets& renderTargets) {
     auto format = renderTargets.renderPassFormat();
     auto renderPass = m_renderPassPool->getRenderPass(format);
-    return new DxvkFramebuffer(m_vkd, renderPass, renderTargets);
+    auto framebuffer = m_framebufferCache->getFramebuffer(renderPass, renderTargets);
+    return new DxvkFramebuffer(renderPass, renderTargets, framebuffer);
   }
   
   
@@ -178,11 +233,25 @@ namespace dxvk {
   
   
   DxvkStatCounters DxvkDevice::getStatCounters() {
-    DxvkMemoryStats mem = m_memory->getMemoryStats();
+    DxvkMemoryStats     mem  = m_memory->getMemoryStats();
+    DxvkUploadRingStats ring = m_uploadRing->getStats();
+    DxvkDescriptorPoolStats descPools = m_descriptorPools->getStats();
+    DxvkFramebufferCacheStats fbCache = m_framebufferCache->getStats();
     
     DxvkStatCounters result;
-    result.setCtr(DxvkStatCounter::MemoryAllocated, mem.memoryAllocated);
-    result.setCtr(DxvkStatCounter::MemoryUsed,      mem.memoryUsed);
+    result.setCtr(DxvkStatCounter::MemoryAllocated,     mem.memoryAllocated);
+    result.setCtr(DxvkStatCounter::MemoryUsed,          mem.memoryUsed);
+    result.setCtr(DxvkStatCounter::UploadRingAllocated, ring.memoryAllocated);
+    result.setCtr(DxvkStatCounter::UploadRingUsed,      ring.memoryUsed);
+    result.setCtr(DxvkStatCounter::DescriptorPoolCount, descPools.poolCount);
+    result.setCtr(DxvkStatCounter::DescriptorPoolsUsed, descPools.poolsInUse);
+    result.setCtr(DxvkStatCounter::DescriptorPoolSize,  descPools.poolMaxSets);
+    result.setCtr(DxvkStatCounter::FramebufferCount,    fbCache.framebufferCount);
+    result.setCtr(DxvkStatCounter::FramebufferCacheHits,   fbCache.cacheHits);
+    result.setCtr(DxvkStatCounter::FramebufferCacheMisses, fbCache.cacheMisses);
+    
+    if (m_pipelineCompiler != nullptr)
+      result.setCtr(DxvkStatCounter::PipeCountPending, m_pipelineCompiler->pendingCount());
     
     std::lock_guard<sync::Spinlock> lock(m_statLock);
     result.merge(m_statCounters);
@@ -195,15 +264,62 @@ namespace dxvk {
   }
   
   
+  void DxvkDevice::registerTrimmableBuffer(
+          DxvkBuffer*               buffer) {
+    std::lock_guard<std::mutex> lock(m_trimLock);
+    m_trimmableBuffers.push_back(buffer);
+  }
+  
+  
+  void DxvkDevice::unregisterTrimmableBuffer(
+          DxvkBuffer*               buffer) {
+    std::lock_guard<std::mutex> lock(m_trimLock);
+    
+    auto entry = std::find(
+      m_trimmableBuffers.begin(),
+      m_trimmableBuffers.end(), buffer);
+    
+    if (entry != m_trimmableBuffers.end()) {
+      *entry = m_trimmableBuffers.back();
+      m_trimmableBuffers.pop_back();
+    }
+  }
+  
+  
   VkResult DxvkDevice::presentSwapImage(
     const VkPresentInfoKHR&         presentInfo) {
+    VkResult status;
+    
+    auto t0 = DxvkProfiler::Clock::now();
+    
     { // Queue submissions are not thread safe
       std::lock_guard<std::mutex> queueLock(m_submissionLock);
       std::lock_guard<sync::Spinlock> statLock(m_statLock);
       
       m_statCounters.addCtr(DxvkStatCounter::QueuePresentCount, 1);
-      return m_vkd->vkQueuePresentKHR(m_presentQueue, &presentInfo);
+      status = m_vkd->vkQueuePresentKHR(m_presentQueue, &presentInfo);
+    }
+    
+    if (m_profiler->isEnabled()) {
+      m_profiler->addCpuTime(DxvkProfilerStage::Present, DxvkProfiler::Clock::now() - t0);
+      m_profiler->endFrame();
     }
+    
+    const uint64_t frameId = ++m_frameId;
+    
+    // Release physical buffers that buffers needed during a
+    // burst of invalidations but have not used since then
+    if (m_bufferTrimFrames != 0) {
+      std::lock_guard<std::mutex> lock(m_trimLock);
+      
+      for (DxvkBuffer* buffer : m_trimmableBuffers)
+        buffer->trimPhysicalSlices(frameId, m_bufferTrimFrames);
+    }
+    
+    // Chunks are otherwise only released when memory gets
+    // freed, so an idle heap would keep its peak usage
+    m_memory->trimChunks();
+    return status;
   }
   
   
@@ -226,6 +342,8 @@ namespace dxvk {
     
     VkResult status;
     
+    auto t0 = DxvkProfiler::Clock::now();
+    
     { // Queue submissions are not thread safe
       std::lock_guard<std::mutex> queueLock(m_submissionLock);
       std::lock_guard<sync::Spinlock> statLock(m_statLock);
@@ -235,6 +353,16 @@ namespace dxvk {
       
       status = commandList->submit(
         m_graphicsQueue, waitSemaphore, wakeSemaphore);
+      
+      if (status == VK_SUCCESS)
+        commandList->setSequenceNumber(++m_submissionCount);
+    }
+    
+    if (m_profiler->isEnabled()) {
+      m_profiler->addCpuTime(DxvkProfilerStage::Submit, DxvkProfiler::Clock::now() - t0);
+      
+      if (status == VK_SUCCESS)
+        commandList->setProfilerFrameId(m_profiler->beginSubmission());
     }
     
     if (status == VK_SUCCESS) {
@@ -248,6 +376,14 @@ namespace dxvk {
   }
   
   
+  bool DxvkDevice::waitForResource(
+    const Rc<DxvkResource>&         resource,
+          uint64_t                  timeout) {
+    return m_submissionQueue.waitForSubmission(
+      resource->lastUse(), timeout);
+  }
+  
+  
   void DxvkDevice::waitForIdle() {
     if (m_vkd->vkDeviceWaitIdle(m_vkd->device()) != VK_SUCCESS)
       Logger::err("DxvkDevice: waitForIdle: Operation failed");
@@ -11,17 +11,21 @@
 #include "dxvk_memory.h"
 #include "dxvk_meta_clear.h"
 #include "dxvk_pipecache.h"
+#include "dxvk_pipecompiler.h"
 #include "dxvk_pipemanager.h"
+#include "dxvk_profiler.h"
 #include "dxvk_queue.h"
 #include "dxvk_query_pool.h"
 #include "dxvk_recycler.h"
 #include "dxvk_renderpass.h"
 #include "dxvk_sampler.h"
 #include "dxvk_shader.h"
+#include "dxvk_state_cache.h"
 #include "dxvk_stats.h"
 #include "dxvk_swapchain.h"
 #include "dxvk_sync.h"
 #include "dxvk_unbound.h"
+#include "dxvk_upload_ring.h"
 
 namespace dxvk {
   
@@ -93,6 +97,36 @@ namespace dxvk {
       return m_features;
     }
     
+    /**
+     * \brief Pipeline compiler
+     * 
+     * Only available if asynchronous pipeline compilation
+     * is enabled or if the state cache is not empty.
+     * \returns Pipeline compiler, or \c nullptr
+     */
+    Rc<DxvkPipelineCompiler> pipelineCompiler() const {
+      return m_pipelineCompiler;
+    }
+    
+    /**
+     * \brief Frame profiler
+     * 
+     * Always available, but only records
+     * data once it has been enabled.
+     * \returns Frame profiler
+     */
+    Rc<DxvkProfiler> profiler() const {
+      return m_profiler;
+    }
+    
+    /**
+     * \brief State cache
+     * \returns State cache
+     */
+    Rc<DxvkStateCache> stateCache() const {
+      return m_stateCache;
+    }
+    
     /**
      * \brief Allocates a physical buffer
      * 
@@ -127,12 +161,61 @@ namespace dxvk {
     void recycleStagingBuffer(
       const Rc<DxvkStagingBuffer>& buffer);
     
+    /**
+     * \brief Allocates a descriptor pool
+     * 
+     * Returns a pool that command lists can allocate
+     * descriptor sets from. Pools are shared between
+     * all command lists of the device.
+     * \returns The descriptor pool
+     */
+    DxvkDescriptorPool allocDescriptorPool();
+    
+    /**
+     * \brief Recycles descriptor pools
+     * 
+     * Called when a command list is reset. The number
+     * of sets is used to size subsequently created pools.
+     * \param [in] poolCount Number of pools
+     * \param [in] pools The pools to recycle
+     * \param [in] setCount Number of sets allocated
+     */
+    void recycleDescriptorPools(
+            uint32_t            poolCount,
+      const DxvkDescriptorPool* pools,
+            uint32_t            setCount);
+    
+    /**
+     * \brief Allocates an upload ring slice
+     * 
+     * Used by small dynamic buffers instead of
+     * allocating physical buffers of their own.
+     * The slice is returned to the ring once all
+     * copies of it and all command lists that
+     * use it are gone.
+     * \param [in] length Slice length
+     * \returns The new buffer slice, or an undefined
+     *    slice if the upload ring is exhausted
+     */
+    DxvkPhysicalBufferSlice allocUploadSlice(
+            VkDeviceSize length);
+    
     /**
      * \brief Creates a command list
      * \returns The command list
      */
     Rc<DxvkCommandList> createCommandList();
     
+    /**
+     * \brief Creates a secondary command list
+     * 
+     * Secondary command lists can be recorded on any
+     * thread and executed from a primary command list
+     * using \ref DxvkContext::executeCommandList.
+     * \returns The command list
+     */
+    Rc<DxvkCommandList> createSecondaryCommandList();
+    
     /**
      * \brief Creates a context
      * 
@@ -146,7 +229,10 @@ namespace dxvk {
      * \brief Creates framebuffer for a set of render targets
      * 
      * Automatically deduces framebuffer dimensions
-     * from the supplied render target views.
+     * from the supplied render target views. The
+     * Vulkan framebuffer object is cached, so that
+     * repeated calls with the same render targets
+     * are cheap.
      * \param [in] renderTargets Render targets
      * \returns The framebuffer object
      */
@@ -266,6 +352,39 @@ namespace dxvk {
      */
     void initResources();
     
+    /**
+     * \brief Current frame number
+     * 
+     * Incremented every time a swap chain image is
+     * presented. Used to determine how long objects
+     * have not been used for.
+     * \returns Current frame number
+     */
+    uint64_t currentFrameId() const {
+      return m_frameId.load();
+    }
+    
+    /**
+     * \brief Registers a buffer for trimming
+     * 
+     * Buffers that have allocated more than one physical
+     * buffer get trimmed every frame so that physical
+     * buffers are released once they are no longer used.
+     * Called by the buffer. Do not use this directly.
+     * \param [in] buffer The buffer
+     */
+    void registerTrimmableBuffer(
+            DxvkBuffer*               buffer);
+    
+    /**
+     * \brief Unregisters a buffer for trimming
+     * 
+     * Called when a registered buffer gets destroyed.
+     * \param [in] buffer The buffer
+     */
+    void unregisterTrimmableBuffer(
+            DxvkBuffer*               buffer);
+    
     /**
      * \brief Presents a swap chain image
      * 
@@ -291,6 +410,20 @@ namespace dxvk {
       const Rc<DxvkSemaphore>&        waitSync,
       const Rc<DxvkSemaphore>&        wakeSync);
     
+    /**
+     * \brief Waits for a resource to become idle
+     * 
+     * Only waits for the last submission that used the
+     * resource, rather than for the entire device. Any
+     * commands using the resource must be submitted.
+     * \param [in] resource The resource to wait for
+     * \param [in] timeout Timeout, in nanoseconds
+     * \returns \c true if the resource is idle
+     */
+    bool waitForResource(
+      const Rc<DxvkResource>&         resource,
+            uint64_t                  timeout);
+    
     /**
      * \brief Waits until the device becomes idle
      * 
@@ -310,8 +443,13 @@ namespace dxvk {
     
     Rc<DxvkMemoryAllocator>   m_memory;
     Rc<DxvkRenderPassPool>    m_renderPassPool;
+    Rc<DxvkFramebufferCache>  m_framebufferCache;
     Rc<DxvkPipelineCache>     m_pipelineCache;
+    Rc<DxvkStateCache>        m_stateCache;
     Rc<DxvkMetaClearObjects>  m_metaClearObjects;
+    Rc<DxvkUploadRing>        m_uploadRing;
+    Rc<DxvkDescriptorPoolManager> m_descriptorPools;
+    Rc<DxvkProfiler>          m_profiler;
     
     DxvkUnboundResources      m_unboundResources;
     
@@ -319,6 +457,13 @@ namespace dxvk {
     DxvkStatCounters          m_statCounters;
     
     std::mutex m_submissionLock;
+    uint64_t   m_submissionCount = 0;
+    
+    std::atomic<uint64_t>     m_frameId = { 0ull };
+    
+    uint32_t                  m_bufferTrimFrames = 300;
+    std::mutex                m_trimLock;
+    std::vector<DxvkBuffer*>  m_trimmableBuffers;
     VkQueue m_graphicsQueue = VK_NULL_HANDLE;
     VkQueue m_presentQueue  = VK_NULL_HANDLE;
     
@@ -327,6 +472,10 @@ namespace dxvk {
     
     DxvkSubmissionQueue m_submissionQueue;
     
+    // Stopped explicitly in the destructor, since queued
+    // pipelines may outlive the device otherwise
+    Rc<DxvkPipelineCompiler> m_pipelineCompiler;
+    
     void recycleCommandList(
       const Rc<DxvkCommandList>& cmdList);
     
@@ -24,7 +24,7 @@ namespace dxvk {
             // An optional extension should not have any impact on
             // the functionality of an application, so inform the
             // user only if verbose debug messages are enabled
-            Logger::debug(str::format("Optional Vulkan extension ", ext->name(), " not supported"));
+            Logger::debugf("Optional Vulkan extension ", ext->name(), " not supported");
             break;
             
           case DxvkExtensionType::Desired:
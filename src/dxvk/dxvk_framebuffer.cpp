@@ -92,14 +92,13 @@ namespace dxvk {
   }
   
   
-  DxvkFramebuffer::DxvkFramebuffer(
+  DxvkFramebufferObject::DxvkFramebufferObject(
     const Rc<vk::DeviceFn>&       vkd,
     const Rc<DxvkRenderPass>&     renderPass,
     const DxvkRenderTargets&      renderTargets)
-  : m_vkd             (vkd),
-    m_renderPass      (renderPass),
-    m_renderTargets   (renderTargets),
-    m_framebufferSize (renderTargets.getImageSize()) {
+  : m_vkd(vkd) {
+    const DxvkFramebufferSize size = renderTargets.getImageSize();
+    
     std::array<VkImageView, MaxNumRenderTargets + 1> views;
     uint32_t viewCount = renderTargets.getAttachments(views.data());
     
@@ -110,21 +109,46 @@ namespace dxvk {
     info.renderPass           = renderPass->handle();
     info.attachmentCount      = viewCount;
     info.pAttachments         = views.data();
-    info.width                = m_framebufferSize.width;
-    info.height               = m_framebufferSize.height;
-    info.layers               = m_framebufferSize.layers;
+    info.width                = size.width;
+    info.height               = size.height;
+    info.layers               = size.layers;
     
     if (m_vkd->vkCreateFramebuffer(m_vkd->device(), &info, nullptr, &m_framebuffer) != VK_SUCCESS)
       throw DxvkError("DxvkFramebuffer: Failed to create framebuffer object");
   }
   
   
-  DxvkFramebuffer::~DxvkFramebuffer() {
+  DxvkFramebufferObject::~DxvkFramebufferObject() {
     m_vkd->vkDestroyFramebuffer(
       m_vkd->device(), m_framebuffer, nullptr);
   }
   
   
+  DxvkFramebuffer::DxvkFramebuffer(
+    const Rc<vk::DeviceFn>&       vkd,
+    const Rc<DxvkRenderPass>&     renderPass,
+    const DxvkRenderTargets&      renderTargets)
+  : DxvkFramebuffer(renderPass, renderTargets,
+      new DxvkFramebufferObject(vkd, renderPass, renderTargets)) { }
+  
+  
+  DxvkFramebuffer::DxvkFramebuffer(
+    const Rc<DxvkRenderPass>&     renderPass,
+    const DxvkRenderTargets&      renderTargets,
+    const Rc<DxvkFramebufferObject>& framebuffer)
+  : m_renderPass      (renderPass),
+    m_framebuffer     (framebuffer),
+    m_renderTargets   (renderTargets),
+    m_framebufferSize (renderTargets.getImageSize()) {
+    
+  }
+  
+  
+  DxvkFramebuffer::~DxvkFramebuffer() {
+    
+  }
+  
+  
   uint32_t DxvkFramebuffer::findAttachment(
     const Rc<DxvkImageView>& view) const {
     if (m_renderTargets.getDepthTarget().view == view)
@@ -138,4 +162,144 @@ namespace dxvk {
     return MaxNumRenderTargets;
   }
   
+  
+  bool DxvkFramebufferKey::operator == (const DxvkFramebufferKey& other) const {
+    return renderPass == other.renderPass
+        && views      == other.views;
+  }
+  
+  
+  size_t DxvkFramebufferKey::hash() const {
+    std::hash<const void*> ptrHash;
+    
+    DxvkHashState result;
+    result.add(ptrHash(renderPass));
+    
+    for (const DxvkImageView* view : views)
+      result.add(ptrHash(view));
+    
+    return result;
+  }
+  
+  
+  DxvkFramebufferCache::DxvkFramebufferCache(
+    const Rc<vk::DeviceFn>& vkd)
+  : m_vkd(vkd) {
+    
+  }
+  
+  
+  DxvkFramebufferCache::~DxvkFramebufferCache() {
+    
+  }
+  
+  
+  Rc<DxvkFramebufferObject> DxvkFramebufferCache::getFramebuffer(
+    const Rc<DxvkRenderPass>&     renderPass,
+    const DxvkRenderTargets&      renderTargets) {
+    // Use the same attachment order as the framebuffer
+    DxvkFramebufferKey key;
+    key.renderPass = renderPass.ptr();
+    key.views[0]   = renderTargets.getDepthTarget().view.ptr();
+    
+    for (uint32_t i = 0; i < MaxNumRenderTargets; i++)
+      key.views[i + 1] = renderTargets.getColorTarget(i).view.ptr();
+    
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    auto entry = m_framebuffers.find(key);
+    
+    if (entry != m_framebuffers.end()) {
+      m_cacheHits += 1;
+      return entry->second;
+    }
+    
+    Rc<DxvkFramebufferObject> framebuffer = new DxvkFramebufferObject(
+      m_vkd, renderPass, renderTargets);
+    
+    m_framebuffers.insert({ key, framebuffer });
+    m_cacheMisses += 1;
+    
+    // Make sure that the views notify us when they get
+    // destroyed, so that we can evict the framebuffer.
+    for (uint32_t i = 0; i < key.views.size(); i++) {
+      const DxvkImageView* view = key.views[i];
+      
+      if (view == nullptr)
+        continue;
+      
+      // A view may be bound to more than one attachment
+      bool known = false;
+      
+      for (uint32_t j = 0; j < i && !known; j++)
+        known = key.views[j] == view;
+      
+      if (!known) {
+        m_viewKeys[view].push_back(key);
+        view->setFramebufferCache(this);
+      }
+    }
+    
+    return framebuffer;
+  }
+  
+  
+  void DxvkFramebufferCache::evictView(
+    const DxvkImageView*          view) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    auto entry = m_viewKeys.find(view);
+    
+    if (entry == m_viewKeys.end())
+      return;
+    
+    std::vector<DxvkFramebufferKey> keys = std::move(entry->second);
+    m_viewKeys.erase(entry);
+    
+    // The other views of each evicted framebuffer
+    // must no longer refer to its key either
+    for (const DxvkFramebufferKey& key : keys) {
+      m_framebuffers.erase(key);
+      
+      for (const DxvkImageView* other : key.views) {
+        if (other != nullptr && other != view)
+          this->removeViewKey(other, key);
+      }
+    }
+  }
+  
+  
+  DxvkFramebufferCacheStats DxvkFramebufferCache::getStats() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    DxvkFramebufferCacheStats result;
+    result.framebufferCount = m_framebuffers.size();
+    result.cacheHits        = m_cacheHits;
+    result.cacheMisses      = m_cacheMisses;
+    return result;
+  }
+  
+  
+  void DxvkFramebufferCache::removeViewKey(
+    const DxvkImageView*          view,
+    const DxvkFramebufferKey&     key) {
+    auto entry = m_viewKeys.find(view);
+    
+    if (entry == m_viewKeys.end())
+      return;
+    
+    std::vector<DxvkFramebufferKey>& keys = entry->second;
+    
+    for (size_t i = 0; i < keys.size(); i++) {
+      if (keys[i] == key) {
+        keys[i] = keys.back();
+        keys.pop_back();
+        break;
+      }
+    }
+    
+    if (keys.empty())
+      m_viewKeys.erase(entry);
+  }
+  
 }
\ No newline at end of file
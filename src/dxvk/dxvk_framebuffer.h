@@ -1,5 +1,10 @@
 #pragma once
 
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "dxvk_hash.h"
 #include "dxvk_image.h"
 #include "dxvk_renderpass.h"
 
@@ -137,6 +142,40 @@ namespace dxvk {
   };
   
   
+  /**
+   * \brief Framebuffer object
+   * 
+   * Owns a Vulkan framebuffer object. Framebuffer
+   * objects are shared between all framebuffers
+   * that use the same render pass and attachments,
+   * and do not keep the attachments alive.
+   */
+  class DxvkFramebufferObject : public RcObject {
+    
+  public:
+    
+    DxvkFramebufferObject(
+      const Rc<vk::DeviceFn>&       vkd,
+      const Rc<DxvkRenderPass>&     renderPass,
+      const DxvkRenderTargets&      renderTargets);
+    ~DxvkFramebufferObject();
+    
+    /**
+     * \brief Framebuffer handle
+     * \returns Framebuffer handle
+     */
+    VkFramebuffer handle() const {
+      return m_framebuffer;
+    }
+    
+  private:
+    
+    Rc<vk::DeviceFn>    m_vkd;
+    VkFramebuffer       m_framebuffer = VK_NULL_HANDLE;
+    
+  };
+  
+  
   /**
    * \brief DXVK framebuffer
    * 
@@ -153,6 +192,12 @@ namespace dxvk {
       const Rc<vk::DeviceFn>&       vkd,
       const Rc<DxvkRenderPass>&     renderPass,
       const DxvkRenderTargets&      renderTargets);
+    
+    DxvkFramebuffer(
+      const Rc<DxvkRenderPass>&     renderPass,
+      const DxvkRenderTargets&      renderTargets,
+      const Rc<DxvkFramebufferObject>& framebuffer);
+    
     ~DxvkFramebuffer();
     
     /**
@@ -160,7 +205,7 @@ namespace dxvk {
      * \returns Framebuffer handle
      */
     VkFramebuffer handle() const {
-      return m_framebuffer;
+      return m_framebuffer->handle();
     }
     
     /**
@@ -171,6 +216,18 @@ namespace dxvk {
       return m_renderPass->handle();
     }
     
+    /**
+     * \brief Render pass handle for the given ops
+     * 
+     * The returned render pass is compatible with
+     * the one returned by \ref renderPass.
+     * \param [in] ops Attachment load and store ops
+     * \returns Render pass handle
+     */
+    VkRenderPass renderPass(const DxvkRenderPassOps& ops) const {
+      return m_renderPass->getHandle(ops);
+    }
+    
     /**
      * \brief Framebuffer size
      * \returns Framebuffer size
@@ -208,13 +265,117 @@ namespace dxvk {
     
   private:
     
-    Rc<vk::DeviceFn>    m_vkd;
-    Rc<DxvkRenderPass>  m_renderPass;
+    Rc<DxvkRenderPass>        m_renderPass;
+    Rc<DxvkFramebufferObject> m_framebuffer;
     
     DxvkRenderTargets   m_renderTargets;
     DxvkFramebufferSize m_framebufferSize = { 0, 0, 0 };
     
-    VkFramebuffer       m_framebuffer     = VK_NULL_HANDLE;
+  };
+  
+  
+  /**
+   * \brief Framebuffer cache key
+   * 
+   * Identifies a framebuffer object by its render pass
+   * and the attachments, in the order in which they are
+   * passed to the framebuffer. The render pass already
+   * covers the attachment formats and layouts.
+   */
+  struct DxvkFramebufferKey {
+    const DxvkRenderPass* renderPass = nullptr;
+    
+    std::array<const DxvkImageView*, MaxNumRenderTargets + 1> views = { };
+    
+    bool operator == (const DxvkFramebufferKey& other) const;
+    
+    size_t hash() const;
+  };
+  
+  
+  /**
+   * \brief Framebuffer cache stats
+   * 
+   * Reports the number of cached framebuffer objects
+   * as well as the number of lookups that found or
+   * had to create a framebuffer object.
+   */
+  struct DxvkFramebufferCacheStats {
+    uint64_t framebufferCount = 0;
+    uint64_t cacheHits        = 0;
+    uint64_t cacheMisses      = 0;
+  };
+  
+  
+  /**
+   * \brief Framebuffer cache
+   * 
+   * Applications that switch between a small number of
+   * render target sets would otherwise create and destroy
+   * Vulkan framebuffers all the time. Cached framebuffer
+   * objects are evicted once one of their attachment
+   * views gets destroyed. This class is thread-safe.
+   */
+  class DxvkFramebufferCache : public RcObject {
+    
+  public:
+    
+    DxvkFramebufferCache(
+      const Rc<vk::DeviceFn>& vkd);
+    ~DxvkFramebufferCache();
+    
+    /**
+     * \brief Retrieves a framebuffer object
+     * 
+     * Creates a new framebuffer object if no cached
+     * object matches the given render targets.
+     * \param [in] renderPass Render pass object
+     * \param [in] renderTargets Render targets
+     * \returns Framebuffer object
+     */
+    Rc<DxvkFramebufferObject> getFramebuffer(
+      const Rc<DxvkRenderPass>&     renderPass,
+      const DxvkRenderTargets&      renderTargets);
+    
+    /**
+     * \brief Evicts framebuffers using an image view
+     * 
+     * Called when an image view that was used as a
+     * framebuffer attachment gets destroyed.
+     * \param [in] view The image view
+     */
+    void evictView(
+      const DxvkImageView*          view);
+    
+    /**
+     * \brief Retrieves cache stats
+     * \returns Framebuffer cache stats
+     */
+    DxvkFramebufferCacheStats getStats();
+    
+  private:
+    
+    Rc<vk::DeviceFn> m_vkd;
+    
+    std::mutex m_mutex;
+    
+    std::unordered_map<
+      DxvkFramebufferKey,
+      Rc<DxvkFramebufferObject>,
+      DxvkHash> m_framebuffers;
+    
+    // Keys of all cached framebuffers that use a given
+    // view, so that eviction does not scan the cache
+    std::unordered_map<
+      const DxvkImageView*,
+      std::vector<DxvkFramebufferKey>> m_viewKeys;
+    
+    uint64_t m_cacheHits    = 0;
+    uint64_t m_cacheMisses  = 0;
+    
+    void removeViewKey(
+      const DxvkImageView*          view,
+      const DxvkFramebufferKey&     key);
     
   };
   
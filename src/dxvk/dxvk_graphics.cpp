@@ -3,6 +3,7 @@
 
 #include "dxvk_device.h"
 #include "dxvk_graphics.h"
+#include "dxvk_state_cache.h"
 
 namespace dxvk {
   
@@ -34,6 +35,22 @@ namespace dxvk {
   }
   
   
+  size_t DxvkGraphicsPipelineStateInfo::hash() const {
+    static_assert(sizeof(DxvkGraphicsPipelineStateInfo) % sizeof(uint32_t) == 0);
+    
+    // Padding bytes are always zero-initialized, so hashing the raw
+    // words of the struct is consistent with the memcmp comparison.
+    const uint32_t* words = reinterpret_cast<const uint32_t*>(this);
+    
+    DxvkHashState state;
+    
+    for (size_t i = 0; i < sizeof(DxvkGraphicsPipelineStateInfo) / sizeof(uint32_t); i++)
+      state.add(words[i]);
+    
+    return state;
+  }
+  
+  
   DxvkGraphicsPipeline::DxvkGraphicsPipeline(
     const DxvkDevice*             device,
     const Rc<DxvkPipelineCache>&  cache,
@@ -43,7 +60,8 @@ namespace dxvk {
     const Rc<DxvkShader>&         gs,
     const Rc<DxvkShader>&         fs)
   : m_device(device), m_vkd(device->vkd()),
-    m_cache(cache) {
+    m_cache(cache), m_compiler(device->pipelineCompiler().ptr()),
+    m_stateCache(device->stateCache()) {
     DxvkDescriptorSlotMapping slotMapping;
     if (vs  != nullptr) vs ->defineResourceSlots(slotMapping);
     if (tcs != nullptr) tcs->defineResourceSlots(slotMapping);
@@ -62,6 +80,12 @@ namespace dxvk {
     if (gs  != nullptr) m_gs  = gs ->createShaderModule(m_vkd, slotMapping);
     if (fs  != nullptr) m_fs  = fs ->createShaderModule(m_vkd, slotMapping);
     
+    if (vs  != nullptr) m_shaderKey.vs  = vs ->shaderKey();
+    if (tcs != nullptr) m_shaderKey.tcs = tcs->shaderKey();
+    if (tes != nullptr) m_shaderKey.tes = tes->shaderKey();
+    if (gs  != nullptr) m_shaderKey.gs  = gs ->shaderKey();
+    if (fs  != nullptr) m_shaderKey.fs  = fs ->shaderKey();
+    
     m_vsIn  = vs != nullptr ? vs->interfaceSlots().inputSlots  : 0;
     m_fsOut = fs != nullptr ? fs->interfaceSlots().outputSlots : 0;
     
@@ -77,24 +101,112 @@ namespace dxvk {
   
   VkPipeline DxvkGraphicsPipeline::getPipelineHandle(
     const DxvkGraphicsPipelineStateInfo& state,
-          DxvkStatCounters&              stats) {
+          DxvkStatCounters&              stats,
+          bool                           allowAsync,
+          bool&                          pending) {
+    pending = false;
+    
+    // Once the compiler is stopped, pipelines that are still
+    // pending are compiled on this thread when they are used
+    const bool async = allowAsync && m_compiler != nullptr
+      && m_compiler->mode() != DxvkAsyncPipelineMode::Disabled
+      && !m_compiler->isStopped();
+    
+    if (m_lastPipeline != nullptr && m_lastPipeline->first == state)
+      return m_lastPipeline->second.pipeline.load();
+    
+    auto entry = m_pipelines.find(state);
+    
+    if (entry == m_pipelines.end()) {
+      entry = m_pipelines.emplace(
+        std::piecewise_construct,
+        std::forward_as_tuple(state),
+        std::forward_as_tuple()).first;
+      
+      if (this->validatePipelineState(state)) {
+        if (m_stateCache != nullptr)
+          m_stateCache->addPipeline(m_shaderKey, state);
+        
+        entry->second.pending.store(true);
+        
+        if (!async || !m_compiler->queueCompilation(this, &entry->first, &entry->second))
+          this->compileInstance(entry->first, entry->second);
+      }
+      
+      stats.addCtr(DxvkStatCounter::PipeCountGraphics, 1);
+    }
     
-    for (const PipelineStruct& pair : m_pipelines) {
-      if (pair.stateVector == state)
-        return pair.pipeline;
+    if (entry->second.pending.load()) {
+      if (async) {
+        pending = true;
+        return this->getFallbackPipelineHandle(state);
+      }
+      
+      // The pipeline was queued in the background, but we cannot
+      // skip the draw. Compile it right away if no worker picked it
+      // up yet, otherwise wait for the worker to finish compiling.
+      this->compileInstance(entry->first, entry->second);
+      
+      std::unique_lock<std::mutex> lock(m_compileMutex);
+      m_compileCond.wait(lock, [entry] () {
+        return !entry->second.pending.load();
+      });
     }
     
-    VkPipeline pipeline = this->validatePipelineState(state)
-      ? this->compilePipeline(state, m_basePipeline)
-      : VK_NULL_HANDLE;
+    m_lastPipeline = &(*entry);
+    return entry->second.pipeline.load();
+  }
+  
+  
+  void DxvkGraphicsPipeline::prewarmInstance(
+    const DxvkGraphicsPipelineStateInfo& state) {
+    if (m_compiler == nullptr || m_pipelines.find(state) != m_pipelines.end())
+      return;
     
-    m_pipelines.push_back({ state, pipeline });
+    if (!this->validatePipelineState(state))
+      return;
     
-    if (m_basePipeline == VK_NULL_HANDLE)
-      m_basePipeline = pipeline;
+    auto entry = m_pipelines.emplace(
+      std::piecewise_construct,
+      std::forward_as_tuple(state),
+      std::forward_as_tuple()).first;
     
-    stats.addCtr(DxvkStatCounter::PipeCountGraphics, 1);
-    return pipeline;
+    entry->second.pending.store(true);
+    
+    if (!m_compiler->queueCompilation(this, &entry->first, &entry->second))
+      m_pipelines.erase(entry);
+  }
+  
+  
+  void DxvkGraphicsPipeline::compileInstance(
+    const DxvkGraphicsPipelineStateInfo& state,
+          DxvkGraphicsPipelineInstance&  instance) {
+    // Both a worker thread and the thread recording draws may
+    // try to compile the same instance, only one of them wins.
+    if (instance.claimed.exchange(true))
+      return;
+    
+    VkPipeline pipeline = this->compilePipeline(
+      state, this->getBasePipelineHandle());
+    
+    instance.pipeline.store(pipeline);
+    instance.pending.store(false);
+    
+    // Wake up the thread recording draws if it is waiting
+    // for this instance. Taking the lock ensures that it
+    // cannot miss the notification.
+    { std::lock_guard<std::mutex> lock(m_compileMutex); }
+    m_compileCond.notify_all();
+    
+    // Use the first successfully compiled pipeline as the base
+    // pipeline. The instance pointer is published last so that
+    // readers always see the matching state vector.
+    if (pipeline != VK_NULL_HANDLE) {
+      const DxvkGraphicsPipelineStateInfo* expected = nullptr;
+      
+      if (m_baseState.compare_exchange_strong(expected, &state))
+        m_baseInstance.store(&instance);
+    }
   }
   
   
@@ -289,14 +401,51 @@ namespace dxvk {
     
     auto t1 = std::chrono::high_resolution_clock::now();
     auto td = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0);
-    Logger::debug(str::format("DxvkGraphicsPipeline: Finished in ", td.count(), " ms"));
+    Logger::debugf("DxvkGraphicsPipeline: Finished in ", td.count(), " ms");
     return pipeline;
   }
   
   
+  VkPipeline DxvkGraphicsPipeline::getBasePipelineHandle() const {
+    const DxvkGraphicsPipelineInstance* base = m_baseInstance.load();
+    
+    return base != nullptr
+      ? base->pipeline.load()
+      : VK_NULL_HANDLE;
+  }
+  
+  
+  VkPipeline DxvkGraphicsPipeline::getFallbackPipelineHandle(
+    const DxvkGraphicsPipelineStateInfo& state) const {
+    if (m_compiler->mode() != DxvkAsyncPipelineMode::UseBasePipeline)
+      return VK_NULL_HANDLE;
+    
+    const DxvkGraphicsPipelineInstance* base = m_baseInstance.load();
+    
+    if (base == nullptr)
+      return VK_NULL_HANDLE;
+    
+    // The base pipeline can only be used if it is compatible
+    // with the current render pass and the vertex buffers
+    // that are bound, otherwise we have to skip the draw.
+    const DxvkGraphicsPipelineStateInfo& baseState = *m_baseState.load();
+    
+    if (baseState.omRenderPass     != state.omRenderPass
+     || baseState.ilAttributeCount != state.ilAttributeCount
+     || baseState.ilBindingCount   != state.ilBindingCount)
+      return VK_NULL_HANDLE;
+    
+    if (std::memcmp(baseState.ilAttributes, state.ilAttributes, sizeof(state.ilAttributes))
+     || std::memcmp(baseState.ilBindings,   state.ilBindings,   sizeof(state.ilBindings)))
+      return VK_NULL_HANDLE;
+    
+    return base->pipeline.load();
+  }
+  
+  
   void DxvkGraphicsPipeline::destroyPipelines() {
-    for (const PipelineStruct& pair : m_pipelines)
-      m_vkd->vkDestroyPipeline(m_vkd->device(), pair.pipeline, nullptr);
+    for (const auto& pair : m_pipelines)
+      m_vkd->vkDestroyPipeline(m_vkd->device(), pair.second.pipeline.load(), nullptr);
   }
   
   
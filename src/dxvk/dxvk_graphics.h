@@ -1,18 +1,25 @@
 #pragma once
 
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include "dxvk_binding.h"
 #include "dxvk_constant_state.h"
+#include "dxvk_hash.h"
 #include "dxvk_pipecache.h"
+#include "dxvk_pipecompiler.h"
 #include "dxvk_pipelayout.h"
 #include "dxvk_resource.h"
 #include "dxvk_shader.h"
+#include "dxvk_state_cache_types.h"
 #include "dxvk_stats.h"
 
 namespace dxvk {
   
   class DxvkDevice;
+  class DxvkStateCache;
   
   /**
    * \brief Graphics pipeline state info
@@ -33,6 +40,8 @@ namespace dxvk {
     bool operator == (const DxvkGraphicsPipelineStateInfo& other) const;
     bool operator != (const DxvkGraphicsPipelineStateInfo& other) const;
     
+    size_t hash() const;
+    
     DxvkBindingState                    bsBindingState;
     
     VkPrimitiveTopology                 iaPrimitiveTopology;
@@ -90,6 +99,21 @@ namespace dxvk {
   };
   
   
+  /**
+   * \brief Graphics pipeline instance
+   * 
+   * Stores the pipeline handle for a given state
+   * vector. If the pipeline is compiled in the
+   * background, the handle becomes available
+   * once the \c pending flag is cleared.
+   */
+  struct DxvkGraphicsPipelineInstance {
+    std::atomic<VkPipeline> pipeline = { VK_NULL_HANDLE };
+    std::atomic<bool>       pending  = { false };
+    std::atomic<bool>       claimed  = { false };
+  };
+  
+  
   /**
    * \brief Graphics pipeline
    * 
@@ -128,26 +152,74 @@ namespace dxvk {
      * 
      * Retrieves a pipeline handle for the given pipeline
      * state. If necessary, a new pipeline will be created.
+     * 
+     * If asynchronous pipeline compilation is enabled, the
+     * pipeline will be compiled in the background, and the
+     * returned handle is either a compatible base pipeline
+     * or \c VK_NULL_HANDLE until compilation is finished.
+     * Callers which cannot skip draws, such as contexts that
+     * record command lists for repeated execution, must
+     * disallow asynchronous compilation.
      * \param [in] state Pipeline state vector
      * \param [in,out] stats Stat counter
+     * \param [in] allowAsync Whether to allow async compilation
+     * \param [out] pending Set to \c true if the pipeline is not ready yet
      * \returns Pipeline handle
      */
     VkPipeline getPipelineHandle(
       const DxvkGraphicsPipelineStateInfo& state,
-            DxvkStatCounters&              stats);
+            DxvkStatCounters&              stats,
+            bool                           allowAsync,
+            bool&                          pending);
+    
+    /**
+     * \brief Shader keys
+     * 
+     * Identifies the pipeline's shaders
+     * for the purpose of state caching.
+     * \returns Shader keys
+     */
+    const DxvkStateCacheKey& shaderKey() const {
+      return m_shaderKey;
+    }
+    
+    /**
+     * \brief Compiles a pipeline ahead of time
+     * 
+     * Queues a pipeline for the given state vector for
+     * compilation on the pipeline compiler's worker
+     * threads, unless it already exists. Must be called
+     * from the thread that retrieves pipeline handles.
+     * \param [in] state Pipeline state vector
+     */
+    void prewarmInstance(
+      const DxvkGraphicsPipelineStateInfo& state);
+    
+    /**
+     * \brief Compiles a pipeline instance
+     * 
+     * Called by the pipeline compiler's worker
+     * threads for pipelines queued for compilation.
+     * \param [in] state Pipeline state vector
+     * \param [out] instance Pipeline instance
+     */
+    void compileInstance(
+      const DxvkGraphicsPipelineStateInfo& state,
+            DxvkGraphicsPipelineInstance&  instance);
     
   private:
     
-    struct PipelineStruct {
-      DxvkGraphicsPipelineStateInfo stateVector;
-      VkPipeline                    pipeline;
-    };
+    using PipelineMap = std::unordered_map<
+      DxvkGraphicsPipelineStateInfo,
+      DxvkGraphicsPipelineInstance, DxvkHash>;
     
     const DxvkDevice* const m_device;
     const Rc<vk::DeviceFn>  m_vkd;
     
-    Rc<DxvkPipelineCache>   m_cache;
-    Rc<DxvkPipelineLayout>  m_layout;
+    Rc<DxvkPipelineCache>     m_cache;
+    DxvkPipelineCompiler*     m_compiler;
+    Rc<DxvkStateCache>        m_stateCache;
+    Rc<DxvkPipelineLayout>    m_layout;
     
     Rc<DxvkShaderModule>  m_vs;
     Rc<DxvkShaderModule>  m_tcs;
@@ -155,19 +227,36 @@ namespace dxvk {
     Rc<DxvkShaderModule>  m_gs;
     Rc<DxvkShaderModule>  m_fs;
     
+    DxvkStateCacheKey m_shaderKey;
+    
     uint32_t m_vsIn  = 0;
     uint32_t m_fsOut = 0;
     
     DxvkGraphicsCommonPipelineStateInfo m_common;
     
-    std::vector<PipelineStruct> m_pipelines;
+    PipelineMap m_pipelines;
+    
+    std::mutex              m_compileMutex;
+    std::condition_variable m_compileCond;
+    
+    // Most recently used pipeline. Redraws with the same
+    // state vector can skip hashing the state entirely.
+    const PipelineMap::value_type* m_lastPipeline = nullptr;
     
-    VkPipeline m_basePipeline = VK_NULL_HANDLE;
+    // Pipeline used as a base for derivative pipelines. May be
+    // set from the pipeline compiler's worker threads.
+    std::atomic<const DxvkGraphicsPipelineStateInfo*> m_baseState    = { nullptr };
+    std::atomic<const DxvkGraphicsPipelineInstance*>  m_baseInstance = { nullptr };
     
     VkPipeline compilePipeline(
       const DxvkGraphicsPipelineStateInfo& state,
             VkPipeline                     baseHandle) const;
     
+    VkPipeline getBasePipelineHandle() const;
+    
+    VkPipeline getFallbackPipelineHandle(
+      const DxvkGraphicsPipelineStateInfo& state) const;
+    
     void destroyPipelines();
     
     bool validatePipelineState(
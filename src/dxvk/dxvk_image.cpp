@@ -1,3 +1,4 @@
+#include "dxvk_framebuffer.h"
 #include "dxvk_image.h"
 
 namespace dxvk {
@@ -132,8 +133,21 @@ namespace dxvk {
   
   
   DxvkImageView::~DxvkImageView() {
+    // Cached framebuffers must be destroyed
+    // before the attachment views themselves
+    if (m_fbCache != nullptr)
+      m_fbCache->evictView(this);
+    
     m_vkd->vkDestroyImageView(
       m_vkd->device(), m_view, nullptr);
   }
   
+  
+  void DxvkImageView::setFramebufferCache(
+          DxvkFramebufferCache*     cache) const {
+    // This is only ever called with the cache's lock held
+    if (m_fbCache == nullptr)
+      m_fbCache = cache;
+  }
+  
 }
\ No newline at end of file
@@ -6,6 +6,8 @@
 
 namespace dxvk {
   
+  class DxvkFramebufferCache;
+  
   /**
    * \brief Image create info
    * 
@@ -309,6 +311,18 @@ namespace dxvk {
       return result;
     }
     
+    /**
+     * \brief Registers a framebuffer cache
+     * 
+     * Called by the framebuffer cache when it creates a
+     * framebuffer that uses this view as an attachment,
+     * so that the framebuffer can be evicted when the
+     * view gets destroyed. Internal use only.
+     * \param [in] cache The framebuffer cache
+     */
+    void setFramebufferCache(
+            DxvkFramebufferCache*     cache) const;
+    
   private:
     
     Rc<vk::DeviceFn>  m_vkd;
@@ -317,6 +331,8 @@ namespace dxvk {
     DxvkImageViewCreateInfo m_info;
     VkImageView             m_view;
     
+    mutable Rc<DxvkFramebufferCache> m_fbCache;
+    
   };
   
 }
\ No newline at end of file
@@ -6,6 +6,12 @@ namespace dxvk {
   DxvkLifetimeTracker::~DxvkLifetimeTracker() { }
   
   
+  void DxvkLifetimeTracker::setLastUse(uint64_t sequence) {
+    for (const auto& resource : m_resources)
+      resource->setLastUse(sequence);
+  }
+  
+  
   void DxvkLifetimeTracker::reset() {
     for (const auto& resource : m_resources)
       resource->release();
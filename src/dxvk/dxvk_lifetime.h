@@ -30,6 +30,15 @@ namespace dxvk {
       rc->acquire();
     }
     
+    /**
+     * \brief Marks tracked resources as submitted
+     * 
+     * Stores the submission sequence number in
+     * all resources used by the command list.
+     * \param [in] sequence Submission sequence number
+     */
+    void setLastUse(uint64_t sequence);
+    
     /**
      * \brief Resets the command list
      * 
@@ -67,12 +67,13 @@ namespace dxvk {
           VkDeviceMemory  memory,
           void*           mapPtr,
           VkDeviceSize    size)
-  : m_heap  (heap),
-    m_memory(memory),
-    m_mapPtr(mapPtr),
-    m_size  (size) {
-    // Mark the entire chunk as free
-    m_freeList.push_back(FreeSlice { 0, size });
+  : m_heap      (heap),
+    m_memory    (memory),
+    m_mapPtr    (mapPtr),
+    m_size      (size),
+    m_allocator (size),
+    m_emptySince(std::chrono::steady_clock::now()) {
+    
   }
   
   
@@ -82,72 +83,24 @@ namespace dxvk {
   
   
   DxvkMemory DxvkMemoryChunk::alloc(VkDeviceSize size, VkDeviceSize align) {
-    // If the chunk is full, return
-    if (m_freeList.size() == 0)
-      return DxvkMemory();
-    
-    // Select the slice to allocate from in a worst-fit
-    // manner. This may help keep fragmentation low.
-    auto bestSlice = m_freeList.begin();
+    const VkDeviceSize offset = m_allocator.alloc(size, align);
     
-    for (auto slice = m_freeList.begin(); slice != m_freeList.end(); slice++) {
-      if (slice->length == size) {
-        bestSlice = slice;
-        break;
-      } else if (slice->length > bestSlice->length) {
-        bestSlice = slice;
-      }
-    }
-    
-    // We need to align the allocation to the requested alignment
-    const VkDeviceSize sliceStart = bestSlice->offset;
-    const VkDeviceSize sliceEnd   = bestSlice->offset + bestSlice->length;
-    
-    const VkDeviceSize allocStart = dxvk::align(sliceStart,        align);
-    const VkDeviceSize allocEnd   = dxvk::align(allocStart + size, align);
-    
-    if (allocEnd > sliceEnd)
+    if (offset == DxvkTlsfAllocator::InvalidOffset)
       return DxvkMemory();
     
-    // We can use this slice, but we'll have to add
-    // the unused parts of it back to the free list.
-    m_freeList.erase(bestSlice);
-    
-    if (allocStart != sliceStart)
-      m_freeList.push_back({ sliceStart, allocStart - sliceStart });
-    
-    if (allocEnd != sliceEnd)
-      m_freeList.push_back({ allocEnd, sliceEnd - allocEnd });
-    
-    // Create the memory object with the aligned slice
     return DxvkMemory(this, m_heap,
-      m_memory, allocStart, allocEnd - allocStart,
-      reinterpret_cast<char*>(m_mapPtr) + allocStart);
+      m_memory, offset, DxvkTlsfAllocator::allocSize(size),
+      reinterpret_cast<char*>(m_mapPtr) + offset);
   }
   
   
   void DxvkMemoryChunk::free(
           VkDeviceSize  offset,
           VkDeviceSize  length) {
-    // Remove adjacent entries from the free list and then add
-    // a new slice that covers all those entries. Without doing
-    // so, the slice could not be reused for larger allocations.
-    auto curr = m_freeList.begin();
-    
-    while (curr != m_freeList.end()) {
-      if (curr->offset == offset + length) {
-        length += curr->length;
-        curr = m_freeList.erase(curr);
-      } else if (curr->offset + curr->length == offset) {
-        offset -= curr->length;
-        length += curr->length;
-        curr = m_freeList.erase(curr);
-      } else {
-        curr++;
-      }
-    }
+    m_allocator.free(offset);
     
-    m_freeList.push_back({ offset, length });
+    if (m_allocator.isEmpty())
+      m_emptySince = std::chrono::steady_clock::now();
   }
   
   
@@ -181,12 +134,25 @@ namespace dxvk {
     } else {
       std::lock_guard<std::mutex> lock(m_mutex);
       
-      // Probe chunks in a first-fit manner
+      // Probe chunks in a first-fit manner. Empty chunks are
+      // only used as a last resort so that they can be given
+      // back to the driver once they have been idle for a while.
       for (const auto& chunk : m_chunks) {
-        DxvkMemory memory = chunk->alloc(size, align);
-        
-        if (memory.memory() != VK_NULL_HANDLE)
-          return memory;
+        if (!chunk->isEmpty()) {
+          DxvkMemory memory = chunk->alloc(size, align);
+          
+          if (memory.memory() != VK_NULL_HANDLE)
+            return memory;
+        }
+      }
+      
+      for (const auto& chunk : m_chunks) {
+        if (chunk->isEmpty()) {
+          DxvkMemory memory = chunk->alloc(size, align);
+          
+          if (memory.memory() != VK_NULL_HANDLE)
+            return memory;
+        }
       }
       
       // None of the existing chunks could satisfy
@@ -214,6 +180,12 @@ namespace dxvk {
   }
   
   
+  void DxvkMemoryHeap::trimChunks() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    this->freeEmptyChunks();
+  }
+  
+  
   VkDeviceMemory DxvkMemoryHeap::allocDeviceMemory(VkDeviceSize memorySize) {
     VkMemoryAllocateInfo info;
     info.sType            = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
@@ -260,6 +232,31 @@ namespace dxvk {
           VkDeviceSize      length) {
     std::lock_guard<std::mutex> lock(m_mutex);
     chunk->free(offset, length);
+    
+    this->freeEmptyChunks();
+  }
+  
+  
+  void DxvkMemoryHeap::freeEmptyChunks() {
+    // Chunks that have not been used for a while are likely
+    // not going to be needed again any time soon. The delay
+    // avoids reallocating chunks over and over again when
+    // resources are created and destroyed in quick succession.
+    std::chrono::steady_clock::time_point now;
+    
+    for (auto chunk = m_chunks.begin(); chunk != m_chunks.end(); ) {
+      if ((*chunk)->isEmpty()) {
+        if (now == std::chrono::steady_clock::time_point())
+          now = std::chrono::steady_clock::now();
+        
+        if (now - (*chunk)->emptySince() >= ChunkReleaseDelay) {
+          chunk = m_chunks.erase(chunk);
+          continue;
+        }
+      }
+      
+      chunk++;
+    }
   }
   
   
@@ -317,6 +314,14 @@ namespace dxvk {
   }
   
   
+  void DxvkMemoryAllocator::trimChunks() {
+    for (size_t i = 0; i < m_heaps.size(); i++) {
+      if (m_heaps[i] != nullptr)
+        m_heaps[i]->trimChunks();
+    }
+  }
+  
+  
   DxvkMemory DxvkMemoryAllocator::tryAlloc(
     const VkMemoryRequirements& req,
     const VkMemoryPropertyFlags flags) {
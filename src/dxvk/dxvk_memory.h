@@ -1,6 +1,9 @@
 #pragma once
 
+#include <chrono>
+
 #include "dxvk_adapter.h"
+#include "dxvk_tlsf.h"
 
 namespace dxvk {
   
@@ -106,6 +109,24 @@ namespace dxvk {
     
     ~DxvkMemoryChunk();
     
+    /**
+     * \brief Checks whether the chunk is unused
+     * \returns \c true if no memory is allocated
+     */
+    bool isEmpty() const {
+      return m_allocator.isEmpty();
+    }
+    
+    /**
+     * \brief Time at which the chunk became empty
+     * 
+     * Only meaningful if the chunk is empty.
+     * \returns Time of the last free operation
+     */
+    std::chrono::steady_clock::time_point emptySince() const {
+      return m_emptySince;
+    }
+    
     /**
      * \brief Allocates memory from the chunk
      * 
@@ -132,19 +153,24 @@ namespace dxvk {
             VkDeviceSize  offset,
             VkDeviceSize  length);
     
-  private:
+    /**
+     * \brief Queries sub-allocator stats
+     * \returns Sub-allocator stats
+     */
+    DxvkTlsfStats getStats() const {
+      return m_allocator.getStats();
+    }
     
-    struct FreeSlice {
-      VkDeviceSize offset;
-      VkDeviceSize length;
-    };
+  private:
     
     DxvkMemoryHeap* const m_heap;
     VkDeviceMemory  const m_memory;
     void*           const m_mapPtr;
     VkDeviceSize    const m_size;
     
-    std::vector<FreeSlice> m_freeList;
+    DxvkTlsfAllocator m_allocator;
+    
+    std::chrono::steady_clock::time_point m_emptySince;
     
   };
   
@@ -194,8 +220,19 @@ namespace dxvk {
      */
     DxvkMemoryStats getMemoryStats() const;
     
+    /**
+     * \brief Releases idle chunks
+     * 
+     * Frees chunks that have been empty for long
+     * enough, even if nothing has been freed on
+     * this heap in the meantime.
+     */
+    void trimChunks();
+    
   private:
     
+    constexpr static auto ChunkReleaseDelay = std::chrono::seconds(5);
+    
     const Rc<vk::DeviceFn>           m_vkd;
     const uint32_t                   m_memTypeId;
     const VkMemoryType               m_memType;
@@ -222,6 +259,8 @@ namespace dxvk {
             VkDeviceSize      offset,
             VkDeviceSize      length);
     
+    void freeEmptyChunks();
+    
   };
   
   
@@ -272,6 +311,15 @@ namespace dxvk {
      */
     DxvkMemoryStats getMemoryStats() const;
     
+    /**
+     * \brief Releases idle chunks on all heaps
+     * 
+     * Should be called periodically so that heaps
+     * which are no longer used for allocations can
+     * give their memory back to the driver.
+     */
+    void trimChunks();
+    
   private:
     
     const Rc<vk::DeviceFn>                 m_vkd;
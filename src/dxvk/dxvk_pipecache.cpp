@@ -1,26 +1,227 @@
 #include "dxvk_pipecache.h"
 
+#include "../util/com/com_include.h"
+
 namespace dxvk {
   
   DxvkPipelineCache::DxvkPipelineCache(
+    const Rc<DxvkAdapter>&  adapter,
     const Rc<vk::DeviceFn>& vkd)
-  : m_vkd(vkd) {
+  : m_vkd(vkd), m_fileName(getFileName(".dxvk-cache")) {
+    // The header identifies the device and driver that
+    // produced the data. Drivers may reject or even crash
+    // on cache data produced by a different driver build.
+    const VkPhysicalDeviceProperties properties
+      = adapter->deviceProperties();
+    
+    std::memset(&m_header, 0, sizeof(m_header));
+    std::memcpy(m_header.magic, "DXVK", 4);
+    m_header.version        = CacheVersion;
+    m_header.vendorId       = properties.vendorID;
+    m_header.deviceId       = properties.deviceID;
+    m_header.driverVersion  = properties.driverVersion;
+    std::memcpy(m_header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    
+    std::vector<char> cacheData = loadCacheData();
+    
     VkPipelineCacheCreateInfo info;
     info.sType            = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
     info.pNext            = nullptr;
     info.flags            = 0;
-    info.initialDataSize  = 0;
-    info.pInitialData     = nullptr;
+    info.initialDataSize  = cacheData.size();
+    info.pInitialData     = cacheData.size() != 0 ? cacheData.data() : nullptr;
     
     if (m_vkd->vkCreatePipelineCache(m_vkd->device(),
         &info, nullptr, &m_handle) != VK_SUCCESS)
       throw DxvkError("DxvkPipelineCache: Failed to create cache");
+    
+    m_writtenSize = cacheData.size();
+    
+    m_writerThread = std::thread([this] () { runWriter(); });
   }
   
   
   DxvkPipelineCache::~DxvkPipelineCache() {
+    { std::lock_guard<std::mutex> lock(m_writerMutex);
+      m_stopWriter.store(true);
+    }
+    
+    m_writerCond.notify_one();
+    m_writerThread.join();
+    
     m_vkd->vkDestroyPipelineCache(
       m_vkd->device(), m_handle, nullptr);
   }
   
+  
+  std::vector<char> DxvkPipelineCache::loadCacheData() const {
+    std::vector<char> result;
+    
+    if (m_fileName.empty())
+      return result;
+    
+    // If a previous run was interrupted while replacing the
+    // cache file, the temporary file may be the only valid copy
+    if (!readCacheFile(m_fileName, result)
+     && !readCacheFile(m_fileName + ".tmp", result))
+      return result;
+    
+    Logger::info(str::format(
+      "DxvkPipelineCache: Loaded ", result.size(),
+      " bytes from ", m_fileName));
+    return result;
+  }
+  
+  
+  bool DxvkPipelineCache::readCacheFile(
+    const std::string&      fileName,
+          std::vector<char>& data) const {
+    std::ifstream file(fileName, std::ios::binary);
+    
+    if (!file)
+      return false;
+    
+    DxvkPipelineCacheHeader header;
+    
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+      return false;
+    
+    if (std::memcmp(header.magic, m_header.magic, sizeof(header.magic))
+     || header.version       != m_header.version
+     || header.vendorId      != m_header.vendorId
+     || header.deviceId      != m_header.deviceId
+     || header.driverVersion != m_header.driverVersion
+     || std::memcmp(header.uuid, m_header.uuid, VK_UUID_SIZE)) {
+      Logger::warn(str::format(
+        "DxvkPipelineCache: Ignoring ", fileName,
+        ": Created by different device or driver"));
+      return false;
+    }
+    
+    // Do not trust the size stored in the file before
+    // allocating memory, the file may be truncated
+    const std::streamoff dataOffset = file.tellg();
+    file.seekg(0, std::ios::end);
+    const std::streamoff fileSize = file.tellg();
+    file.seekg(dataOffset, std::ios::beg);
+    
+    if (dataOffset < 0 || fileSize < dataOffset
+     || header.dataSize > uint64_t(fileSize - dataOffset)
+     || header.dataSize > MaxDataSize) {
+      Logger::warn(str::format("DxvkPipelineCache: Ignoring ", fileName, ": Invalid size"));
+      return false;
+    }
+    
+    data.resize(header.dataSize);
+    
+    if (!file.read(data.data(), data.size())) {
+      Logger::warn(str::format("DxvkPipelineCache: Ignoring ", fileName, ": Truncated"));
+      data.clear();
+      return false;
+    }
+    
+    const Sha1Hash hash = Sha1Hash::compute(
+      reinterpret_cast<const uint8_t*>(data.data()), data.size());
+    
+    if (!(hash == Sha1Hash(header.dataHash))) {
+      Logger::warn(str::format("DxvkPipelineCache: Ignoring ", fileName, ": Checksum mismatch"));
+      data.clear();
+      return false;
+    }
+    
+    return true;
+  }
+  
+  
+  void DxvkPipelineCache::storeCacheData() {
+    if (m_fileName.empty())
+      return;
+    
+    size_t dataSize = 0;
+    
+    if (m_vkd->vkGetPipelineCacheData(m_vkd->device(),
+          m_handle, &dataSize, nullptr) != VK_SUCCESS)
+      return;
+    
+    // Pipeline caches only ever grow, so if the size did
+    // not change, no new pipelines have been added to it.
+    if (dataSize == m_writtenSize)
+      return;
+    
+    std::vector<char> data(dataSize);
+    
+    if (m_vkd->vkGetPipelineCacheData(m_vkd->device(),
+          m_handle, &dataSize, data.data()) != VK_SUCCESS)
+      return;
+    
+    data.resize(dataSize);
+    
+    DxvkPipelineCacheHeader header = m_header;
+    header.dataSize = dataSize;
+    
+    const Sha1Hash hash = Sha1Hash::compute(
+      reinterpret_cast<const uint8_t*>(data.data()), data.size());
+    std::memcpy(header.dataHash.data(), hash.digest(), header.dataHash.size());
+    
+    // Write the data to a temporary file first and replace
+    // the actual cache file only once the write succeeded,
+    // so that a crash never leaves a corrupted cache behind.
+    const std::string tmpName = m_fileName + ".tmp";
+    
+    { std::ofstream file(tmpName, std::ios::binary | std::ios::trunc);
+    
+      if (!file.write(reinterpret_cast<const char*>(&header), sizeof(header))
+       || !file.write(data.data(), data.size())
+       || !file.flush()) {
+        Logger::warn(str::format("DxvkPipelineCache: Failed to write ", tmpName));
+        return;
+      }
+    }
+    
+    // Replace the cache file in one step, so that readers
+    // either see the old or the new file, but never neither
+    if (!::MoveFileExW(str::tows(tmpName).c_str(),
+          str::tows(m_fileName).c_str(), MOVEFILE_REPLACE_EXISTING)) {
+      Logger::warn(str::format("DxvkPipelineCache: Failed to replace ", m_fileName));
+      return;
+    }
+    
+    m_writtenSize = dataSize;
+  }
+  
+  
+  void DxvkPipelineCache::runWriter() {
+    std::unique_lock<std::mutex> lock(m_writerMutex);
+    
+    while (!m_stopWriter.load()) {
+      m_writerCond.wait_for(lock, WriteInterval,
+        [this] () { return m_stopWriter.load(); });
+      
+      lock.unlock();
+      this->storeCacheData();
+      lock.lock();
+    }
+  }
+  
+  
+  std::string DxvkPipelineCache::getFileName(
+    const std::string& extension) {
+    std::string path = env::getEnvVar(L"DXVK_PIPELINE_CACHE_PATH");
+    
+    if (path == "0")
+      return std::string();
+    
+    if (!path.empty() && *path.rbegin() != '/')
+      path += '/';
+    
+    std::string exeName = env::getExeName();
+    auto extp = exeName.find_last_of('.');
+    
+    if (extp != std::string::npos && exeName.substr(extp + 1) == "exe")
+      exeName.erase(extp);
+    
+    path += exeName + extension;
+    return path;
+  }
+  
 }
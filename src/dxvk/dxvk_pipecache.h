@@ -6,24 +6,54 @@
 #include <fstream>
 #include <thread>
 
-#include "dxvk_include.h"
+#include "dxvk_adapter.h"
 
 #include "../util/sha1/sha1_util.h"
 #include "../util/util_env.h"
 
 namespace dxvk {
   
+  /**
+   * \brief Pipeline cache file header
+   * 
+   * Stored in front of the pipeline cache data
+   * on disk. The cache is only loaded if all the
+   * device properties match and the data hash
+   * matches the data stored after the header.
+   */
+  struct DxvkPipelineCacheHeader {
+    char        magic[4];
+    uint32_t    version;
+    uint32_t    vendorId;
+    uint32_t    deviceId;
+    uint32_t    driverVersion;
+    uint8_t     uuid[VK_UUID_SIZE];
+    uint64_t    dataSize;
+    Sha1Digest  dataHash;
+  };
+  
+  
   /**
    * \brief Pipeline cache
    * 
    * Allows the Vulkan implementation to
    * re-use previously compiled pipelines.
+   * 
+   * The cache data is loaded from disk on creation
+   * and periodically written back from a background
+   * thread, so that pipelines compiled in previous
+   * runs of the application do not need to be
+   * compiled again.
    */
   class DxvkPipelineCache : public RcObject {
-    
+    constexpr static uint32_t CacheVersion = 1;
+    constexpr static auto     WriteInterval = std::chrono::seconds(30);
+    constexpr static uint64_t MaxDataSize   = 256ull << 20;
   public:
     
-    DxvkPipelineCache(const Rc<vk::DeviceFn>& vkd);
+    DxvkPipelineCache(
+      const Rc<DxvkAdapter>&  adapter,
+      const Rc<vk::DeviceFn>& vkd);
     ~DxvkPipelineCache();
     
     /**
@@ -34,11 +64,44 @@ namespace dxvk {
       return m_handle;
     }
     
+    /**
+     * \brief Computes the path of a cache file
+     * 
+     * Cache files are stored in the directory specified by
+     * \c DXVK_PIPELINE_CACHE_PATH and named after the
+     * executable. If caching is disabled by the user,
+     * this returns an empty string.
+     * \param [in] extension File name extension
+     * \returns Path to the cache file
+     */
+    static std::string getFileName(
+      const std::string& extension);
+    
   private:
     
     Rc<vk::DeviceFn>        m_vkd;
     VkPipelineCache         m_handle;
     
+    std::string             m_fileName;
+    DxvkPipelineCacheHeader m_header;
+    
+    size_t                  m_writtenSize = 0;
+    
+    std::atomic<bool>       m_stopWriter = { false };
+    std::mutex              m_writerMutex;
+    std::condition_variable m_writerCond;
+    std::thread             m_writerThread;
+    
+    std::vector<char> loadCacheData() const;
+    
+    bool readCacheFile(
+      const std::string&      fileName,
+            std::vector<char>& data) const;
+    
+    void storeCacheData();
+    
+    void runWriter();
+    
   };
   
 }
@@ -0,0 +1,102 @@
+#include "dxvk_graphics.h"
+#include "dxvk_pipecompiler.h"
+
+namespace dxvk {
+  
+  DxvkPipelineCompiler::DxvkPipelineCompiler(DxvkAsyncPipelineMode mode)
+  : m_mode(mode) {
+    const uint32_t workerCount = std::max(1u, std::thread::hardware_concurrency());
+    
+    Logger::info(str::format(
+      "DxvkPipelineCompiler: Using ", workerCount, " workers"));
+    
+    for (uint32_t i = 0; i < workerCount; i++)
+      m_workers.emplace_back([this] () { runWorker(); });
+  }
+  
+  
+  DxvkPipelineCompiler::~DxvkPipelineCompiler() {
+    this->stop();
+  }
+  
+  
+  void DxvkPipelineCompiler::stop() {
+    { std::unique_lock<std::mutex> lock(m_mutex);
+      m_stopped.store(true);
+    }
+    
+    m_condOnAdd.notify_all();
+    
+    for (auto& worker : m_workers) {
+      if (worker.joinable())
+        worker.join();
+    }
+    
+    // Release the remaining pipelines on this thread
+    std::queue<PipelineEntry> entries;
+    
+    { std::unique_lock<std::mutex> lock(m_mutex);
+      entries.swap(m_entries);
+    }
+    
+    m_pendingCount -= entries.size();
+  }
+  
+  
+  bool DxvkPipelineCompiler::queueCompilation(
+    const Rc<DxvkGraphicsPipeline>&         pipeline,
+    const DxvkGraphicsPipelineStateInfo*    state,
+          DxvkGraphicsPipelineInstance*     instance) {
+    // No worker would ever pick up pipelines queued after
+    // the compiler has been stopped, so reject them
+    { std::unique_lock<std::mutex> lock(m_mutex);
+      
+      if (m_stopped.load())
+        return false;
+      
+      m_pendingCount += 1;
+      m_entries.push({ pipeline, state, instance });
+    }
+    
+    m_condOnAdd.notify_one();
+    return true;
+  }
+  
+  
+  DxvkAsyncPipelineMode DxvkPipelineCompiler::getModeFromEnv() {
+    const std::string mode = env::getEnvVar(L"DXVK_ASYNC_PIPELINES");
+    
+    if (mode == "1" || mode == "skip")
+      return DxvkAsyncPipelineMode::SkipDraw;
+    
+    if (mode == "base")
+      return DxvkAsyncPipelineMode::UseBasePipeline;
+    
+    return DxvkAsyncPipelineMode::Disabled;
+  }
+  
+  
+  void DxvkPipelineCompiler::runWorker() {
+    while (!m_stopped.load()) {
+      PipelineEntry entry;
+      
+      { std::unique_lock<std::mutex> lock(m_mutex);
+      
+        m_condOnAdd.wait(lock, [this] {
+          return m_stopped.load() || (m_entries.size() != 0);
+        });
+        
+        if (m_entries.size() != 0) {
+          entry = std::move(m_entries.front());
+          m_entries.pop();
+        }
+      }
+      
+      if (entry.pipeline != nullptr) {
+        entry.pipeline->compileInstance(*entry.state, *entry.instance);
+        m_pendingCount -= 1;
+      }
+    }
+  }
+  
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "dxvk_include.h"
+
+namespace dxvk {
+  
+  class DxvkGraphicsPipeline;
+  struct DxvkGraphicsPipelineInstance;
+  struct DxvkGraphicsPipelineStateInfo;
+  
+  /**
+   * \brief Asynchronous pipeline compilation mode
+   *
+   * Determines what happens when a draw call uses a
+   * pipeline that is still being compiled.
+   */
+  enum class DxvkAsyncPipelineMode : uint32_t {
+    Disabled,         ///< Compile pipelines synchronously
+    SkipDraw,         ///< Skip the draw until the pipeline is ready
+    UseBasePipeline,  ///< Use a compatible pipeline if possible
+  };
+  
+  
+  /**
+   * \brief Pipeline compiler
+   *
+   * Compiles graphics pipelines on a pool of worker
+   * threads so that the thread recording the command
+   * stream does not stall when a new pipeline state
+   * vector is encountered.
+   * 
+   * Queued work keeps pipelines alive, so pipelines
+   * must not own a reference to the compiler. The
+   * device stops the compiler before it dies.
+   */
+  class DxvkPipelineCompiler : public RcObject {
+    
+    struct PipelineEntry {
+      Rc<DxvkGraphicsPipeline>              pipeline;
+      const DxvkGraphicsPipelineStateInfo*  state;
+      DxvkGraphicsPipelineInstance*         instance;
+    };
+    
+  public:
+    
+    DxvkPipelineCompiler(DxvkAsyncPipelineMode mode);
+    ~DxvkPipelineCompiler();
+    
+    /**
+     * \brief Asynchronous compilation mode
+     * \returns Compilation mode
+     */
+    DxvkAsyncPipelineMode mode() const {
+      return m_mode;
+    }
+    
+    /**
+     * \brief Number of pipelines being compiled
+     *
+     * Includes pipelines that are queued as well as
+     * pipelines that are currently being compiled.
+     * \returns Number of pipelines in flight
+     */
+    uint32_t pendingCount() const {
+      return m_pendingCount.load();
+    }
+    
+    /**
+     * \brief Checks whether the compiler was stopped
+     * 
+     * Pipelines that are still pending at this point
+     * will not be compiled by any of the workers.
+     * \returns \c true if \ref stop has been called
+     */
+    bool isStopped() const {
+      return m_stopped.load();
+    }
+    
+    /**
+     * \brief Queues a pipeline for compilation
+     *
+     * The state vector and the instance must remain valid
+     * until compilation is finished. This is guaranteed as
+     * long as they are owned by the pipeline object.
+     * \param [in] pipeline The graphics pipeline
+     * \param [in] state Pipeline state vector
+     * \param [in] instance Pipeline instance to compile
+     * \returns \c false if the compiler has been stopped,
+     *          in which case the caller must compile the
+     *          pipeline itself
+     */
+    bool queueCompilation(
+      const Rc<DxvkGraphicsPipeline>&         pipeline,
+      const DxvkGraphicsPipelineStateInfo*    state,
+            DxvkGraphicsPipelineInstance*     instance);
+    
+    /**
+     * \brief Reads compilation mode from the environment
+     *
+     * Parses the \c DXVK_ASYNC_PIPELINES variable.
+     * \returns Requested compilation mode
+     */
+    static DxvkAsyncPipelineMode getModeFromEnv();
+    
+    /**
+     * \brief Stops all worker threads
+     * 
+     * Waits for pipelines that are currently being
+     * compiled and drops all queued pipelines. Must
+     * be called before the device gets destroyed,
+     * and not from a worker thread.
+     */
+    void stop();
+    
+  private:
+    
+    const DxvkAsyncPipelineMode m_mode;
+    
+    std::atomic<bool>         m_stopped       = { false };
+    std::atomic<uint32_t>     m_pendingCount  = { 0u };
+    
+    std::mutex                m_mutex;
+    std::condition_variable   m_condOnAdd;
+    std::queue<PipelineEntry> m_entries;
+    std::vector<std::thread>  m_workers;
+    
+    void runWorker();
+    
+  };
+  
+}
@@ -1,3 +1,4 @@
+#include "dxvk_device.h"
 #include "dxvk_pipemanager.h"
 
 namespace dxvk {
@@ -91,6 +92,13 @@ namespace dxvk {
     const Rc<DxvkGraphicsPipeline> pipeline
       = new DxvkGraphicsPipeline(m_device, cache, vs, tcs, tes, gs, fs);
     
+    // Compile pipelines that were used with the
+    // same set of shaders in previous runs
+    const Rc<DxvkStateCache> stateCache = m_device->stateCache();
+    
+    if (stateCache != nullptr)
+      stateCache->prewarmPipeline(pipeline);
+    
     m_graphicsPipelines.insert(std::make_pair(key, pipeline));
     return pipeline;
   }
@@ -0,0 +1,263 @@
+#include "dxvk_adapter.h"
+#include "dxvk_profiler.h"
+
+namespace dxvk {
+  
+  DxvkProfiler::DxvkProfiler(const Rc<DxvkAdapter>& adapter)
+  : m_startTime (Clock::now()),
+    m_frameStart(Clock::now()) {
+    const VkPhysicalDeviceLimits limits = adapter->deviceProperties().limits;
+    
+    // Timestamps are only written on the graphics queue,
+    // so this limit tells us whether they are supported.
+    m_gpuSupported    = limits.timestampComputeAndGraphics;
+    m_timestampPeriod = limits.timestampPeriod;
+    
+    for (auto& time : m_cpuTimes)
+      time.store(0);
+    
+    const std::string fileName = env::getEnvVar(L"DXVK_PROFILE_FILE");
+    
+    if (!fileName.empty()) {
+      this->openFile(fileName);
+      this->enable();
+    }
+  }
+  
+  
+  DxvkProfiler::~DxvkProfiler() {
+    
+  }
+  
+  
+  void DxvkProfiler::enable() {
+    if (m_enabled.load())
+      return;
+    
+    m_frameStart = Clock::now();
+    
+    for (auto& time : m_cpuTimes)
+      time.store(0);
+    
+    const uint64_t frameId = m_frameId.load();
+    this->beginFrame(frameId);
+    
+    m_frameEnd   .store(frameId);
+    m_fileFrameId = frameId;
+    
+    m_enabled.store(true);
+  }
+  
+  
+  uint64_t DxvkProfiler::beginSubmission() {
+    // A submission that races with the end of the frame
+    // may get attributed to the next frame, which only
+    // affects the accuracy of the per-frame numbers.
+    const uint64_t frameId = m_frameId.load();
+    
+    Slot& slot = this->getSlot(frameId);
+    slot.pending     += 1;
+    slot.submitCount += 1;
+    return frameId;
+  }
+  
+  
+  void DxvkProfiler::endSubmission(
+          uint64_t              frameId,
+    const DxvkProfilerGpuTimes& gpuTimes) {
+    Slot& slot = this->getSlot(frameId);
+    slot.gpuTime           += this->ticksToNs(gpuTimes.gpuTime);
+    slot.gpuRenderPassTime += this->ticksToNs(gpuTimes.gpuRenderPassTime);
+    slot.renderPassCount   += gpuTimes.renderPassCount;
+    
+    this->releaseFrame(frameId);
+  }
+  
+  
+  void DxvkProfiler::endFrame() {
+    if (!m_enabled.load())
+      return;
+    
+    const Clock::time_point now = Clock::now();
+    const uint64_t frameId = m_frameId.load();
+    
+    auto toNs = [] (Clock::duration time) {
+      return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+    };
+    
+    DxvkProfilerFrame& frame = this->getSlot(frameId).cpu;
+    frame.frameId     = frameId;
+    frame.startTime   = toNs(m_frameStart - m_startTime);
+    frame.frameTime   = toNs(now - m_frameStart);
+    frame.csTime      = m_cpuTimes[uint32_t(DxvkProfilerStage::CsThread)].exchange(0);
+    frame.submitTime  = m_cpuTimes[uint32_t(DxvkProfilerStage::Submit)]  .exchange(0);
+    frame.presentTime = m_cpuTimes[uint32_t(DxvkProfilerStage::Present)] .exchange(0);
+    frame.appTime     = frame.frameTime - std::min(frame.presentTime, frame.frameTime);
+    
+    // Open the next frame before releasing this one so
+    // that new submissions never end up in a dead slot
+    this->beginFrame(frameId + 1);
+    m_frameId.store(frameId + 1);
+    m_frameStart = now;
+    
+    this->releaseFrame(frameId);
+    
+    if (m_file.is_open())
+      this->writeFrames();
+  }
+  
+  
+  uint32_t DxvkProfiler::getFrames(
+          uint32_t              frameCount,
+          DxvkProfilerFrame*    frames) {
+    const uint64_t frameEnd = m_frameEnd.load();
+    
+    frameCount = uint32_t(std::min<uint64_t>(
+      std::min(frameCount, MaxFrames / 2), frameEnd));
+    
+    uint32_t result = 0;
+    
+    for (uint64_t i = frameEnd - frameCount; i < frameEnd; i++) {
+      if (this->getFrame(i, frames[result]))
+        result += 1;
+    }
+    
+    return result;
+  }
+  
+  
+  void DxvkProfiler::beginFrame(uint64_t frameId) {
+    Slot& slot = this->getSlot(frameId);
+    slot.cpu               = DxvkProfilerFrame();
+    slot.submitCount       = 0;
+    slot.gpuTime           = 0;
+    slot.gpuRenderPassTime = 0;
+    slot.renderPassCount   = 0;
+    
+    // The frame itself holds a reference
+    // until it gets presented.
+    slot.pending.store(1);
+    slot.frameId.store(frameId);
+  }
+  
+  
+  void DxvkProfiler::releaseFrame(uint64_t frameId) {
+    Slot& slot = this->getSlot(frameId);
+    
+    if (--slot.pending != 0)
+      return;
+    
+    // Command lists complete in submission order, but
+    // they are read back by one thread per queue.
+    uint64_t frameEnd = m_frameEnd.load();
+    
+    while (frameEnd <= frameId
+      && !m_frameEnd.compare_exchange_weak(frameEnd, frameId + 1))
+      continue;
+  }
+  
+  
+  bool DxvkProfiler::getFrame(
+          uint64_t              frameId,
+          DxvkProfilerFrame&    frame) {
+    Slot& slot = this->getSlot(frameId);
+    
+    if (slot.frameId.load() != frameId
+     || slot.pending.load() != 0)
+      return false;
+    
+    frame                   = slot.cpu;
+    frame.gpuTime           = slot.gpuTime.load();
+    frame.gpuRenderPassTime = slot.gpuRenderPassTime.load();
+    frame.renderPassCount   = slot.renderPassCount.load();
+    frame.submitCount       = slot.submitCount.load();
+    return true;
+  }
+  
+  
+  void DxvkProfiler::openFile(const std::string& fileName) {
+    const std::string csvExt = ".csv";
+    
+    m_fileFormat = fileName.size() >= csvExt.size()
+      && fileName.compare(fileName.size() - csvExt.size(), csvExt.size(), csvExt) == 0
+      ? FileFormat::Csv : FileFormat::ChromeTrace;
+    
+    m_file = std::ofstream(fileName);
+    
+    if (!m_file.is_open()) {
+      Logger::err(str::format("DxvkProfiler: Failed to open ", fileName));
+      return;
+    }
+    
+    Logger::info(str::format("DxvkProfiler: Writing frame timings to ", fileName));
+    
+    // The trace event format allows the closing bracket to be
+    // missing, so the file remains valid if the app crashes.
+    if (m_fileFormat == FileFormat::Csv) {
+      m_file << "frame,start_us,frame_us,app_us,cs_us,submit_us,present_us,"
+                "gpu_us,gpu_renderpass_us,render_passes,submissions" << std::endl;
+    } else {
+      m_file << "[" << std::endl;
+    }
+  }
+  
+  
+  void DxvkProfiler::writeFrames() {
+    const uint64_t frameEnd = m_frameEnd.load();
+    
+    // Frames that dropped out of the ring buffer are lost
+    if (frameEnd - m_fileFrameId > MaxFrames / 2)
+      m_fileFrameId = frameEnd - MaxFrames / 2;
+    
+    DxvkProfilerFrame frame;
+    
+    while (m_fileFrameId < frameEnd) {
+      if (this->getFrame(m_fileFrameId, frame))
+        this->writeFrame(frame);
+      
+      m_fileFrameId += 1;
+    }
+  }
+  
+  
+  void DxvkProfiler::writeFrame(const DxvkProfilerFrame& frame) {
+    auto us = [] (uint64_t ns) { return double(ns) / 1000.0; };
+    
+    if (m_fileFormat == FileFormat::Csv) {
+      m_file << frame.frameId                 << ","
+             << us(frame.startTime)           << ","
+             << us(frame.frameTime)           << ","
+             << us(frame.appTime)             << ","
+             << us(frame.csTime)              << ","
+             << us(frame.submitTime)          << ","
+             << us(frame.presentTime)         << ","
+             << us(frame.gpuTime)             << ","
+             << us(frame.gpuRenderPassTime)   << ","
+             << frame.renderPassCount         << ","
+             << frame.submitCount             << "\n";
+      return;
+    }
+    
+    // CPU stages run on different threads and GPU timestamps
+    // use a different time base, so stages are emitted as
+    // counters, with one slice per frame on the app thread.
+    const double start = us(frame.startTime);
+    
+    m_file << "{\"name\":\"Frame " << frame.frameId << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+           << ",\"ts\":" << start << ",\"dur\":" << us(frame.frameTime) << "},\n";
+    
+    m_file << "{\"name\":\"Present\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+           << ",\"ts\":" << (start + us(frame.appTime)) << ",\"dur\":" << us(frame.presentTime) << "},\n";
+    
+    m_file << "{\"name\":\"CPU (ms)\",\"ph\":\"C\",\"pid\":1,\"ts\":" << start << ",\"args\":{"
+           << "\"app\":"     << us(frame.appTime)     / 1000.0 << ","
+           << "\"cs\":"      << us(frame.csTime)      / 1000.0 << ","
+           << "\"submit\":"  << us(frame.submitTime)  / 1000.0 << ","
+           << "\"present\":" << us(frame.presentTime) / 1000.0 << "}},\n";
+    
+    m_file << "{\"name\":\"GPU (ms)\",\"ph\":\"C\",\"pid\":1,\"ts\":" << start << ",\"args\":{"
+           << "\"total\":"        << us(frame.gpuTime)           / 1000.0 << ","
+           << "\"render_passes\":" << us(frame.gpuRenderPassTime) / 1000.0 << "}},\n";
+  }
+  
+}
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+
+#include "dxvk_include.h"
+
+namespace dxvk {
+  
+  class DxvkAdapter;
+  
+  /**
+   * \brief CPU profiler stage
+   *
+   * Stages for which the profiler accumulates
+   * the CPU time spent during each frame.
+   */
+  enum class DxvkProfilerStage : uint32_t {
+    CsThread,                 ///< Command stream thread executing commands
+    Submit,                   ///< Command buffer submission
+    Present,                  ///< Swap chain image presentation
+    NumStages,                ///< Number of stages
+  };
+  
+  
+  /**
+   * \brief Profiler frame
+   *
+   * Timings for a single frame. All times are in
+   * nanoseconds. GPU times are the sums over all
+   * command lists submitted during the frame.
+   */
+  struct DxvkProfilerFrame {
+    uint64_t frameId            = 0;  ///< Frame number
+    uint64_t startTime          = 0;  ///< Frame start, relative to profiler creation
+    uint64_t frameTime          = 0;  ///< Time between two presents
+    uint64_t appTime            = 0;  ///< App thread time outside of present
+    uint64_t csTime             = 0;  ///< CS thread time spent executing commands
+    uint64_t submitTime         = 0;  ///< Time spent in queue submissions
+    uint64_t presentTime        = 0;  ///< Time spent in queue presentation
+    uint64_t gpuTime            = 0;  ///< GPU execution time of command lists
+    uint64_t gpuRenderPassTime  = 0;  ///< GPU execution time of render passes
+    uint32_t renderPassCount    = 0;  ///< Number of render passes timed
+    uint32_t submitCount        = 0;  ///< Number of command lists submitted
+  };
+  
+  
+  /**
+   * \brief GPU timings of a command list
+   *
+   * Differences between raw timestamp values,
+   * which the profiler converts to nanoseconds.
+   */
+  struct DxvkProfilerGpuTimes {
+    uint64_t gpuTime            = 0;
+    uint64_t gpuRenderPassTime  = 0;
+    uint32_t renderPassCount    = 0;
+  };
+  
+  
+  /**
+   * \brief Frame profiler
+   *
+   * Records where the time of each frame goes. CPU times
+   * are accumulated by the threads doing the work, and GPU
+   * times are read back from timestamp queries once the
+   * command lists of a frame have completed execution.
+   *
+   * Frames are stored in a ring buffer. A frame is complete
+   * once it has been presented and all command lists that
+   * were submitted during the frame have been read back.
+   * None of this requires a lock, so that recording does
+   * not serialize the app, CS and submission threads.
+   *
+   * The profiler is disabled by default and can be enabled
+   * by the HUD, or via \c DXVK_PROFILE_FILE, in which case
+   * completed frames are also written to that file.
+   */
+  class DxvkProfiler : public RcObject {
+    constexpr static uint32_t MaxFrames = 256;
+  public:
+    
+    using Clock = std::chrono::high_resolution_clock;
+    
+    /// Number of timestamp queries per command list
+    constexpr static uint32_t MaxTimestamps = 512;
+    
+    DxvkProfiler(const Rc<DxvkAdapter>& adapter);
+    ~DxvkProfiler();
+    
+    /**
+     * \brief Checks whether the profiler is enabled
+     * \returns \c true if the profiler records data
+     */
+    bool isEnabled() const {
+      return m_enabled.load(std::memory_order_relaxed);
+    }
+    
+    /**
+     * \brief Checks whether GPU timings are recorded
+     *
+     * Requires the profiler to be enabled and the
+     * device to support timestamp queries.
+     * \returns \c true if command lists should
+     *    write timestamps for the profiler
+     */
+    bool isGpuEnabled() const {
+      return m_gpuSupported && isEnabled();
+    }
+    
+    /**
+     * \brief Enables the profiler
+     *
+     * Starts recording with the current frame.
+     * Must be called from the presenting thread.
+     */
+    void enable();
+    
+    /**
+     * \brief Adds CPU time to the current frame
+     *
+     * \param [in] stage The stage
+     * \param [in] time Time spent in that stage
+     */
+    void addCpuTime(
+            DxvkProfilerStage   stage,
+            Clock::duration     time) {
+      m_cpuTimes[uint32_t(stage)] += uint64_t(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+    }
+    
+    /**
+     * \brief Registers a command list submission
+     *
+     * Must be followed by a call to \ref endSubmission
+     * once the command list has completed execution.
+     * \returns Frame that the submission belongs to
+     */
+    uint64_t beginSubmission();
+    
+    /**
+     * \brief Adds GPU timings of a command list
+     *
+     * \param [in] frameId Frame returned by \ref beginSubmission
+     * \param [in] gpuTimes GPU timings
+     */
+    void endSubmission(
+            uint64_t              frameId,
+      const DxvkProfilerGpuTimes& gpuTimes);
+    
+    /**
+     * \brief Ends the current frame
+     *
+     * Called by the device after presenting a swap chain
+     * image. Also writes completed frames to the profile
+     * file, if one was requested.
+     */
+    void endFrame();
+    
+    /**
+     * \brief Retrieves recently completed frames
+     *
+     * \param [in] frameCount Maximum number of frames
+     * \param [out] frames Frames, oldest first
+     * \returns Number of frames written
+     */
+    uint32_t getFrames(
+            uint32_t              frameCount,
+            DxvkProfilerFrame*    frames);
+    
+  private:
+    
+    // CPU timings are only accessed by the presenting
+    // thread, everything else may be updated by any
+    // thread that submits or reads back command lists.
+    struct Slot {
+      DxvkProfilerFrame     cpu;
+      std::atomic<uint64_t> frameId           = { ~0ull };
+      std::atomic<uint32_t> pending           = { 0u };
+      std::atomic<uint32_t> submitCount       = { 0u };
+      std::atomic<uint64_t> gpuTime           = { 0ull };
+      std::atomic<uint64_t> gpuRenderPassTime = { 0ull };
+      std::atomic<uint32_t> renderPassCount   = { 0u };
+    };
+    
+    enum class FileFormat : uint32_t {
+      ChromeTrace,
+      Csv,
+    };
+    
+    std::atomic<bool>       m_enabled = { false };
+    bool                    m_gpuSupported    = false;
+    double                  m_timestampPeriod = 1.0;
+    
+    Clock::time_point       m_startTime;
+    Clock::time_point       m_frameStart;
+    
+    std::array<std::atomic<uint64_t>,
+      uint32_t(DxvkProfilerStage::NumStages)> m_cpuTimes;
+    
+    std::atomic<uint64_t>   m_frameId   = { 0ull };
+    std::atomic<uint64_t>   m_frameEnd  = { 0ull };
+    std::array<Slot, MaxFrames> m_frames;
+    
+    std::ofstream           m_file;
+    FileFormat              m_fileFormat  = FileFormat::ChromeTrace;
+    uint64_t                m_fileFrameId = 0;
+    
+    Slot& getSlot(uint64_t frameId) {
+      return m_frames[frameId % MaxFrames];
+    }
+    
+    uint64_t ticksToNs(uint64_t ticks) const {
+      return uint64_t(double(ticks) * m_timestampPeriod);
+    }
+    
+    void beginFrame(uint64_t frameId);
+    
+    void releaseFrame(uint64_t frameId);
+    
+    bool getFrame(
+            uint64_t              frameId,
+            DxvkProfilerFrame&    frame);
+    
+    void openFile(const std::string& fileName);
+    
+    void writeFrames();
+    
+    void writeFrame(const DxvkProfilerFrame& frame);
+    
+  };
+  
+}
@@ -104,6 +104,25 @@ namespace dxvk {
   }
   
   
+  VkResult DxvkQueryPool::getTimestamps(
+          uint32_t          queryIndex,
+          uint32_t          queryCount,
+          uint64_t*         timestamps) {
+    const VkResult status = m_vkd->vkGetQueryPoolResults(
+      m_vkd->device(), m_queryPool, queryIndex, queryCount,
+      sizeof(uint64_t) * queryCount, timestamps,
+      sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    
+    if (status != VK_SUCCESS) {
+      Logger::warn(str::format(
+        "DxvkQueryPool: Failed to get timestamps for ", queryIndex,
+        ":", queryCount, " with: ", status));
+    }
+    
+    return status;
+  }
+  
+  
   void DxvkQueryPool::reset(const Rc<DxvkCommandList>& cmd) {
     cmd->cmdResetQueryPool(m_queryPool, 0, m_queryCount);
     
@@ -63,6 +63,23 @@ namespace dxvk {
             uint32_t          queryIndex,
             uint32_t          queryCount);
     
+    /**
+     * \brief Reads back raw timestamps
+     * 
+     * Only valid for timestamp query pools. Unlike
+     * \ref getData, this does not forward the data
+     * to any query objects, so queries written this
+     * way do not need to be allocated.
+     * \param [in] queryIndex First query in the range
+     * \param [in] queryCount Number of queries
+     * \param [out] timestamps Timestamp values
+     * \returns Query result status
+     */
+    VkResult getTimestamps(
+            uint32_t          queryIndex,
+            uint32_t          queryCount,
+            uint64_t*         timestamps);
+    
     /**
      * \brief Resets query pool
      * 
@@ -33,6 +33,17 @@ namespace dxvk {
   }
   
   
+  bool DxvkSubmissionQueue::waitForSubmission(
+          uint64_t        sequence,
+          uint64_t        timeout) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    
+    return m_condOnSync.wait_for(lock,
+      std::chrono::nanoseconds(timeout),
+      [this, sequence] { return m_completed >= sequence; });
+  }
+  
+  
   void DxvkSubmissionQueue::threadFunc() {
     while (!m_stopped.load()) {
       Rc<DxvkCommandList> cmdList;
@@ -56,9 +67,18 @@ namespace dxvk {
         
         if (status == VK_SUCCESS) {
           cmdList->writeQueryData();
+          cmdList->writeProfilerData();
           cmdList->signalEvents();
           cmdList->reset();
           
+          // Submissions to the same queue complete in
+          // order, but they may have been added to this
+          // queue out of order by different threads.
+          { std::unique_lock<std::mutex> lock(m_mutex);
+            m_completed = std::max(m_completed, cmdList->sequenceNumber());
+          }
+          
+          m_condOnSync.notify_all();
           m_device->recycleCommandList(cmdList);
         } else {
           Logger::err(str::format(
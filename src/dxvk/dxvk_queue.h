@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <queue>
@@ -15,7 +16,9 @@ namespace dxvk {
   /**
    * \brief Submission queue
    * 
-   * 
+   * Waits for submitted command lists to complete
+   * execution on a background thread, and recycles
+   * them once they are no longer in use.
    */
   class DxvkSubmissionQueue {
     
@@ -26,6 +29,20 @@ namespace dxvk {
     
     void submit(const Rc<DxvkCommandList>& cmdList);
     
+    /**
+     * \brief Waits for a submission to complete
+     * 
+     * Blocks until the command list with the given
+     * sequence number, and all command lists that were
+     * submitted before it, have completed execution.
+     * \param [in] sequence Submission sequence number
+     * \param [in] timeout Timeout, in nanoseconds
+     * \returns \c true if the submission has completed
+     */
+    bool waitForSubmission(
+            uint64_t        sequence,
+            uint64_t        timeout);
+    
   private:
     
     DxvkDevice*             m_device;
@@ -35,6 +52,8 @@ namespace dxvk {
     std::mutex              m_mutex;
     std::condition_variable m_condOnAdd;
     std::condition_variable m_condOnTake;
+    std::condition_variable m_condOnSync;
+    uint64_t                m_completed = 0;
     std::queue<Rc<DxvkCommandList>> m_entries;
     std::thread             m_thread;
     
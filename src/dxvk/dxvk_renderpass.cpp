@@ -4,6 +4,17 @@
 
 namespace dxvk {
   
+  bool DxvkRenderPassOps::operator == (const DxvkRenderPassOps& other) const {
+    bool equal = depthOps   == other.depthOps
+              && stencilOps == other.stencilOps;
+    
+    for (uint32_t i = 0; i < MaxNumRenderTargets && equal; i++)
+      equal &= colorOps[i] == other.colorOps[i];
+    
+    return equal;
+  }
+  
+  
   bool DxvkRenderPassFormat::matchesFormat(const DxvkRenderPassFormat& other) const {
     bool equal = m_samples == other.m_samples;
     
@@ -23,10 +34,75 @@ namespace dxvk {
   }
   
   
+  size_t DxvkRenderPassFormat::hash() const {
+    std::hash<uint32_t> intHash;
+    
+    // Unused targets are common and do not need to be
+    // hashed, but the index of each used one matters
+    auto addTarget = [&] (DxvkHashState& state, uint32_t index, const DxvkRenderTargetFormat& target) {
+      if (target.format != VK_FORMAT_UNDEFINED) {
+        state.add(intHash(index));
+        state.add(intHash(target.format));
+        state.add(intHash(target.initialLayout));
+        state.add(intHash(target.finalLayout));
+        state.add(intHash(target.renderLayout));
+      }
+    };
+    
+    DxvkHashState result;
+    result.add(intHash(m_samples));
+    
+    addTarget(result, MaxNumRenderTargets, m_depth);
+    
+    for (uint32_t i = 0; i < MaxNumRenderTargets; i++)
+      addTarget(result, i, m_color[i]);
+    
+    return result;
+  }
+  
+  
   DxvkRenderPass::DxvkRenderPass(
     const Rc<vk::DeviceFn>&     vkd,
     const DxvkRenderPassFormat& fmt)
-  : m_vkd(vkd), m_format(fmt) {
+  : m_vkd(vkd), m_format(fmt),
+    m_renderPass(this->createRenderPass(DxvkRenderPassOps())) {
+    
+  }
+  
+  
+  DxvkRenderPass::~DxvkRenderPass() {
+    m_vkd->vkDestroyRenderPass(
+      m_vkd->device(), m_renderPass, nullptr);
+    
+    for (const auto& instance : m_instances) {
+      m_vkd->vkDestroyRenderPass(
+        m_vkd->device(), instance.handle, nullptr);
+    }
+  }
+  
+  
+  VkRenderPass DxvkRenderPass::getHandle(
+    const DxvkRenderPassOps& ops) {
+    if (ops == DxvkRenderPassOps())
+      return m_renderPass;
+    
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    for (const auto& instance : m_instances) {
+      if (instance.ops == ops)
+        return instance.handle;
+    }
+    
+    VkRenderPass handle = this->createRenderPass(ops);
+    m_instances.push_back({ ops, handle });
+    return handle;
+  }
+  
+  
+  VkRenderPass DxvkRenderPass::createRenderPass(
+    const DxvkRenderPassOps& ops) {
+    const DxvkRenderPassFormat& fmt = m_format;
+    
     std::vector<VkAttachmentDescription> attachments;
     
     VkAttachmentReference                                  depthRef;
@@ -34,6 +110,9 @@ namespace dxvk {
     
     // Render passes may not require the previous
     // contents of the attachments to be preserved.
+    // If an attachment does not get loaded at all,
+    // its contents can be discarded when it gets
+    // transitioned to the render pass layout.
     const DxvkRenderTargetFormat depthFmt = fmt.getDepthFormat();
     
     if (depthFmt.format != VK_FORMAT_UNDEFINED) {
@@ -41,13 +120,17 @@ namespace dxvk {
       desc.flags          = 0;
       desc.format         = depthFmt.format;
       desc.samples        = fmt.getSampleCount();
-      desc.loadOp         = VK_ATTACHMENT_LOAD_OP_LOAD;
-      desc.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
-      desc.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_LOAD;
-      desc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+      desc.loadOp         = ops.depthOps.loadOp;
+      desc.storeOp        = ops.depthOps.storeOp;
+      desc.stencilLoadOp  = ops.stencilOps.loadOp;
+      desc.stencilStoreOp = ops.stencilOps.storeOp;
       desc.initialLayout  = depthFmt.initialLayout;
       desc.finalLayout    = depthFmt.finalLayout;
       
+      if (desc.loadOp        != VK_ATTACHMENT_LOAD_OP_LOAD
+       && desc.stencilLoadOp != VK_ATTACHMENT_LOAD_OP_LOAD)
+        desc.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+      
       depthRef.attachment = attachments.size();
       depthRef.layout     = depthFmt.renderLayout;
       
@@ -65,13 +148,16 @@ namespace dxvk {
         desc.flags            = 0;
         desc.format           = colorFmt.format;
         desc.samples          = fmt.getSampleCount();
-        desc.loadOp           = VK_ATTACHMENT_LOAD_OP_LOAD;
-        desc.storeOp          = VK_ATTACHMENT_STORE_OP_STORE;
+        desc.loadOp           = ops.colorOps[i].loadOp;
+        desc.storeOp          = ops.colorOps[i].storeOp;
         desc.stencilLoadOp    = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         desc.stencilStoreOp   = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         desc.initialLayout    = colorFmt.initialLayout;
         desc.finalLayout      = colorFmt.finalLayout;
         
+        if (desc.loadOp != VK_ATTACHMENT_LOAD_OP_LOAD)
+          desc.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        
         colorRef[i].attachment = attachments.size();
         colorRef[i].layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
         
@@ -139,14 +225,100 @@ namespace dxvk {
     info.dependencyCount              = subpassDeps.size();
     info.pDependencies                = subpassDeps.data();
     
-    if (m_vkd->vkCreateRenderPass(m_vkd->device(), &info, nullptr, &m_renderPass) != VK_SUCCESS)
-      throw DxvkError("DxvkRenderPass::DxvkRenderPass: Failed to create render pass object");
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    
+    if (m_vkd->vkCreateRenderPass(m_vkd->device(), &info, nullptr, &renderPass) != VK_SUCCESS)
+      throw DxvkError("DxvkRenderPass: Failed to create render pass object");
+    
+    return renderPass;
   }
   
   
-  DxvkRenderPass::~DxvkRenderPass() {
-    m_vkd->vkDestroyRenderPass(
-      m_vkd->device(), m_renderPass, nullptr);
+  DxvkRenderPassTable::Table::Table(uint32_t size)
+  : mask(size - 1), slots(new std::atomic<const Entry*>[size]) {
+    for (uint32_t i = 0; i < size; i++)
+      slots[i].store(nullptr, std::memory_order_relaxed);
+  }
+  
+  
+  DxvkRenderPassTable::DxvkRenderPassTable() {
+    m_tables.emplace_back(new Table(64));
+    m_table.store(m_tables.back().get());
+  }
+  
+  
+  DxvkRenderPassTable::~DxvkRenderPassTable() {
+    
+  }
+  
+  
+  const DxvkRenderPassTable::Entry* DxvkRenderPassTable::find(
+    const DxvkRenderPassFormat& fmt,
+          size_t                hash) const {
+    const Table* table = m_table.load(std::memory_order_acquire);
+    
+    // The table is never full, so we will
+    // always run into an empty slot on a miss
+    for (uint32_t i = 0; ; i++) {
+      const Entry* entry = table->slots[(hash + i) & table->mask]
+        .load(std::memory_order_acquire);
+      
+      if (entry == nullptr)
+        return nullptr;
+      
+      if (entry->hash == hash && entry->format.matchesFormat(fmt))
+        return entry;
+    }
+  }
+  
+  
+  const DxvkRenderPassTable::Entry* DxvkRenderPassTable::insert(
+    const DxvkRenderPassFormat& fmt,
+          size_t                hash,
+    const Rc<DxvkRenderPass>&   renderPass) {
+    m_entries.emplace_back(new Entry { fmt, hash, renderPass });
+    const Entry* entry = m_entries.back().get();
+    
+    const Table* table = m_table.load(std::memory_order_relaxed);
+    
+    // Keep the load factor below one half. Readers may still
+    // be using the old table, so we cannot free it here.
+    if (2 * (++m_count) > table->mask + 1) {
+      m_tables.emplace_back(new Table(2 * (table->mask + 1)));
+      table = m_tables.back().get();
+      
+      for (const auto& e : m_entries)
+        insertEntry(table, e.get());
+      
+      m_table.store(table, std::memory_order_release);
+    } else {
+      insertEntry(table, entry);
+    }
+    
+    return entry;
+  }
+  
+  
+  const DxvkRenderPassTable::Entry* DxvkRenderPassTable::findHandle(
+          VkRenderPass          handle) const {
+    for (const auto& e : m_entries) {
+      if (e->renderPass->handle() == handle)
+        return e.get();
+    }
+    
+    return nullptr;
+  }
+  
+  
+  void DxvkRenderPassTable::insertEntry(
+    const Table*                  table,
+    const Entry*                  entry) {
+    uint32_t index = entry->hash & table->mask;
+    
+    while (table->slots[index].load(std::memory_order_relaxed) != nullptr)
+      index = (index + 1) & table->mask;
+    
+    table->slots[index].store(entry, std::memory_order_release);
   }
   
   
@@ -163,24 +335,43 @@ namespace dxvk {
   
   Rc<DxvkRenderPass> DxvkRenderPassPool::getRenderPass(
     const DxvkRenderPassFormat& fmt) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    const size_t hash = fmt.hash();
     
-    Rc<DxvkRenderPass> renderPass = nullptr;
+    const DxvkRenderPassTable::Entry* entry = m_table.find(fmt, hash);
     
-    for (uint32_t i = 0; i < m_renderPasses.size() && renderPass == nullptr; i++) {
-      if (m_renderPasses[i]->matchesFormat(fmt))
-        renderPass = m_renderPasses[i];
-    }
+    if (entry != nullptr)
+      return entry->renderPass;
+    
+    // Another thread may have created the
+    // render pass while we were waiting
+    std::lock_guard<std::mutex> lock(m_mutex);
     
-    if (renderPass != nullptr)
-      return renderPass;
+    entry = m_table.find(fmt, hash);
     
-    renderPass = this->createRenderPass(fmt);
-    m_renderPasses.push_back(renderPass);
+    if (entry != nullptr)
+      return entry->renderPass;
+    
+    Rc<DxvkRenderPass> renderPass = this->createRenderPass(fmt);
+    m_table.insert(fmt, hash, renderPass);
     return renderPass;
   }
   
   
+  bool DxvkRenderPassPool::getRenderPassFormat(
+          VkRenderPass          handle,
+          DxvkRenderPassFormat& fmt) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    const DxvkRenderPassTable::Entry* entry = m_table.findHandle(handle);
+    
+    if (entry == nullptr)
+      return false;
+    
+    fmt = entry->format;
+    return true;
+  }
+  
+  
   Rc<DxvkRenderPass> DxvkRenderPassPool::createRenderPass(
     const DxvkRenderPassFormat& fmt) {
     return new DxvkRenderPass(m_vkd, fmt);
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 
@@ -23,6 +25,41 @@ namespace dxvk {
   };
   
   
+  /**
+   * \brief Attachment load and store ops
+   * 
+   * By default, render passes load and store the
+   * previous contents of all attachments.
+   */
+  struct DxvkAttachmentOps {
+    VkAttachmentLoadOp  loadOp  = VK_ATTACHMENT_LOAD_OP_LOAD;
+    VkAttachmentStoreOp storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    
+    bool operator == (const DxvkAttachmentOps& other) const {
+      return loadOp  == other.loadOp
+          && storeOp == other.storeOp;
+    }
+  };
+  
+  
+  /**
+   * \brief Render pass ops
+   * 
+   * Load and store ops for all attachments of a render
+   * pass. These can be used to clear or discard the
+   * contents of attachments when the render pass
+   * begins, rather than loading them from memory.
+   */
+  struct DxvkRenderPassOps {
+    DxvkAttachmentOps depthOps;
+    DxvkAttachmentOps stencilOps;
+    
+    std::array<DxvkAttachmentOps, MaxNumRenderTargets> colorOps;
+    
+    bool operator == (const DxvkRenderPassOps& other) const;
+  };
+  
+  
   /**
    * \brief Render pass format
    * 
@@ -100,6 +137,14 @@ namespace dxvk {
      */
     bool matchesFormat(const DxvkRenderPassFormat& other) const;
     
+    /**
+     * \brief Computes hash of the render pass format
+     * 
+     * Formats that match have the same hash.
+     * \returns Hash over all formats and layouts
+     */
+    size_t hash() const;
+    
   private:
     
     std::array<DxvkRenderTargetFormat, MaxNumRenderTargets> m_color;
@@ -127,13 +172,29 @@ namespace dxvk {
     /**
      * \brief Render pass handle
      * 
-     * Internal use only.
+     * Returns the handle of the render pass that loads
+     * and stores all attachments. Render passes that
+     * only differ in their ops are compatible, so this
+     * handle can be used to create pipelines and
+     * framebuffers. Internal use only.
      * \returns Render pass handle
      */
     VkRenderPass handle() const {
       return m_renderPass;
     }
     
+    /**
+     * \brief Render pass handle for the given ops
+     * 
+     * Creates a new render pass object if no render
+     * pass with the given load and store ops has
+     * been created yet. Thread-safe.
+     * \param [in] ops Attachment load and store ops
+     * \returns Render pass handle
+     */
+    VkRenderPass getHandle(
+      const DxvkRenderPassOps& ops);
+    
     /**
      * \brief Render pass sample count
      * \returns Render pass sample count
@@ -155,12 +216,115 @@ namespace dxvk {
       return m_format.matchesFormat(format);
     }
     
+    /**
+     * \brief Render pass format
+     * \returns Render pass format
+     */
+    const DxvkRenderPassFormat& format() const {
+      return m_format;
+    }
+    
   private:
     
+    struct Instance {
+      DxvkRenderPassOps   ops;
+      VkRenderPass        handle;
+    };
+    
     Rc<vk::DeviceFn>      m_vkd;
     DxvkRenderPassFormat  m_format;
     VkRenderPass          m_renderPass;
     
+    std::mutex            m_mutex;
+    std::vector<Instance> m_instances;
+    
+    VkRenderPass createRenderPass(
+      const DxvkRenderPassOps& ops);
+    
+  };
+  
+  
+  /**
+   * \brief Render pass lookup table
+   * 
+   * Open-addressing hash table that maps render pass
+   * formats to render pass objects. Entries are never
+   * removed, and a table that runs out of space is
+   * replaced by a larger copy. Old tables are kept
+   * alive until the lookup table gets destroyed, so
+   * that lookups do not need to take a lock.
+   * 
+   * Lookups are thread-safe, but insertions must be
+   * synchronized with each other by the caller.
+   */
+  class DxvkRenderPassTable {
+    
+  public:
+    
+    struct Entry {
+      DxvkRenderPassFormat  format;
+      size_t                hash;
+      Rc<DxvkRenderPass>    renderPass;
+    };
+    
+    DxvkRenderPassTable();
+    ~DxvkRenderPassTable();
+    
+    /**
+     * \brief Looks up a render pass format
+     * 
+     * \param [in] fmt Render target formats
+     * \param [in] hash Hash of the render pass format
+     * \returns Matching entry, or \c nullptr
+     */
+    const Entry* find(
+      const DxvkRenderPassFormat& fmt,
+            size_t                hash) const;
+    
+    /**
+     * \brief Adds a render pass
+     * 
+     * The format must not already be in the table.
+     * \param [in] fmt Render target formats
+     * \param [in] hash Hash of the render pass format
+     * \param [in] renderPass The render pass object
+     * \returns The new entry
+     */
+    const Entry* insert(
+      const DxvkRenderPassFormat& fmt,
+            size_t                hash,
+      const Rc<DxvkRenderPass>&   renderPass);
+    
+    /**
+     * \brief Looks up a render pass by its handle
+     * 
+     * Unlike \ref find, this must not be called
+     * concurrently with \ref insert.
+     * \param [in] handle Render pass handle
+     * \returns Matching entry, or \c nullptr
+     */
+    const Entry* findHandle(
+            VkRenderPass          handle) const;
+    
+  private:
+    
+    struct Table {
+      Table(uint32_t size);
+      
+      uint32_t                                    mask;
+      std::unique_ptr<std::atomic<const Entry*>[]> slots;
+    };
+    
+    std::atomic<const Table*>           m_table = { nullptr };
+    uint32_t                            m_count = 0;
+    
+    std::vector<std::unique_ptr<Entry>> m_entries;
+    std::vector<std::unique_ptr<Table>> m_tables;
+    
+    static void insertEntry(
+      const Table*                  table,
+      const Entry*                  entry);
+    
   };
   
   
@@ -169,6 +333,8 @@ namespace dxvk {
    * 
    * Thread-safe class that manages the render pass
    * objects that are used within an application.
+   * Looking up existing render passes does not
+   * require a lock.
    */
   class DxvkRenderPassPool : public RcObject {
     
@@ -186,12 +352,23 @@ namespace dxvk {
     Rc<DxvkRenderPass> getRenderPass(
       const DxvkRenderPassFormat& fmt);
     
+    /**
+     * \brief Retrieves the format of a render pass
+     * 
+     * \param [in] handle Render pass handle
+     * \param [out] fmt Render target formats
+     * \returns \c true if the render pass was created by this pool
+     */
+    bool getRenderPassFormat(
+            VkRenderPass          handle,
+            DxvkRenderPassFormat& fmt);
+    
   private:
     
     Rc<vk::DeviceFn> m_vkd;
     
     std::mutex                      m_mutex;
-    std::vector<Rc<DxvkRenderPass>> m_renderPasses;
+    DxvkRenderPassTable             m_table;
     
     Rc<DxvkRenderPass> createRenderPass(
       const DxvkRenderPassFormat& fmt);
@@ -17,6 +17,10 @@ namespace dxvk {
    * Keeps track of whether the resource is currently in use
    * by the GPU. As soon as a command that uses the resource
    * is recorded, it will be marked as 'in use'.
+   * 
+   * In addition, the resource stores the sequence number
+   * of the last submission that used it, which allows the
+   * device to wait for that specific submission.
    */
   class DxvkResource : public RcObject {
     
@@ -31,9 +35,26 @@ namespace dxvk {
     void acquire() { m_useCount += 1; }
     void release() { m_useCount -= 1; }
     
+    /**
+     * \brief Last submission using the resource
+     * 
+     * Sequence number of the most recent command
+     * list submission that accessed the resource,
+     * or zero if the resource was never used.
+     * \returns Submission sequence number
+     */
+    uint64_t lastUse() const {
+      return m_lastUse.load();
+    }
+    
+    void setLastUse(uint64_t sequence) {
+      m_lastUse.store(sequence);
+    }
+    
   private:
     
     std::atomic<uint32_t> m_useCount = { 0u };
+    std::atomic<uint64_t> m_lastUse  = { 0ull };
     
   };
   
@@ -7,6 +7,8 @@
 
 #include "../spirv/spirv_code_buffer.h"
 
+#include "../util/sha1/sha1_util.h"
+
 namespace dxvk {
   
   /**
@@ -170,6 +172,30 @@ namespace dxvk {
       m_debugName = name;
     }
     
+    /**
+     * \brief Shader key
+     * 
+     * Identifies the shader across runs of the
+     * application. If no key has been set, all
+     * bytes of the returned digest are zero.
+     * \returns The shader key
+     */
+    const Sha1Digest& shaderKey() const {
+      return m_shaderKey;
+    }
+    
+    /**
+     * \brief Sets the shader key
+     * 
+     * Should be a hash of the original shader code
+     * so that the state cache can identify pipelines
+     * that use this shader in subsequent runs.
+     * \param [in] key The shader key
+     */
+    void setShaderKey(const Sha1Hash& key) {
+      std::memcpy(m_shaderKey.data(), key.digest(), m_shaderKey.size());
+    }
+    
   private:
     
     VkShaderStageFlagBits m_stage;
@@ -179,6 +205,7 @@ namespace dxvk {
     std::vector<size_t>           m_idOffsets;
     DxvkInterfaceSlots            m_interface;
     std::string                   m_debugName;
+    Sha1Digest                    m_shaderKey = { };
     
   };
   
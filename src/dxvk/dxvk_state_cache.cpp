@@ -0,0 +1,210 @@
+#include <cstring>
+
+#include "dxvk_state_cache.h"
+
+namespace dxvk {
+  
+  bool DxvkStateCacheKey::operator == (const DxvkStateCacheKey& other) const {
+    return vs  == other.vs
+        && tcs == other.tcs
+        && tes == other.tes
+        && gs  == other.gs
+        && fs  == other.fs;
+  }
+  
+  
+  size_t DxvkStateCacheKey::hash() const {
+    DxvkHashState result;
+    
+    for (const Sha1Digest* digest : { &vs, &tcs, &tes, &gs, &fs }) {
+      uint32_t word;
+      std::memcpy(&word, digest->data(), sizeof(word));
+      result.add(word);
+    }
+    
+    return result;
+  }
+  
+  
+  DxvkStateCache::DxvkStateCache(
+    const Rc<DxvkRenderPassPool>& passPool,
+    const std::string&            fileName)
+  : m_passPool(passPool),
+    m_fileName(fileName) {
+    bool valid = this->readCacheFile();
+    
+    if (m_entryCount != 0) {
+      Logger::info(str::format("DxvkStateCache: Read ",
+        m_entryCount, " pipelines from ", m_fileName));
+    }
+    
+    // Append new entries to the existing file, or start
+    // a new file if the existing one cannot be used.
+    if (valid) {
+      m_file = std::ofstream(m_fileName, std::ios::binary | std::ios::app);
+    } else {
+      m_file = std::ofstream(m_fileName, std::ios::binary | std::ios::trunc);
+      
+      DxvkStateCacheHeader header;
+      std::memcpy(header.magic, "DXVK", 4);
+      header.version   = CacheVersion;
+      header.entrySize = sizeof(DxvkStateCacheEntry);
+      
+      m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      m_file.flush();
+    }
+    
+    if (m_file)
+      m_writerThread = std::thread([this] () { this->runWriter(); });
+  }
+  
+  
+  DxvkStateCache::~DxvkStateCache() {
+    { std::lock_guard<std::mutex> lock(m_writerMutex);
+      m_stopWriter = true;
+    }
+    
+    m_writerCond.notify_one();
+    
+    if (m_writerThread.joinable())
+      m_writerThread.join();
+  }
+  
+  
+  size_t DxvkStateCache::entryCount() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entryCount;
+  }
+  
+  
+  void DxvkStateCache::addPipeline(
+    const DxvkStateCacheKey&             shaders,
+    const DxvkGraphicsPipelineStateInfo& state) {
+    // Shaders created internally have no key, and
+    // pipelines using them cannot be identified
+    if (shaders.vs == Sha1Digest())
+      return;
+    
+    DxvkStateCacheEntry entry;
+    entry.shaders = shaders;
+    entry.state   = state;
+    entry.state.omRenderPass = VK_NULL_HANDLE;
+    
+    if (!m_passPool->getRenderPassFormat(state.omRenderPass, entry.format))
+      return;
+    
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (this->findEntry(entry))
+      return;
+    
+    m_entries[shaders].push_back(entry);
+    m_entryCount += 1;
+    
+    // Writing to the file may stall, so leave
+    // that to the writer thread if there is one
+    if (m_writerThread.joinable()) {
+      std::lock_guard<std::mutex> writerLock(m_writerMutex);
+      m_writerQueue.push_back(entry);
+      m_writerCond.notify_one();
+    }
+  }
+  
+  
+  void DxvkStateCache::prewarmPipeline(
+    const Rc<DxvkGraphicsPipeline>& pipeline) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    // Every context creates its own pipeline objects, but
+    // the pipelines only need to be compiled once, after
+    // which the Vulkan pipeline cache makes them cheap.
+    if (!m_prewarmed.insert(pipeline->shaderKey()).second)
+      return;
+    
+    auto list = m_entries.find(pipeline->shaderKey());
+    
+    if (list == m_entries.end())
+      return;
+    
+    for (const DxvkStateCacheEntry& entry : list->second) {
+      DxvkGraphicsPipelineStateInfo state = entry.state;
+      state.omRenderPass = m_passPool->getRenderPass(entry.format)->handle();
+      pipeline->prewarmInstance(state);
+    }
+  }
+  
+  
+  bool DxvkStateCache::readCacheFile() {
+    std::ifstream file(m_fileName, std::ios::binary);
+    
+    if (!file)
+      return false;
+    
+    DxvkStateCacheHeader header;
+    
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+     || std::memcmp(header.magic, "DXVK", 4)
+     || header.version   != CacheVersion
+     || header.entrySize != sizeof(DxvkStateCacheEntry)) {
+      Logger::warn(str::format("DxvkStateCache: Ignoring ", m_fileName));
+      return false;
+    }
+    
+    // If the application crashed while writing an entry,
+    // the last entry may be incomplete, so we'll drop it.
+    DxvkStateCacheEntry entry;
+    
+    while (file.read(reinterpret_cast<char*>(&entry), sizeof(entry))) {
+      if (!this->findEntry(entry)) {
+        m_entries[entry.shaders].push_back(entry);
+        m_entryCount += 1;
+      }
+    }
+    
+    return true;
+  }
+  
+  
+  bool DxvkStateCache::findEntry(
+    const DxvkStateCacheEntry& entry) const {
+    auto list = m_entries.find(entry.shaders);
+    
+    if (list == m_entries.end())
+      return false;
+    
+    for (const DxvkStateCacheEntry& e : list->second) {
+      if (e.state == entry.state && e.format.matchesFormat(entry.format))
+        return true;
+    }
+    
+    return false;
+  }
+  
+  
+  void DxvkStateCache::runWriter() {
+    std::vector<DxvkStateCacheEntry> entries;
+    
+    while (true) {
+      { std::unique_lock<std::mutex> lock(m_writerMutex);
+        
+        m_writerCond.wait(lock, [this] () {
+          return m_stopWriter || !m_writerQueue.empty();
+        });
+        
+        if (m_writerQueue.empty())
+          return;
+        
+        std::swap(entries, m_writerQueue);
+      }
+      
+      // Write all entries that were added in the
+      // meantime with a single flush at the end
+      for (const DxvkStateCacheEntry& entry : entries)
+        m_file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+      
+      m_file.flush();
+      entries.clear();
+    }
+  }
+  
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "dxvk_graphics.h"
+#include "dxvk_renderpass.h"
+#include "dxvk_state_cache_types.h"
+
+namespace dxvk {
+  
+  /**
+   * \brief State cache file header
+   * 
+   * The entry size is stored so that files written
+   * by builds with a different state vector layout
+   * are discarded rather than misinterpreted.
+   */
+  struct DxvkStateCacheHeader {
+    char        magic[4];
+    uint32_t    version;
+    uint32_t    entrySize;
+  };
+  
+  
+  /**
+   * \brief State cache entry
+   * 
+   * Stores a pipeline state vector along with the keys
+   * of the shaders it was used with. Since render pass
+   * handles are not persistent, the render pass format
+   * is stored instead and resolved when loading.
+   */
+  struct DxvkStateCacheEntry {
+    DxvkStateCacheKey             shaders;
+    DxvkRenderPassFormat          format;
+    DxvkGraphicsPipelineStateInfo state;
+  };
+  
+  
+  /**
+   * \brief State cache
+   * 
+   * Records the state vectors of all graphics pipelines
+   * that are created by the application, so that these
+   * pipelines can be compiled ahead of time in subsequent
+   * runs as soon as the shaders become available. This
+   * also avoids the cost of linking pipelines, which a
+   * Vulkan pipeline cache on its own cannot hide.
+   * 
+   * New entries are written to the file on a separate
+   * thread so that the thread creating the pipeline
+   * does not have to wait for file I/O.
+   */
+  class DxvkStateCache : public RcObject {
+    constexpr static uint32_t CacheVersion = 1;
+  public:
+    
+    DxvkStateCache(
+      const Rc<DxvkRenderPassPool>& passPool,
+      const std::string&            fileName);
+    ~DxvkStateCache();
+    
+    /**
+     * \brief Number of cached pipelines
+     * 
+     * Includes pipelines loaded from the state
+     * cache file as well as newly added ones.
+     * \returns Number of cached state vectors
+     */
+    size_t entryCount();
+    
+    /**
+     * \brief Adds a pipeline to the cache
+     * 
+     * Records the state vector in the cache file if
+     * it is not already known. Called whenever a new
+     * pipeline is created for a given shader set.
+     * \param [in] shaders Shader keys of the pipeline
+     * \param [in] state Pipeline state vector
+     */
+    void addPipeline(
+      const DxvkStateCacheKey&             shaders,
+      const DxvkGraphicsPipelineStateInfo& state);
+    
+    /**
+     * \brief Compiles known pipelines ahead of time
+     * 
+     * Queues all cached state vectors that match the
+     * shaders of the given pipeline for compilation.
+     * Does nothing if pipelines with the same shaders
+     * have already been compiled on this device.
+     * \param [in] pipeline The graphics pipeline
+     */
+    void prewarmPipeline(
+      const Rc<DxvkGraphicsPipeline>& pipeline);
+      
+  private:
+    
+    Rc<DxvkRenderPassPool> m_passPool;
+    
+    std::mutex    m_mutex;
+    std::string   m_fileName;
+    std::ofstream m_file;
+    size_t        m_entryCount = 0;
+    
+    std::unordered_map<
+      DxvkStateCacheKey,
+      std::vector<DxvkStateCacheEntry>,
+      DxvkHash> m_entries;
+    
+    std::unordered_set<
+      DxvkStateCacheKey,
+      DxvkHash> m_prewarmed;
+    
+    std::mutex                        m_writerMutex;
+    std::condition_variable           m_writerCond;
+    std::vector<DxvkStateCacheEntry>  m_writerQueue;
+    bool                              m_stopWriter = false;
+    std::thread                       m_writerThread;
+    
+    bool readCacheFile();
+    
+    bool findEntry(
+      const DxvkStateCacheEntry& entry) const;
+    
+    void runWriter();
+      
+  };
+  
+}
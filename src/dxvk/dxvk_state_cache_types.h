@@ -0,0 +1,28 @@
+#pragma once
+
+#include "dxvk_include.h"
+
+#include "../util/sha1/sha1_util.h"
+
+namespace dxvk {
+  
+  /**
+   * \brief State cache key
+   * 
+   * Identifies the set of shaders used by a graphics
+   * pipeline. Stores the shader keys of all stages,
+   * unused stages have a key consisting of zeroes.
+   */
+  struct DxvkStateCacheKey {
+    Sha1Digest vs  = { };
+    Sha1Digest tcs = { };
+    Sha1Digest tes = { };
+    Sha1Digest gs  = { };
+    Sha1Digest fs  = { };
+    
+    bool operator == (const DxvkStateCacheKey& other) const;
+    
+    size_t hash() const;
+  };
+  
+}
@@ -14,13 +14,24 @@ namespace dxvk {
     CmdDrawCalls,             ///< Number of draw calls
     CmdDispatchCalls,         ///< Number of compute calls
     CmdRenderPassCount,       ///< Number of render passes
+    DescriptorSetCount,       ///< Number of descriptor sets allocated
+    DescriptorSetReused,      ///< Number of descriptor sets reused from the cache
     MemoryAllocationCount,    ///< Number of memory allocations
     MemoryAllocated,          ///< Amount of memory allocated
     MemoryUsed,               ///< Amount of memory used
     PipeCountGraphics,        ///< Number of graphics pipelines
     PipeCountCompute,         ///< Number of compute pipelines
+    PipeCountPending,         ///< Number of pipelines being compiled
     QueueSubmitCount,         ///< Number of command buffer submissions
     QueuePresentCount,        ///< Number of present calls / frames
+    UploadRingAllocated,      ///< Amount of memory allocated for the upload ring
+    UploadRingUsed,           ///< Amount of upload ring memory in use
+    DescriptorPoolCount,      ///< Number of descriptor pools
+    DescriptorPoolsUsed,      ///< Number of descriptor pools owned by command lists
+    DescriptorPoolSize,       ///< Number of sets per newly created descriptor pool
+    FramebufferCount,         ///< Number of cached framebuffer objects
+    FramebufferCacheHits,     ///< Number of framebuffer cache hits
+    FramebufferCacheMisses,   ///< Number of framebuffer objects created
     NumCounters,              ///< Number of counters available
   };
   
@@ -126,12 +126,12 @@ namespace dxvk {
     swapInfo.clipped                = VK_TRUE;
     swapInfo.oldSwapchain           = VK_NULL_HANDLE;
     
-    Logger::debug(str::format(
+    Logger::debugf(
       "DxvkSwapchain: Actual swap chain properties: ",
       "\n  Format:       ", swapInfo.imageFormat,
       "\n  Present mode: ", swapInfo.presentMode,
       "\n  Buffer size:  ", swapInfo.imageExtent.width, "x", swapInfo.imageExtent.height,
-      "\n  Image count:  ", swapInfo.minImageCount));
+      "\n  Image count:  ", swapInfo.minImageCount);
     
     if (m_vkd->vkCreateSwapchainKHR(m_vkd->device(), &swapInfo, nullptr, &m_handle) != VK_SUCCESS)
       throw DxvkError("DxvkSwapchain: Failed to recreate swap chain");
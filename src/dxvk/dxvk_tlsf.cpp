@@ -0,0 +1,300 @@
+#include "dxvk_tlsf.h"
+
+namespace dxvk {
+  
+  DxvkTlsfAllocator::DxvkTlsfAllocator(VkDeviceSize size)
+  : m_size(size) {
+    for (uint32_t i = 0; i < FlCount; i++) {
+      m_slBitmap[i] = 0;
+      
+      for (uint32_t j = 0; j < SlCount; j++)
+        m_freeLists[i][j] = InvalidBlock;
+    }
+    
+    // Mark the entire range as free
+    uint32_t block = this->createBlock(0, size, InvalidBlock, InvalidBlock);
+    this->insertFreeBlock(block);
+  }
+  
+  
+  DxvkTlsfAllocator::~DxvkTlsfAllocator() {
+    
+  }
+  
+  
+  VkDeviceSize DxvkTlsfAllocator::alloc(
+          VkDeviceSize size,
+          VkDeviceSize align) {
+    const VkDeviceSize length = allocSize(size);
+    
+    align = std::max(align, Granularity);
+    
+    // Blocks in the matching size class are usually aligned
+    // well enough, so only reserve space for padding if the
+    // first candidate cannot satisfy the alignment.
+    uint32_t block = this->findFreeBlock(length);
+    
+    if (block != InvalidBlock) {
+      const Block& candidate = m_blocks[block];
+      
+      if (dxvk::align(candidate.offset, align) + length > candidate.offset + candidate.length)
+        block = InvalidBlock;
+    }
+    
+    if (block == InvalidBlock && align > Granularity)
+      block = this->findFreeBlock(length + align - Granularity);
+    
+    if (block == InvalidBlock)
+      return InvalidOffset;
+    
+    this->removeFreeBlock(block);
+    
+    // Return the unused parts of the block to the
+    // free lists so that they can be used again.
+    const VkDeviceSize blockStart = m_blocks[block].offset;
+    const VkDeviceSize allocStart = dxvk::align(blockStart, align);
+    
+    if (allocStart != blockStart) {
+      uint32_t padding = block;
+      block = this->splitBlock(padding, allocStart - blockStart);
+      this->insertFreeBlock(padding);
+    }
+    
+    if (m_blocks[block].length != length)
+      this->insertFreeBlock(this->splitBlock(block, length));
+    
+    m_blocks[block].isFree = false;
+    m_usedBlocks.emplace(allocStart, block);
+    return allocStart;
+  }
+  
+  
+  void DxvkTlsfAllocator::free(
+          VkDeviceSize offset) {
+    auto entry = m_usedBlocks.find(offset);
+    
+    if (entry == m_usedBlocks.end())
+      return;
+    
+    uint32_t block = entry->second;
+    m_usedBlocks.erase(entry);
+    
+    // Merge the block with its physical neighbours. Since
+    // adjacent free blocks are always merged, there can be
+    // at most one free block on either side.
+    uint32_t next = m_blocks[block].nextPhys;
+    
+    if (next != InvalidBlock && m_blocks[next].isFree) {
+      this->removeFreeBlock(next);
+      
+      m_blocks[block].length  += m_blocks[next].length;
+      m_blocks[block].nextPhys = m_blocks[next].nextPhys;
+      
+      if (m_blocks[block].nextPhys != InvalidBlock)
+        m_blocks[m_blocks[block].nextPhys].prevPhys = block;
+      
+      this->destroyBlock(next);
+    }
+    
+    uint32_t prev = m_blocks[block].prevPhys;
+    
+    if (prev != InvalidBlock && m_blocks[prev].isFree) {
+      this->removeFreeBlock(prev);
+      
+      m_blocks[prev].length  += m_blocks[block].length;
+      m_blocks[prev].nextPhys = m_blocks[block].nextPhys;
+      
+      if (m_blocks[prev].nextPhys != InvalidBlock)
+        m_blocks[m_blocks[prev].nextPhys].prevPhys = prev;
+      
+      this->destroyBlock(block);
+      block = prev;
+    }
+    
+    this->insertFreeBlock(block);
+  }
+  
+  
+  DxvkTlsfStats DxvkTlsfAllocator::getStats() const {
+    DxvkTlsfStats result;
+    
+    for (uint32_t fl = 0; fl < FlCount; fl++) {
+      for (uint32_t sl = 0; sl < SlCount; sl++) {
+        for (uint32_t block = m_freeLists[fl][sl]; block != InvalidBlock; block = m_blocks[block].nextFree) {
+          result.freeSize        += m_blocks[block].length;
+          result.freeBlockCount  += 1;
+          result.largestFreeBlock = std::max(result.largestFreeBlock, m_blocks[block].length);
+        }
+      }
+    }
+    
+    result.usedSize       = m_size - result.freeSize;
+    result.usedBlockCount = m_usedBlocks.size();
+    return result;
+  }
+  
+  
+  uint32_t DxvkTlsfAllocator::createBlock(
+          VkDeviceSize  offset,
+          VkDeviceSize  length,
+          uint32_t      prevPhys,
+          uint32_t      nextPhys) {
+    Block block;
+    block.offset   = offset;
+    block.length   = length;
+    block.prevPhys = prevPhys;
+    block.nextPhys = nextPhys;
+    block.prevFree = InvalidBlock;
+    block.nextFree = InvalidBlock;
+    block.isFree   = false;
+    
+    if (m_unusedBlocks.size() != 0) {
+      uint32_t index = m_unusedBlocks.back();
+      m_unusedBlocks.pop_back();
+      m_blocks[index] = block;
+      return index;
+    }
+    
+    m_blocks.push_back(block);
+    return m_blocks.size() - 1;
+  }
+  
+  
+  void DxvkTlsfAllocator::destroyBlock(
+          uint32_t      block) {
+    m_unusedBlocks.push_back(block);
+  }
+  
+  
+  uint32_t DxvkTlsfAllocator::splitBlock(
+          uint32_t      block,
+          VkDeviceSize  length) {
+    uint32_t next = this->createBlock(
+      m_blocks[block].offset + length,
+      m_blocks[block].length - length,
+      block, m_blocks[block].nextPhys);
+    
+    if (m_blocks[next].nextPhys != InvalidBlock)
+      m_blocks[m_blocks[next].nextPhys].prevPhys = next;
+    
+    m_blocks[block].length   = length;
+    m_blocks[block].nextPhys = next;
+    return next;
+  }
+  
+  
+  void DxvkTlsfAllocator::insertFreeBlock(
+          uint32_t      block) {
+    SizeClass sc = getSizeClass(m_blocks[block].length);
+    uint32_t head = m_freeLists[sc.fl][sc.sl];
+    
+    m_blocks[block].isFree   = true;
+    m_blocks[block].prevFree = InvalidBlock;
+    m_blocks[block].nextFree = head;
+    
+    if (head != InvalidBlock)
+      m_blocks[head].prevFree = block;
+    
+    m_freeLists[sc.fl][sc.sl] = block;
+    m_slBitmap[sc.fl] |= 1u << sc.sl;
+    m_flBitmap        |= 1u << sc.fl;
+  }
+  
+  
+  void DxvkTlsfAllocator::removeFreeBlock(
+          uint32_t      block) {
+    SizeClass sc = getSizeClass(m_blocks[block].length);
+    
+    uint32_t prev = m_blocks[block].prevFree;
+    uint32_t next = m_blocks[block].nextFree;
+    
+    if (prev != InvalidBlock)
+      m_blocks[prev].nextFree = next;
+    else
+      m_freeLists[sc.fl][sc.sl] = next;
+    
+    if (next != InvalidBlock)
+      m_blocks[next].prevFree = prev;
+    
+    m_blocks[block].isFree = false;
+    
+    if (m_freeLists[sc.fl][sc.sl] == InvalidBlock) {
+      m_slBitmap[sc.fl] &= ~(1u << sc.sl);
+      
+      if (m_slBitmap[sc.fl] == 0)
+        m_flBitmap &= ~(1u << sc.fl);
+    }
+  }
+  
+  
+  uint32_t DxvkTlsfAllocator::findFreeBlock(
+          VkDeviceSize  length) const {
+    // Round the size up to the start of the next size class
+    // so that any block in the class we start searching in
+    // is guaranteed to be large enough.
+    VkDeviceSize units = length / Granularity;
+    
+    if (units >= SlCount)
+      units += (VkDeviceSize(1) << (findMsb(units) - SlBits)) - 1;
+    
+    SizeClass sc = getSizeClass(units * Granularity);
+    
+    if (sc.fl >= FlCount)
+      return InvalidBlock;
+    
+    uint32_t slMap = m_slBitmap[sc.fl] & (~0u << sc.sl);
+    
+    if (slMap == 0) {
+      uint32_t flMap = sc.fl + 1 < FlCount
+        ? m_flBitmap & (~0u << (sc.fl + 1))
+        : 0u;
+      
+      if (flMap == 0)
+        return InvalidBlock;
+      
+      sc.fl = findLsb(flMap);
+      slMap = m_slBitmap[sc.fl];
+    }
+    
+    sc.sl = findLsb(slMap);
+    return m_freeLists[sc.fl][sc.sl];
+  }
+  
+  
+  DxvkTlsfAllocator::SizeClass DxvkTlsfAllocator::getSizeClass(
+          VkDeviceSize  length) {
+    const VkDeviceSize units = length / Granularity;
+    
+    if (units < SlCount)
+      return { 0u, uint32_t(units) };
+    
+    const uint32_t msb = findMsb(units);
+    
+    return { msb - SlBits + 1,
+      uint32_t(units >> (msb - SlBits)) ^ SlCount };
+  }
+  
+  
+  uint32_t DxvkTlsfAllocator::findMsb(
+          uint64_t      value) {
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+#else
+    uint32_t result = 0;
+    while (value >>= 1)
+      result += 1;
+    return result;
+#endif
+  }
+  
+  
+  uint32_t DxvkTlsfAllocator::findLsb(
+          uint32_t      value) {
+#if defined(__GNUC__)
+    return __builtin_ctz(value);
+#else
+    return bit::tzcnt(value);
+#endif
+  }
+  
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "dxvk_include.h"
+
+namespace dxvk {
+  
+  /**
+   * \brief TLSF allocator stats
+   *
+   * Used to judge how fragmented the
+   * address range of an allocator is.
+   */
+  struct DxvkTlsfStats {
+    VkDeviceSize usedSize         = 0;
+    VkDeviceSize freeSize         = 0;
+    VkDeviceSize largestFreeBlock = 0;
+    uint32_t     usedBlockCount   = 0;
+    uint32_t     freeBlockCount   = 0;
+    
+    /**
+     * \brief External fragmentation
+     *
+     * Ratio of free memory that cannot be used to
+     * service an allocation of the largest possible
+     * size. Zero means that all free memory is in
+     * one contiguous block.
+     * \returns Fragmentation, between 0 and 1
+     */
+    double fragmentation() const {
+      return freeSize != 0
+        ? 1.0 - double(largestFreeBlock) / double(freeSize)
+        : 0.0;
+    }
+  };
+  
+  
+  /**
+   * \brief Two-level segregated fit allocator
+   *
+   * Sub-allocates ranges from a fixed address range. Free
+   * blocks are sorted into size classes, with one bit per
+   * class indicating whether the class has any free blocks,
+   * so that both allocating and freeing a block take
+   * constant time regardless of how fragmented the range
+   * is. Adjacent free blocks are merged immediately.
+   *
+   * This only manages offsets and does not own any memory.
+   * It is not thread-safe.
+   */
+  class DxvkTlsfAllocator {
+    
+  public:
+    
+    /// Allocation granularity, in bytes
+    constexpr static VkDeviceSize Granularity = 256;
+    
+    /// Returned on failed allocations
+    constexpr static VkDeviceSize InvalidOffset = ~VkDeviceSize(0);
+    
+    DxvkTlsfAllocator(VkDeviceSize size);
+    ~DxvkTlsfAllocator();
+    
+    /**
+     * \brief Total size of the address range
+     * \returns Size of the address range
+     */
+    VkDeviceSize size() const {
+      return m_size;
+    }
+    
+    /**
+     * \brief Checks whether any blocks are allocated
+     * \returns \c true if the entire range is free
+     */
+    bool isEmpty() const {
+      return m_usedBlocks.size() == 0;
+    }
+    
+    /**
+     * \brief Size of an allocation
+     *
+     * Allocation sizes are rounded up to a multiple
+     * of the allocation granularity. This is the
+     * amount of memory actually consumed.
+     * \param [in] size Requested size
+     * \returns Allocated size
+     */
+    static VkDeviceSize allocSize(VkDeviceSize size) {
+      return dxvk::align(std::max<VkDeviceSize>(size, 1), Granularity);
+    }
+    
+    /**
+     * \brief Allocates a range
+     *
+     * \param [in] size Number of bytes to allocate
+     * \param [in] align Required alignment
+     * \returns Offset of the allocated range, or
+     *    \c InvalidOffset if no block is big enough.
+     */
+    VkDeviceSize alloc(
+            VkDeviceSize size,
+            VkDeviceSize align);
+    
+    /**
+     * \brief Frees a range
+     *
+     * \param [in] offset Offset of a range that
+     *    was previously returned by \ref alloc.
+     */
+    void free(
+            VkDeviceSize offset);
+    
+    /**
+     * \brief Computes allocator stats
+     *
+     * This needs to iterate over all blocks
+     * and is not meant to be called often.
+     * \returns Allocator stats
+     */
+    DxvkTlsfStats getStats() const;
+    
+  private:
+    
+    constexpr static uint32_t SlBits   = 4;
+    constexpr static uint32_t SlCount  = 1u << SlBits;
+    constexpr static uint32_t FlCount  = 32;
+    constexpr static uint32_t InvalidBlock = ~0u;
+    
+    struct Block {
+      VkDeviceSize offset;
+      VkDeviceSize length;
+      uint32_t     prevPhys;
+      uint32_t     nextPhys;
+      uint32_t     prevFree;
+      uint32_t     nextFree;
+      bool         isFree;
+    };
+    
+    struct SizeClass {
+      uint32_t fl;
+      uint32_t sl;
+    };
+    
+    VkDeviceSize          m_size;
+    
+    std::vector<Block>    m_blocks;
+    std::vector<uint32_t> m_unusedBlocks;
+    
+    uint32_t              m_flBitmap = 0;
+    uint32_t              m_slBitmap[FlCount];
+    uint32_t              m_freeLists[FlCount][SlCount];
+    
+    std::unordered_map<VkDeviceSize, uint32_t> m_usedBlocks;
+    
+    uint32_t createBlock(
+            VkDeviceSize  offset,
+            VkDeviceSize  length,
+            uint32_t      prevPhys,
+            uint32_t      nextPhys);
+    
+    void destroyBlock(
+            uint32_t      block);
+    
+    uint32_t splitBlock(
+            uint32_t      block,
+            VkDeviceSize  length);
+    
+    void insertFreeBlock(
+            uint32_t      block);
+    
+    void removeFreeBlock(
+            uint32_t      block);
+    
+    uint32_t findFreeBlock(
+            VkDeviceSize  length) const;
+    
+    static SizeClass getSizeClass(
+            VkDeviceSize  length);
+    
+    static uint32_t findMsb(
+            uint64_t      value);
+    
+    static uint32_t findLsb(
+            uint32_t      value);
+    
+  };
+  
+}
@@ -0,0 +1,236 @@
+#include "dxvk_device.h"
+#include "dxvk_upload_ring.h"
+
+namespace dxvk {
+  
+  constexpr VkBufferUsageFlags DxvkUploadRingUsage
+    = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+    | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+    | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
+    | VK_BUFFER_USAGE_INDEX_BUFFER_BIT
+    | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+  
+  constexpr VkMemoryPropertyFlags DxvkUploadRingMemFlags
+    = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+    | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  
+  
+  DxvkUploadRing::DxvkUploadRing(DxvkDevice* device)
+  : m_device(device) {
+    
+  }
+  
+  
+  DxvkUploadRing::~DxvkUploadRing() {
+    
+  }
+  
+  
+  bool DxvkUploadRing::isSupported(
+    const DxvkBufferCreateInfo& info,
+          VkMemoryPropertyFlags memFlags) {
+    return info.size <= MaxSliceSize
+        && memFlags == DxvkUploadRingMemFlags
+        && (info.usage & ~DxvkUploadRingUsage) == 0;
+  }
+  
+  
+  DxvkPhysicalBufferSlice DxvkUploadRing::alloc(
+          VkDeviceSize          length) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    const VkDeviceSize allocSize  = align(length, SliceAlign);
+    const uint32_t     blockCount = allocSize / SliceAlign;
+    
+    if (!this->findSpace(blockCount)
+     && !this->createPage())
+      return DxvkPhysicalBufferSlice();
+    
+    Page& page = m_pages[m_headPage];
+    
+    DxvkPhysicalBufferSlice slice(page.buffer, m_headBlock * SliceAlign, length,
+      new DxvkUploadSlice(this, m_headPage, m_headBlock * SliceAlign, allocSize));
+    
+    this->updateLiveMask(page, m_headBlock, blockCount, true);
+    
+    if (page.liveCount++ == 0)
+      m_idleCount -= 1;
+    
+    m_headBlock  += blockCount;
+    m_memoryUsed += allocSize;
+    return slice;
+  }
+  
+  
+  void DxvkUploadRing::free(
+          uint32_t              pageIndex,
+          VkDeviceSize          offset,
+          VkDeviceSize          allocSize) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    Page& page = m_pages[pageIndex];
+    
+    this->updateLiveMask(page,
+      offset    / SliceAlign,
+      allocSize / SliceAlign, false);
+    
+    if (--page.liveCount == 0)
+      m_idleCount += 1;
+    
+    m_memoryUsed -= allocSize;
+  }
+  
+  
+  DxvkUploadRingStats DxvkUploadRing::getStats() const {
+    DxvkUploadRingStats result;
+    result.memoryAllocated = m_memoryAllocated.load();
+    result.memoryUsed      = m_memoryUsed.load();
+    return result;
+  }
+  
+  
+  bool DxvkUploadRing::findSpace(
+          uint32_t              blockCount) {
+    // Walk the ring starting at the current position,
+    // skipping over slices that are still alive. Since
+    // slices are usually freed in the order they were
+    // allocated, this rarely needs more than one step.
+    // The page we start in is visited twice in case
+    // there is space before the current position.
+    for (size_t i = 0; i <= m_pages.size(); i++) {
+      if (m_headPage < m_pages.size() && m_pages[m_headPage].buffer != nullptr) {
+        const Page& page = m_pages[m_headPage];
+        
+        while (m_headBlock + blockCount <= BlocksPerPage) {
+          uint32_t liveBlock = findLastLiveBlock(page, m_headBlock, blockCount);
+          
+          if (liveBlock == BlocksPerPage)
+            return true;
+          
+          m_headBlock = liveBlock + 1;
+        }
+      }
+      
+      this->advancePage();
+    }
+    
+    return false;
+  }
+  
+  
+  bool DxvkUploadRing::createPage() {
+    if (m_pageCount >= MaxPages)
+      return false;
+    
+    DxvkBufferCreateInfo info;
+    info.size   = PageSize;
+    info.usage  = DxvkUploadRingUsage;
+    info.stages = VK_PIPELINE_STAGE_HOST_BIT
+                | VK_PIPELINE_STAGE_TRANSFER_BIT
+                | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT
+                | VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT
+                | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    info.access = VK_ACCESS_HOST_WRITE_BIT
+                | VK_ACCESS_TRANSFER_READ_BIT
+                | VK_ACCESS_TRANSFER_WRITE_BIT
+                | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
+                | VK_ACCESS_INDEX_READ_BIT
+                | VK_ACCESS_UNIFORM_READ_BIT;
+    
+    Page page;
+    page.buffer    = m_device->allocPhysicalBuffer(info, DxvkUploadRingMemFlags);
+    page.liveCount = 0;
+    page.liveMask.fill(0);
+    
+    // Page indices are stored in slices, so slots of
+    // released pages are reused rather than removed.
+    auto slot = std::find_if(m_pages.begin(), m_pages.end(),
+      [] (const Page& p) { return p.buffer == nullptr; });
+    
+    if (slot == m_pages.end())
+      slot = m_pages.insert(slot, std::move(page));
+    else
+      *slot = std::move(page);
+    
+    m_headPage  = slot - m_pages.begin();
+    m_headBlock = 0;
+    
+    m_pageCount += 1;
+    m_idleCount += 1;
+    
+    m_memoryAllocated += PageSize;
+    return true;
+  }
+  
+  
+  void DxvkUploadRing::advancePage() {
+    if (m_pages.empty())
+      return;
+    
+    m_headPage  = (m_headPage + 1) % m_pages.size();
+    m_headBlock = 0;
+    
+    // Release pages that are not needed anymore once the
+    // ring wraps around to them. Pages still referenced
+    // by command lists stay alive until those complete.
+    Page& page = m_pages[m_headPage];
+    
+    if (page.buffer != nullptr && page.liveCount == 0
+     && m_idleCount > MaxIdlePages) {
+      page.buffer = nullptr;
+      
+      m_pageCount -= 1;
+      m_idleCount -= 1;
+      
+      m_memoryAllocated -= PageSize;
+    }
+  }
+  
+  
+  void DxvkUploadRing::updateLiveMask(
+          Page&                 page,
+          uint32_t              first,
+          uint32_t              count,
+          bool                  live) {
+    for (uint32_t i = first; i < first + count; i++) {
+      const uint64_t bit = 1ull << (i % 64);
+      
+      if (live)
+        page.liveMask[i / 64] |=  bit;
+      else
+        page.liveMask[i / 64] &= ~bit;
+    }
+  }
+  
+  
+  uint32_t DxvkUploadRing::findLastLiveBlock(
+    const Page&                 page,
+          uint32_t              first,
+          uint32_t              count) {
+    for (uint32_t i = first + count; i > first; i--) {
+      if (page.liveMask[(i - 1) / 64] & (1ull << ((i - 1) % 64)))
+        return i - 1;
+    }
+    
+    return BlocksPerPage;
+  }
+  
+  
+  DxvkUploadSlice::DxvkUploadSlice(
+          DxvkUploadRing*       ring,
+          uint32_t              pageIndex,
+          VkDeviceSize          offset,
+          VkDeviceSize          allocSize)
+  : m_ring      (ring),
+    m_pageIndex (pageIndex),
+    m_offset    (offset),
+    m_allocSize (allocSize) {
+    
+  }
+  
+  
+  DxvkUploadSlice::~DxvkUploadSlice() {
+    m_ring->free(m_pageIndex, m_offset, m_allocSize);
+  }
+  
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "dxvk_buffer_res.h"
+
+namespace dxvk {
+  
+  class DxvkDevice;
+  class DxvkUploadSlice;
+  
+  /**
+   * \brief Upload ring stats
+   *
+   * Reports how much host-visible memory the ring
+   * has allocated, and how much of that memory is
+   * currently referenced by buffers.
+   */
+  struct DxvkUploadRingStats {
+    VkDeviceSize memoryAllocated = 0;
+    VkDeviceSize memoryUsed      = 0;
+  };
+  
+  
+  /**
+   * \brief Upload ring
+   *
+   * Sub-allocates backing storage for small dynamic buffers
+   * from a shared set of persistently mapped pages, so that
+   * discarding such a buffer does not require a physical
+   * slice of its own.
+   * 
+   * The pages form a ring which is filled linearly. Each
+   * slice is owned by a \ref DxvkUploadSlice resource, and
+   * is returned once that resource is no longer referenced
+   * by the buffer or by any command list still in flight.
+   * Its memory is reused when the ring wraps around. Slices that are
+   * still alive at that point, e.g. the current slice of a
+   * buffer that does not get discarded, are skipped over.
+   * New pages are only added if the entire ring is full,
+   * up to a fixed limit.
+   */
+  class DxvkUploadRing : public RcObject {
+    constexpr static VkDeviceSize PageSize      = 256 * 1024;
+    constexpr static VkDeviceSize SliceAlign    = 256;
+    constexpr static uint32_t     BlocksPerPage = PageSize / SliceAlign;
+    constexpr static uint32_t     MaxPages      = 64;
+    constexpr static uint32_t     MaxIdlePages  = 8;
+  public:
+    
+    /// Largest buffer that can use the upload ring
+    constexpr static VkDeviceSize MaxSliceSize  = 16 * 1024;
+    
+    DxvkUploadRing(DxvkDevice* device);
+    ~DxvkUploadRing();
+    
+    /**
+     * \brief Checks whether a buffer can use the ring
+     *
+     * Only small, host-visible buffers that are not
+     * used as texel buffers or storage buffers can
+     * be backed by ring slices.
+     * \param [in] info Buffer properties
+     * \param [in] memFlags Buffer memory flags
+     * \returns \c true if the ring can be used
+     */
+    static bool isSupported(
+      const DxvkBufferCreateInfo& info,
+            VkMemoryPropertyFlags memFlags);
+    
+    /**
+     * \brief Allocates a slice
+     *
+     * \param [in] length Slice length
+     * \returns The new slice, or an undefined slice
+     *    if the ring has reached its maximum size
+     */
+    DxvkPhysicalBufferSlice alloc(
+            VkDeviceSize          length);
+    
+    /**
+     * \brief Queries ring stats
+     * \returns Ring stats
+     */
+    DxvkUploadRingStats getStats() const;
+    
+  private:
+    
+    friend class DxvkUploadSlice;
+    
+    struct Page {
+      Rc<DxvkPhysicalBuffer> buffer;
+      uint32_t               liveCount;
+      std::array<uint64_t, BlocksPerPage / 64> liveMask;
+    };
+    
+    DxvkDevice* const         m_device;
+    
+    std::mutex                m_mutex;
+    std::vector<Page>         m_pages;
+    uint32_t                  m_pageCount = 0;
+    uint32_t                  m_idleCount = 0;
+    
+    size_t                    m_headPage  = 0;
+    uint32_t                  m_headBlock = 0;
+    
+    std::atomic<VkDeviceSize> m_memoryAllocated = { 0ull };
+    std::atomic<VkDeviceSize> m_memoryUsed      = { 0ull };
+    
+    void free(
+            uint32_t              pageIndex,
+            VkDeviceSize          offset,
+            VkDeviceSize          allocSize);
+    
+    bool findSpace(
+            uint32_t              blockCount);
+    
+    bool createPage();
+    
+    void advancePage();
+    
+    void updateLiveMask(
+            Page&                 page,
+            uint32_t              first,
+            uint32_t              count,
+            bool                  live);
+    
+    static uint32_t findLastLiveBlock(
+      const Page&                 page,
+            uint32_t              first,
+            uint32_t              count);
+    
+  };
+  
+  
+  /**
+   * \brief Upload ring slice
+   *
+   * Owns a slice allocated from the upload ring and returns
+   * it to the ring when destroyed. Command lists track this
+   * resource rather than the page the slice lives in, so
+   * the slice cannot be reused while the GPU may read it.
+   */
+  class DxvkUploadSlice : public DxvkResource {
+    
+  public:
+    
+    DxvkUploadSlice(
+            DxvkUploadRing*       ring,
+            uint32_t              pageIndex,
+            VkDeviceSize          offset,
+            VkDeviceSize          allocSize);
+    ~DxvkUploadSlice();
+    
+  private:
+    
+    Rc<DxvkUploadRing> m_ring;
+    uint32_t           m_pageIndex;
+    VkDeviceSize       m_offset;
+    VkDeviceSize       m_allocSize;
+    
+  };
+  
+}
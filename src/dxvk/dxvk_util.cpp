@@ -1,10 +1,89 @@
 #include <cstring>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "dxvk_format.h"
 #include "dxvk_util.h"
 
 namespace dxvk::util {
   
+  /**
+   * \brief Minimum size for non-temporal copies
+   * 
+   * Smaller copies are dominated by the overhead of
+   * aligning the destination, and partially written
+   * write-combining buffers get flushed either way.
+   */
+  constexpr size_t StreamingCopyMinSize = 128;
+  
+  
+  /**
+   * \brief Copies memory with non-temporal stores
+   * 
+   * Aligns the destination to 16 bytes and copies 64
+   * bytes per iteration, which is one write-combining
+   * buffer on current CPUs. Requires an \c sfence before
+   * the written data may be accessed by the device.
+   * Falls back to \c memcpy if SSE2 is not available.
+   */
+  static void copyStreaming(
+          char*             dstData,
+    const char*             srcData,
+          size_t            size) {
+#if defined(__SSE2__)
+    const size_t head = std::min<size_t>(size,
+      (16 - (reinterpret_cast<uintptr_t>(dstData) & 15)) & 15);
+    
+    std::memcpy(dstData, srcData, head);
+    
+    dstData += head;
+    srcData += head;
+    size    -= head;
+    
+    auto dst = reinterpret_cast<__m128i*>(dstData);
+    auto src = reinterpret_cast<const __m128i*>(srcData);
+    
+    for ( ; size >= 64; size -= 64) {
+      const __m128i a = _mm_loadu_si128(src + 0);
+      const __m128i b = _mm_loadu_si128(src + 1);
+      const __m128i c = _mm_loadu_si128(src + 2);
+      const __m128i d = _mm_loadu_si128(src + 3);
+      
+      _mm_stream_si128(dst + 0, a);
+      _mm_stream_si128(dst + 1, b);
+      _mm_stream_si128(dst + 2, c);
+      _mm_stream_si128(dst + 3, d);
+      
+      dst += 4;
+      src += 4;
+    }
+    
+    for ( ; size >= 16; size -= 16)
+      _mm_stream_si128(dst++, _mm_loadu_si128(src++));
+    
+    std::memcpy(dst, src, size);
+#else
+    std::memcpy(dstData, srcData, size);
+#endif
+  }
+  
+  
+  /**
+   * \brief Copies memory to the given memory type
+   */
+  static void copyData(
+          char*             dstData,
+    const char*             srcData,
+          size_t            size,
+          bool              streaming) {
+    if (streaming)
+      copyStreaming(dstData, srcData, size);
+    else
+      std::memcpy(dstData, srcData, size);
+  }
+  
   VkPipelineStageFlags pipelineStages(
           VkShaderStageFlags shaderStages) {
     VkPipelineStageFlags result = 0;
@@ -44,7 +123,8 @@ namespace dxvk::util {
           VkExtent3D        blockCount,
           VkDeviceSize      blockSize,
           VkDeviceSize      pitchPerRow,
-          VkDeviceSize      pitchPerLayer) {
+          VkDeviceSize      pitchPerLayer,
+          CopyTarget        target) {
     const VkDeviceSize bytesPerRow   = blockCount.width  * blockSize;
     const VkDeviceSize bytesPerLayer = blockCount.height * bytesPerRow;
     const VkDeviceSize bytesTotal    = blockCount.depth  * bytesPerLayer;
@@ -52,21 +132,33 @@ namespace dxvk::util {
     const bool directCopy = ((bytesPerRow   == pitchPerRow  ) || (blockCount.height == 1))
                          && ((bytesPerLayer == pitchPerLayer) || (blockCount.depth  == 1));
     
+    // Packed rows are contiguous in the destination, so
+    // even short rows fill entire write-combining buffers
+    const bool streaming = target == CopyTarget::WriteCombined
+      && (directCopy ? bytesTotal : bytesPerLayer) >= StreamingCopyMinSize;
+    
     if (directCopy) {
-      std::memcpy(dstData, srcData, bytesTotal);
+      copyData(dstData, srcData, bytesTotal, streaming);
     } else {
       for (uint32_t i = 0; i < blockCount.depth; i++) {
         for (uint32_t j = 0; j < blockCount.height; j++) {
-          std::memcpy(
+          copyData(
             dstData + j * bytesPerRow,
             srcData + j * pitchPerRow,
-            bytesPerRow);
+            bytesPerRow, streaming);
         }
         
         srcData += pitchPerLayer;
         dstData += bytesPerLayer;
       }
     }
+    
+#if defined(__SSE2__)
+    // Make non-temporal stores visible before
+    // the staging buffer gets used by the GPU
+    if (streaming)
+      _mm_sfence();
+#endif
   }
   
   
@@ -21,6 +21,19 @@ namespace dxvk::util {
    */
   uint32_t computeMipLevelCount(VkExtent3D imageSize);
   
+  /**
+   * \brief Copy destination memory type
+   * 
+   * Write-combined memory, such as host-visible staging
+   * buffers, is written with non-temporal stores, which
+   * bypass the cache. Cached memory that is going to be
+   * read again by the CPU should use regular stores.
+   */
+  enum class CopyTarget : uint32_t {
+    Cached,         ///< Regular system memory
+    WriteCombined,  ///< Uncached, write-combined memory
+  };
+  
   /**
    * \brief Writes tightly packed image data to a buffer
    * 
@@ -30,6 +43,7 @@ namespace dxvk::util {
    * \param [in] blockSize Number of bytes per block
    * \param [in] pitchPerRow Number of bytes between rows
    * \param [in] pitchPerLayer Number of bytes between layers
+   * \param [in] target Destination memory type
    */
   void packImageData(
           char*             dstData,
@@ -37,7 +51,8 @@ namespace dxvk::util {
           VkExtent3D        blockCount,
           VkDeviceSize      blockSize,
           VkDeviceSize      pitchPerRow,
-          VkDeviceSize      pitchPerLayer);
+          VkDeviceSize      pitchPerLayer,
+          CopyTarget        target);
   
   /**
    * \brief Computes block count for compressed images
@@ -14,7 +14,8 @@ namespace dxvk::hud {
     m_uniformBuffer (createUniformBuffer()),
     m_hudDeviceInfo (device),
     m_hudFramerate  (config.elements),
-    m_hudStats      (config.elements) {
+    m_hudStats      (config.elements),
+    m_hudProfiler   (device, config.elements) {
     this->setupConstantState();
   }
   
@@ -34,6 +35,7 @@ namespace dxvk::hud {
       
     m_hudFramerate.update();
     m_hudStats.update(m_device);
+    m_hudProfiler.update();
     
     this->beginRenderPass(recreateFbo);
     this->updateUniformBuffer();
@@ -77,6 +79,7 @@ namespace dxvk::hud {
     
     position = m_hudFramerate.render(m_context, m_renderer, position);
     position = m_hudStats    .render(m_context, m_renderer, position);
+    position = m_hudProfiler .render(m_context, m_renderer, position);
   }
   
   
@@ -7,6 +7,7 @@
 #include "dxvk_hud_config.h"
 #include "dxvk_hud_devinfo.h"
 #include "dxvk_hud_fps.h"
+#include "dxvk_hud_profiler.h"
 #include "dxvk_hud_renderer.h"
 #include "dxvk_hud_stats.h"
 
@@ -85,6 +86,7 @@ namespace dxvk::hud {
     HudDeviceInfo         m_hudDeviceInfo;
     HudFps                m_hudFramerate;
     HudStats              m_hudStats;
+    HudProfiler           m_hudProfiler;
     
     void render();
     
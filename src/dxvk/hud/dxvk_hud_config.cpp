@@ -12,6 +12,8 @@ namespace dxvk::hud {
     { "submissions",  HudElement::StatSubmissions   },
     { "pipelines",    HudElement::StatPipelines     },
     { "memory",       HudElement::StatMemory        },
+    { "descriptors",  HudElement::StatDescriptors   },
+    { "profiler",     HudElement::Profiler          },
   }};
   
   
@@ -41,7 +43,7 @@ namespace dxvk::hud {
         
         if (element != g_hudElements.cend()) {
           this->elements.set(element->second);
-          Logger::debug(str::format("Hud: Enabled ", configPart));
+          Logger::debugf("Hud: Enabled ", configPart);
         }
         
         pos = end + 1;
@@ -18,6 +18,8 @@ namespace dxvk::hud {
     StatSubmissions   = 4,
     StatPipelines     = 5,
     StatMemory        = 6,
+    StatDescriptors   = 7,
+    Profiler          = 8,
   };
   
   using HudElements = Flags<HudElement>;
@@ -0,0 +1,84 @@
+#include "dxvk_hud_profiler.h"
+
+namespace dxvk::hud {
+  
+  HudProfiler::HudProfiler(
+    const Rc<DxvkDevice>&   device,
+          HudElements       elements)
+  : m_elements(elements),
+    m_profiler(device->profiler()) {
+    if (m_elements.test(HudElement::Profiler))
+      m_profiler->enable();
+  }
+  
+  
+  HudProfiler::~HudProfiler() {
+    
+  }
+  
+  
+  void HudProfiler::update() {
+    if (!m_elements.test(HudElement::Profiler))
+      return;
+    
+    std::array<DxvkProfilerFrame, NumFrames> frames;
+    uint32_t frameCount = m_profiler->getFrames(NumFrames, frames.data());
+    
+    m_average = DxvkProfilerFrame();
+    
+    for (uint32_t i = 0; i < frameCount; i++) {
+      m_average.frameTime         += frames[i].frameTime;
+      m_average.appTime           += frames[i].appTime;
+      m_average.csTime            += frames[i].csTime;
+      m_average.submitTime        += frames[i].submitTime;
+      m_average.presentTime       += frames[i].presentTime;
+      m_average.gpuTime           += frames[i].gpuTime;
+      m_average.gpuRenderPassTime += frames[i].gpuRenderPassTime;
+      m_average.renderPassCount   += frames[i].renderPassCount;
+    }
+    
+    if (frameCount != 0) {
+      m_average.frameTime         /= frameCount;
+      m_average.appTime           /= frameCount;
+      m_average.csTime            /= frameCount;
+      m_average.submitTime        /= frameCount;
+      m_average.presentTime       /= frameCount;
+      m_average.gpuTime           /= frameCount;
+      m_average.gpuRenderPassTime /= frameCount;
+      m_average.renderPassCount   /= frameCount;
+    }
+  }
+  
+  
+  HudPos HudProfiler::render(
+    const Rc<DxvkContext>&  context,
+          HudRenderer&      renderer,
+          HudPos            position) {
+    if (!m_elements.test(HudElement::Profiler))
+      return position;
+    
+    auto ms = [] (uint64_t ns) {
+      return str::format(ns / 1000000, ".", (ns / 100000) % 10, (ns / 10000) % 10, " ms");
+    };
+    
+    const std::array<std::string, 6> lines = {{
+      str::format("Frame:     ", ms(m_average.frameTime)),
+      str::format("App:       ", ms(m_average.appTime)),
+      str::format("CS thread: ", ms(m_average.csTime)),
+      str::format("Submit:    ", ms(m_average.submitTime)),
+      str::format("Present:   ", ms(m_average.presentTime)),
+      str::format("GPU:       ", ms(m_average.gpuTime), " (render passes: ",
+        ms(m_average.gpuRenderPassTime), ", ", m_average.renderPassCount, ")"),
+    }};
+    
+    for (size_t i = 0; i < lines.size(); i++) {
+      renderer.drawText(context, 16.0f,
+        { position.x, position.y + 20.0f * float(i) },
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        lines[i]);
+    }
+    
+    return { position.x, position.y + 20.0f * float(lines.size()) + 4.0f };
+  }
+  
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "../dxvk_profiler.h"
+
+#include "dxvk_hud_config.h"
+#include "dxvk_hud_renderer.h"
+
+namespace dxvk::hud {
+  
+  /**
+   * \brief Profiler display for the HUD
+   *
+   * Enables the device's frame profiler and shows
+   * where the time of recent frames was spent,
+   * averaged over a number of completed frames.
+   */
+  class HudProfiler {
+    constexpr static uint32_t NumFrames = 32;
+  public:
+    
+    HudProfiler(
+      const Rc<DxvkDevice>&   device,
+            HudElements       elements);
+    ~HudProfiler();
+    
+    void update();
+    
+    HudPos render(
+      const Rc<DxvkContext>&  context,
+            HudRenderer&      renderer,
+            HudPos            position);
+    
+  private:
+    
+    const HudElements       m_elements;
+    const Rc<DxvkProfiler>  m_profiler;
+    
+    DxvkProfilerFrame       m_average;
+    
+  };
+  
+}
@@ -39,6 +39,9 @@ namespace dxvk::hud {
     if (m_elements.test(HudElement::StatMemory))
       position = this->printMemoryStats(context, renderer, position);
     
+    if (m_elements.test(HudElement::StatDescriptors))
+      position = this->printDescriptorStats(context, renderer, position);
+    
     return position;
   }
   
@@ -101,8 +104,11 @@ namespace dxvk::hud {
     const uint64_t gpCount = m_prevCounters.getCtr(DxvkStatCounter::PipeCountGraphics);
     const uint64_t cpCount = m_prevCounters.getCtr(DxvkStatCounter::PipeCountCompute);
     
+    const uint64_t pendingCount = m_prevCounters.getCtr(DxvkStatCounter::PipeCountPending);
+    
     const std::string strGpCount = str::format("Graphics pipelines: ", gpCount);
     const std::string strCpCount = str::format("Compute pipelines:  ", cpCount);
+    const std::string strPending = str::format("Pending pipelines:  ", pendingCount);
     
     renderer.drawText(context, 16.0f,
       { position.x, position.y },
@@ -114,7 +120,12 @@ namespace dxvk::hud {
       { 1.0f, 1.0f, 1.0f, 1.0f },
       strCpCount);
     
-    return { position.x, position.y + 44.0f };
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y + 40.0f },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      strPending);
+    
+    return { position.x, position.y + 64.0f };
   }
   
   
@@ -144,12 +155,50 @@ namespace dxvk::hud {
   }
   
   
+  HudPos HudStats::printDescriptorStats(
+    const Rc<DxvkContext>&  context,
+          HudRenderer&      renderer,
+          HudPos            position) {
+    const uint64_t frameCount = std::max(m_diffCounters.getCtr(DxvkStatCounter::QueuePresentCount), 1ull);
+    
+    const uint64_t poolCount  = m_prevCounters.getCtr(DxvkStatCounter::DescriptorPoolCount);
+    const uint64_t poolsUsed  = m_prevCounters.getCtr(DxvkStatCounter::DescriptorPoolsUsed);
+    const uint64_t poolSize   = m_prevCounters.getCtr(DxvkStatCounter::DescriptorPoolSize);
+    
+    const uint64_t setsAlloc  = m_diffCounters.getCtr(DxvkStatCounter::DescriptorSetCount);
+    const uint64_t setsReused = m_diffCounters.getCtr(DxvkStatCounter::DescriptorSetReused);
+    const uint64_t setsTotal  = std::max(setsAlloc + setsReused, 1ull);
+    
+    const std::string strPools = str::format("Descriptor pools: ", poolCount, " (", poolsUsed, " in use, ", poolSize, " sets each)");
+    const std::string strSets  = str::format("Descriptor sets:  ", setsAlloc / frameCount, " per frame");
+    const std::string strReuse = str::format("Sets reused:      ", (100 * setsReused) / setsTotal, "%");
+    
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      strPools);
+    
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y + 20.0f },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      strSets);
+    
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y + 40.0f },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      strReuse);
+    
+    return { position.x, position.y + 64.0f };
+  }
+  
+  
   HudElements HudStats::filterElements(HudElements elements) {
     return elements & HudElements(
       HudElement::StatDrawCalls,
       HudElement::StatSubmissions,
       HudElement::StatPipelines,
-      HudElement::StatMemory);
+      HudElement::StatMemory,
+      HudElement::StatDescriptors);
   }
   
 }
\ No newline at end of file
@@ -498,13 +498,10 @@ namespace dxvk {
   uint32_t SpirvModule::defArrayTypeUnique(
           uint32_t                typeId,
           uint32_t                length) {
-    uint32_t resultId = this->allocateId();
+    std::array<uint32_t, 2> args = {{ typeId, length }};
     
-    m_typeConstDefs.putIns (spv::OpTypeArray, 4);
-    m_typeConstDefs.putWord(resultId);
-    m_typeConstDefs.putWord(typeId);
-    m_typeConstDefs.putWord(length);
-    return resultId;
+    return this->defTypeUnique(spv::OpTypeArray,
+      args.size(), args.data());
   }
   
   
@@ -519,12 +516,10 @@ namespace dxvk {
   
   uint32_t SpirvModule::defRuntimeArrayTypeUnique(
           uint32_t                typeId) {
-    uint32_t resultId = this->allocateId();
+    std::array<uint32_t, 1> args = { typeId };
     
-    m_typeConstDefs.putIns (spv::OpTypeRuntimeArray, 3);
-    m_typeConstDefs.putWord(resultId);
-    m_typeConstDefs.putWord(typeId);
-    return resultId;
+    return this->defTypeUnique(spv::OpTypeRuntimeArray,
+      args.size(), args.data());
   }
   
   
@@ -554,14 +549,8 @@ namespace dxvk {
   uint32_t SpirvModule::defStructTypeUnique(
           uint32_t                memberCount,
     const uint32_t*               memberTypes) {
-    uint32_t resultId = this->allocateId();
-    
-    m_typeConstDefs.putIns (spv::OpTypeStruct, 2 + memberCount);
-    m_typeConstDefs.putWord(resultId);
-    
-    for (uint32_t i = 0; i < memberCount; i++)
-      m_typeConstDefs.putWord(memberTypes[i]);
-    return resultId;
+    return this->defTypeUnique(spv::OpTypeStruct,
+      memberCount, memberTypes);
   }
   
   
@@ -2896,48 +2885,66 @@ namespace dxvk {
           spv::Op                 op, 
           uint32_t                argCount,
     const uint32_t*               argIds) {
-    // Since the type info is stored in the code buffer,
-    // we can use the code buffer to look up type IDs as
-    // well. Result IDs are always stored as argument 1.
-    for (auto ins : m_typeConstDefs) {
-      bool match = ins.opCode() == op
-                && ins.length() == 2 + argCount;
-      
-      for (uint32_t i = 0; i < argCount && match; i++)
-        match &= ins.arg(2 + i) == argIds[i];
-      
-      if (match)
-        return ins.arg(1);
-    }
+    // Look up the type by everything except the result
+    // ID, which is always stored as argument 1.
+    this->initTypeKey(op, argCount, argIds);
+    
+    auto entry = m_typeConstIds.find(m_typeConstKey);
+    
+    if (entry != m_typeConstIds.end())
+      return entry->second;
     
     // Type not yet declared, create a new one.
+    return this->defTypeUnique(op, argCount, argIds);
+  }
+  
+  
+  uint32_t SpirvModule::defTypeUnique(
+          spv::Op                 op,
+          uint32_t                argCount,
+    const uint32_t*               argIds) {
     uint32_t resultId = this->allocateId();
     m_typeConstDefs.putIns (op, 2 + argCount);
     m_typeConstDefs.putWord(resultId);
     
     for (uint32_t i = 0; i < argCount; i++)
       m_typeConstDefs.putWord(argIds[i]);
+    
+    // Unique types can be returned by later lookups
+    // unless an identical type was declared earlier
+    this->initTypeKey(op, argCount, argIds);
+    m_typeConstIds.emplace(m_typeConstKey, resultId);
     return resultId;
   }
   
   
+  void SpirvModule::initTypeKey(
+          spv::Op                 op,
+          uint32_t                argCount,
+    const uint32_t*               argIds) {
+    m_typeConstKey.words.clear();
+    m_typeConstKey.words.push_back(op | ((2 + argCount) << spv::WordCountShift));
+    m_typeConstKey.words.insert(m_typeConstKey.words.end(), argIds, argIds + argCount);
+  }
+  
+  
   uint32_t SpirvModule::defConst(
           spv::Op                 op,
           uint32_t                typeId,
           uint32_t                argCount,
     const uint32_t*               argIds) {
-    // Avoid declaring constants multiple times
-    for (auto ins : m_typeConstDefs) {
-      bool match = ins.opCode() == op
-                && ins.length() == 3 + argCount
-                && ins.arg(1)   == typeId;
-      
-      for (uint32_t i = 0; i < argCount && match; i++)
-        match &= ins.arg(3 + i) == argIds[i];
-      
-      if (match)
-        return ins.arg(2);
-    }
+    // Avoid declaring constants multiple times. The
+    // result ID is stored as argument 2 and not part
+    // of the key, but the result type is.
+    m_typeConstKey.words.clear();
+    m_typeConstKey.words.push_back(op | ((3 + argCount) << spv::WordCountShift));
+    m_typeConstKey.words.push_back(typeId);
+    m_typeConstKey.words.insert(m_typeConstKey.words.end(), argIds, argIds + argCount);
+    
+    auto entry = m_typeConstIds.find(m_typeConstKey);
+    
+    if (entry != m_typeConstIds.end())
+      return entry->second;
     
     // Constant not yet declared, make a new one
     uint32_t resultId = this->allocateId();
@@ -2947,6 +2954,8 @@ namespace dxvk {
     
     for (uint32_t i = 0; i < argCount; i++)
       m_typeConstDefs.putWord(argIds[i]);
+    
+    m_typeConstIds.insert({ m_typeConstKey, resultId });
     return resultId;
   }
   
@@ -1,9 +1,44 @@
 #pragma once
 
+#include <unordered_map>
+
 #include "spirv_code_buffer.h"
 
 namespace dxvk {
   
+  /**
+   * \brief Type or constant declaration key
+   * 
+   * Stores the op code token and all operands of a type
+   * or constant declaration, except for the result ID.
+   * Used to look up existing declarations quickly.
+   */
+  struct SpirvTypeConstKey {
+    std::vector<uint32_t> words;
+    
+    bool operator == (const SpirvTypeConstKey& other) const {
+      return words == other.words;
+    }
+    
+    size_t hash() const {
+      size_t result = 0;
+      
+      for (uint32_t word : words) {
+        result ^= size_t(word) + 0x9e3779b9
+                + (result << 6)
+                + (result >> 2);
+      }
+      
+      return result;
+    }
+  };
+  
+  struct SpirvTypeConstKeyHash {
+    size_t operator () (const SpirvTypeConstKey& key) const {
+      return key.hash();
+    }
+  };
+  
   struct SpirvPhiLabel {
     uint32_t varId         = 0;
     uint32_t labelId       = 0;
@@ -1026,11 +1061,28 @@ namespace dxvk {
     SpirvCodeBuffer m_variables;
     SpirvCodeBuffer m_code;
     
+    // Maps type and constant declarations in
+    // m_typeConstDefs to their result IDs
+    SpirvTypeConstKey m_typeConstKey;
+    std::unordered_map<
+      SpirvTypeConstKey, uint32_t,
+      SpirvTypeConstKeyHash> m_typeConstIds;
+    
     uint32_t defType(
             spv::Op                 op, 
             uint32_t                argCount,
       const uint32_t*               argIds);
     
+    uint32_t defTypeUnique(
+            spv::Op                 op,
+            uint32_t                argCount,
+      const uint32_t*               argIds);
+    
+    void initTypeKey(
+            spv::Op                 op,
+            uint32_t                argCount,
+      const uint32_t*               argIds);
+    
     uint32_t defConst(
             spv::Op                 op,
             uint32_t                typeId,
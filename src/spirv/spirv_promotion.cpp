@@ -0,0 +1,778 @@
+#include <array>
+
+#include "spirv_promotion.h"
+
+namespace dxvk {
+  
+  SpirvRegisterPromotion::SpirvRegisterPromotion(
+          size_t                varCount,
+    const uint32_t*             varIds) {
+    for (size_t i = 0; i < varCount; i++) {
+      m_vars.insert({ varIds[i], Var() });
+      m_varIds.push_back(varIds[i]);
+    }
+  }
+  
+  
+  SpirvRegisterPromotion::~SpirvRegisterPromotion() {
+  
+  }
+  
+  
+  SpirvCodeBuffer SpirvRegisterPromotion::run(const SpirvCodeBuffer& code) {
+    this->parse(code);
+    this->declareLocals();
+    this->forwardValues();
+    this->foldComponents();
+    this->removeDeadCode();
+    
+    // Local variables must be declared at the start
+    // of the first block of the function using them
+    for (uint32_t varId : m_varIds) {
+      const Var& var = m_vars.at(varId);
+      
+      if (isPromoted(varId) && !m_removedIds[varId]) {
+        m_extraWords[var.label].insert(m_extraWords[var.label].end(), {
+          uint32_t(spv::OpVariable) | (4u << spv::WordCountShift),
+          var.ptrType, varId, uint32_t(spv::StorageClassFunction) });
+      }
+    }
+    
+    SpirvCodeBuffer result;
+    
+    for (uint32_t i = 0; i < 5; i++)
+      result.putWord(i == 3 ? m_bound : code.data()[i]);
+    
+    for (uint32_t i = 0; i < m_ins.size(); i++) {
+      if (m_ins[i].removed)
+        continue;
+      
+      switch (getOp(i)) {
+        case spv::OpName:
+        case spv::OpMemberName:
+        case spv::OpDecorate:
+        case spv::OpMemberDecorate:
+          if (m_removedIds[getArg(i, 1)])
+            continue;
+          break;
+        
+        default:
+          break;
+      }
+      
+      for (uint32_t n = 0; n < m_ins[i].length; n++)
+        result.putWord(getArg(i, n));
+      
+      auto extra = m_extraWords.find(i);
+      
+      if (extra != m_extraWords.end()) {
+        for (uint32_t word : extra->second)
+          result.putWord(word);
+      }
+    }
+    
+    return result;
+  }
+  
+  
+  void SpirvRegisterPromotion::parse(const SpirvCodeBuffer& code) {
+    const uint32_t* data  = code.data();
+    const size_t    count = code.size() / sizeof(uint32_t);
+    
+    if (count < 5 || data[0] != spv::MagicNumber)
+      throw DxvkError("SpirvRegisterPromotion: Invalid module header");
+    
+    m_bound = data[3];
+    m_words.assign(data + 5, data + count);
+    
+    m_defs.resize(m_bound, -1);
+    m_vectorSizes.resize(m_bound, 0);
+    
+    int32_t function   = -1;
+    int32_t firstLabel = -1;
+    
+    for (uint32_t offset = 0; offset < m_words.size(); ) {
+      const uint32_t length = m_words[offset] >> spv::WordCountShift;
+      
+      if (length == 0 || offset + length > m_words.size())
+        throw DxvkError("SpirvRegisterPromotion: Invalid instruction");
+      
+      const uint32_t i = m_ins.size();
+      m_ins.push_back({ offset, length, false });
+      offset += length;
+      
+      const spv::Op  op        = getOp(i);
+      const uint32_t resultArg = getResultArg(op);
+      
+      if (resultArg != 0 && resultArg < length && getArg(i, resultArg) < m_bound)
+        m_defs[getArg(i, resultArg)] = i;
+      
+      switch (op) {
+        case spv::OpTypeVector:
+          if (getArg(i, 1) < m_bound)
+            m_vectorSizes[getArg(i, 1)] = getArg(i, 3);
+          break;
+        
+        case spv::OpFunction:
+          function   = i;
+          firstLabel = -1;
+          break;
+        
+        case spv::OpFunctionEnd:
+          function   = -1;
+          break;
+        
+        case spv::OpLabel:
+          if (firstLabel < 0)
+            firstLabel = i;
+          break;
+        
+        default:
+          break;
+      }
+      
+      // Any access other than a plain load or store, or
+      // from more than one function, prevents promotion
+      for (uint32_t n = 1; n < length; n++) {
+        auto entry = m_vars.find(getArg(i, n));
+        
+        if (entry == m_vars.end())
+          continue;
+        
+        Var& var = entry->second;
+        
+        if (function < 0) {
+          if (op == spv::OpVariable && n == 2 && length == 4
+           && getArg(i, 3) == spv::StorageClassPrivate) {
+            var.decl    = i;
+            var.ptrType = getArg(i, 1);
+          } else if (n != 1 || (op != spv::OpName && op != spv::OpDecorate)) {
+            var.eligible = false;
+          }
+        } else {
+          if (op == spv::OpLoad && n == 3 && length == 4)
+            var.loadCount += 1;
+          else if (op == spv::OpStore && n == 1 && length == 3)
+            var.stores.push_back(i);
+          else
+            var.eligible = false;
+          
+          if (var.function < 0) {
+            var.function = function;
+            var.label    = firstLabel;
+          } else if (var.function != function) {
+            var.eligible = false;
+          }
+        }
+      }
+    }
+    
+    for (auto& entry : m_vars) {
+      if (entry.second.decl < 0 || entry.second.label < 0)
+        entry.second.eligible = false;
+    }
+  }
+  
+  
+  void SpirvRegisterPromotion::declareLocals() {
+    std::unordered_map<uint32_t, uint32_t> ptrTypes;
+    
+    for (uint32_t i = 0; i < m_ins.size(); i++) {
+      if (getOp(i) == spv::OpTypePointer
+       && getArg(i, 2) == spv::StorageClassFunction)
+        ptrTypes.insert({ getArg(i, 3), getArg(i, 1) });
+    }
+    
+    for (uint32_t varId : m_varIds) {
+      Var& var = m_vars.at(varId);
+      
+      if (!var.eligible)
+        continue;
+      
+      const int32_t ptrDef = getDef(var.ptrType);
+      
+      if (ptrDef < 0 || getOp(ptrDef) != spv::OpTypePointer) {
+        var.eligible = false;
+        continue;
+      }
+      
+      // Declare the function pointer type right after
+      // the private one, which references the same type
+      const uint32_t pointee = getArg(ptrDef, 3);
+      auto entry = ptrTypes.find(pointee);
+      
+      if (entry == ptrTypes.end()) {
+        entry = ptrTypes.insert({ pointee, m_bound++ }).first;
+        
+        m_extraWords[ptrDef].insert(m_extraWords[ptrDef].end(), {
+          uint32_t(spv::OpTypePointer) | (4u << spv::WordCountShift),
+          entry->second, uint32_t(spv::StorageClassFunction), pointee });
+      }
+      
+      var.ptrType = entry->second;
+      m_ins[var.decl].removed = true;
+    }
+    
+    m_defs.resize(m_bound, -1);
+    m_vectorSizes.resize(m_bound, 0);
+    m_removedIds.resize(m_bound, false);
+  }
+  
+  
+  void SpirvRegisterPromotion::forwardValues() {
+    std::unordered_map<uint32_t, VarState> state;
+    
+    for (uint32_t i = 0; i < m_ins.size(); i++) {
+      const spv::Op op = getOp(i);
+      
+      if (op == spv::OpLabel || isTerminator(op)) {
+        state.clear();
+      } else if (op == spv::OpStore && m_ins[i].length == 3 && isPromoted(getArg(i, 1))) {
+        // The previous store in this block is dead
+        // if no load needed its value from memory
+        auto entry = state.find(getArg(i, 1));
+        
+        if (entry != state.end() && entry->second.store >= 0)
+          m_ins[entry->second.store].removed = true;
+        
+        state[getArg(i, 1)] = { getArg(i, 2), int32_t(i) };
+      } else if (op == spv::OpLoad && m_ins[i].length == 4 && isPromoted(getArg(i, 3))) {
+        auto entry = state.find(getArg(i, 3));
+        
+        if (entry != state.end()) {
+          m_vars.at(getArg(i, 3)).loadCount -= 1;
+          
+          replaceIns(i, {
+            uint32_t(spv::OpCopyObject) | (4u << spv::WordCountShift),
+            getArg(i, 1), getArg(i, 2), entry->second.value });
+        } else {
+          state.insert({ getArg(i, 3), { getArg(i, 2), -1 } });
+        }
+      }
+    }
+  }
+  
+  
+  void SpirvRegisterPromotion::foldComponents() {
+    bool inFunction = false;
+    
+    for (uint32_t i = 0; i < m_ins.size(); i++) {
+      if (m_ins[i].removed)
+        continue;
+      
+      const spv::Op  op     = getOp(i);
+      const uint32_t length = m_ins[i].length;
+      
+      if (op == spv::OpFunction)    inFunction = true;
+      if (op == spv::OpFunctionEnd) inFunction = false;
+      
+      if (!inFunction)
+        continue;
+      
+      // Make operands refer to the original values
+      // so that forwarded copies can be removed
+      if (hasIdOperands(op)) {
+        for (uint32_t n = 3; n < length; n++)
+          setArg(i, n, resolveCopy(getArg(i, n)));
+      }
+      
+      switch (op) {
+        case spv::OpStore:
+          setArg(i, 2, resolveCopy(getArg(i, 2)));
+          break;
+        
+        case spv::OpReturnValue:
+        case spv::OpBranchConditional:
+        case spv::OpSwitch:
+          setArg(i, 1, resolveCopy(getArg(i, 1)));
+          break;
+        
+        case spv::OpExtInst:
+          for (uint32_t n = 5; n < length; n++)
+            setArg(i, n, resolveCopy(getArg(i, n)));
+          break;
+        
+        case spv::OpCompositeInsert:
+          setArg(i, 3, resolveCopy(getArg(i, 3)));
+          setArg(i, 4, resolveCopy(getArg(i, 4)));
+          break;
+        
+        case spv::OpCompositeExtract: {
+          if (length != 5)
+            break;
+          
+          // Trace the component back to where it was written
+          uint32_t composite = resolveCopy(getArg(i, 3));
+          uint32_t index     = getArg(i, 4);
+          uint32_t scalar    = 0;
+          
+          while (!scalar) {
+            const int32_t def = getDef(composite);
+            
+            if (def < 0 || m_ins[def].removed)
+              break;
+            
+            const spv::Op  defOp     = getOp(def);
+            const uint32_t defLength = m_ins[def].length;
+            
+            if (defOp == spv::OpCompositeInsert && defLength == 6) {
+              if (getArg(def, 5) == index)
+                scalar = getArg(def, 3);
+              else
+                composite = getArg(def, 4);
+            } else if (defOp == spv::OpVectorShuffle && index + 5 < defLength) {
+              const uint32_t component = getArg(def, 5 + index);
+              const uint32_t size      = getVectorSize(getArg(def, 3));
+              
+              if (component == ~0u || size == 0)
+                break;
+              
+              composite = getArg(def, component < size ? 3 : 4);
+              index     = component < size ? component : component - size;
+            } else if (defOp == spv::OpCompositeConstruct
+                    && defLength - 3 == getVectorSize(composite)
+                    && index + 3 < defLength) {
+              scalar = getArg(def, 3 + index);
+            } else if (defOp == spv::OpCopyObject) {
+              composite = getArg(def, 3);
+            } else {
+              break;
+            }
+          }
+          
+          if (scalar) {
+            replaceIns(i, {
+              uint32_t(spv::OpCopyObject) | (4u << spv::WordCountShift),
+              getArg(i, 1), getArg(i, 2), resolveCopy(scalar) });
+          } else {
+            setArg(i, 3, composite);
+            setArg(i, 4, index);
+          }
+        } break;
+        
+        case spv::OpVectorShuffle: {
+          const uint32_t count = length - 5;
+          const uint32_t size  = getVectorSize(getArg(i, 3));
+          
+          if (size == 0 || count > 4)
+            break;
+          
+          // Trace each component through shuffles
+          std::array<uint32_t, 4> srcIds;
+          std::array<uint32_t, 4> srcIndices;
+          
+          for (uint32_t k = 0; k < count; k++) {
+            const uint32_t component = getArg(i, 5 + k);
+            
+            srcIds[k]     = 0;
+            srcIndices[k] = component;
+            
+            if (component == ~0u)
+              continue;
+            
+            uint32_t id    = resolveCopy(getArg(i, component < size ? 3 : 4));
+            uint32_t index = component < size ? component : component - size;
+            
+            while (true) {
+              const int32_t def = getDef(id);
+              
+              if (def < 0 || m_ins[def].removed
+               || getOp(def) != spv::OpVectorShuffle
+               || index + 5 >= m_ins[def].length)
+                break;
+              
+              const uint32_t defComponent = getArg(def, 5 + index);
+              const uint32_t defSize      = getVectorSize(getArg(def, 3));
+              
+              if (defComponent == ~0u || defSize == 0)
+                break;
+              
+              id    = resolveCopy(getArg(def, defComponent < defSize ? 3 : 4));
+              index = defComponent < defSize ? defComponent : defComponent - defSize;
+            }
+            
+            srcIds[k]     = id;
+            srcIndices[k] = index;
+          }
+          
+          // A shuffle can only take two source vectors
+          std::array<uint32_t, 2> vectors = {{ 0, 0 }};
+          bool canFold = true;
+          
+          for (uint32_t k = 0; k < count && canFold; k++) {
+            if (!srcIds[k] || srcIds[k] == vectors[0] || srcIds[k] == vectors[1])
+              continue;
+            
+            if (!vectors[0])
+              vectors[0] = srcIds[k];
+            else if (!vectors[1])
+              vectors[1] = srcIds[k];
+            else
+              canFold = false;
+          }
+          
+          const uint32_t newSize = getVectorSize(vectors[0]);
+          
+          if (!canFold || !vectors[0] || newSize == 0)
+            break;
+          
+          if (!vectors[1])
+            vectors[1] = vectors[0];
+          
+          bool isIdentity = newSize == count && vectors[0] == vectors[1];
+          
+          for (uint32_t k = 0; k < count && isIdentity; k++)
+            isIdentity = srcIds[k] && srcIndices[k] == k;
+          
+          if (isIdentity) {
+            replaceIns(i, {
+              uint32_t(spv::OpCopyObject) | (4u << spv::WordCountShift),
+              getArg(i, 1), getArg(i, 2), vectors[0] });
+          } else {
+            setArg(i, 3, vectors[0]);
+            setArg(i, 4, vectors[1]);
+            
+            for (uint32_t k = 0; k < count; k++) {
+              if (srcIds[k]) {
+                setArg(i, 5 + k, srcIds[k] == vectors[0]
+                  ? srcIndices[k] : srcIndices[k] + newSize);
+              }
+            }
+          }
+        } break;
+        
+        default:
+          break;
+      }
+    }
+  }
+  
+  
+  void SpirvRegisterPromotion::removeDeadCode() {
+    m_uses.resize(m_bound, 0);
+    
+    for (uint32_t i = 0; i < m_ins.size(); i++) {
+      if (!m_ins[i].removed)
+        countUses(i, 1);
+    }
+    
+    std::vector<uint32_t> worklist;
+    
+    for (uint32_t i = 0; i < m_ins.size(); i++) {
+      if (isRemovable(i))
+        worklist.push_back(i);
+    }
+    
+    // Removing the stores of a variable that is never
+    // loaded may make the stored values dead as well
+    do {
+      while (!worklist.empty()) {
+        const uint32_t i = worklist.back();
+        worklist.pop_back();
+        
+        if (isRemovable(i))
+          removeIns(i, worklist);
+      }
+    } while (removeDeadStores(worklist));
+  }
+  
+  
+  bool SpirvRegisterPromotion::removeDeadStores(std::vector<uint32_t>& worklist) {
+    bool progress = false;
+    
+    for (uint32_t varId : m_varIds) {
+      Var& var = m_vars.at(varId);
+      
+      if (!isPromoted(varId) || m_removedIds[varId] || var.loadCount != 0)
+        continue;
+      
+      for (uint32_t store : var.stores) {
+        if (!m_ins[store].removed)
+          removeIns(store, worklist);
+      }
+      
+      m_removedIds[varId] = true;
+      progress = true;
+    }
+    
+    return progress;
+  }
+  
+  
+  void SpirvRegisterPromotion::removeIns(uint32_t ins, std::vector<uint32_t>& worklist) {
+    const spv::Op  op        = getOp(ins);
+    const uint32_t resultArg = getResultArg(op);
+    
+    m_ins[ins].removed = true;
+    
+    if (resultArg != 0)
+      m_removedIds[getArg(ins, resultArg)] = true;
+    
+    if (op == spv::OpLoad)
+      m_vars.at(getArg(ins, 3)).loadCount -= 1;
+    
+    countUses(ins, -1);
+    
+    for (uint32_t n = 1; n < m_ins[ins].length; n++) {
+      const int32_t def = n != resultArg ? getDef(getArg(ins, n)) : -1;
+      
+      if (def >= 0 && isRemovable(def))
+        worklist.push_back(def);
+    }
+  }
+  
+  
+  bool SpirvRegisterPromotion::isRemovable(uint32_t ins) const {
+    if (m_ins[ins].removed)
+      return false;
+    
+    const spv::Op op = getOp(ins);
+    
+    if (op == spv::OpLoad) {
+      if (m_ins[ins].length != 4 || !isPromoted(getArg(ins, 3)))
+        return false;
+    } else if (!hasIdOperands(op)
+            && op != spv::OpCompositeExtract
+            && op != spv::OpCompositeInsert
+            && op != spv::OpVectorShuffle) {
+      return false;
+    }
+    
+    return m_uses[getArg(ins, 2)] == 0;
+  }
+  
+  
+  bool SpirvRegisterPromotion::isPromoted(uint32_t id) const {
+    auto entry = m_vars.find(id);
+    
+    return entry != m_vars.end()
+        && entry->second.eligible;
+  }
+  
+  
+  uint32_t SpirvRegisterPromotion::resolveCopy(uint32_t id) const {
+    int32_t def = getDef(id);
+    
+    while (def >= 0 && !m_ins[def].removed && getOp(def) == spv::OpCopyObject) {
+      id  = getArg(def, 3);
+      def = getDef(id);
+    }
+    
+    return id;
+  }
+  
+  
+  uint32_t SpirvRegisterPromotion::getVectorSize(uint32_t id) const {
+    const int32_t def = getDef(id);
+    
+    if (def < 0 || getResultArg(getOp(def)) != 2)
+      return 0;
+    
+    const uint32_t typeId = getArg(def, 1);
+    
+    return typeId < m_vectorSizes.size()
+      ? m_vectorSizes[typeId] : 0;
+  }
+  
+  
+  int32_t SpirvRegisterPromotion::getDef(uint32_t id) const {
+    return id < m_defs.size() ? m_defs[id] : -1;
+  }
+  
+  
+  void SpirvRegisterPromotion::replaceIns(uint32_t ins, std::initializer_list<uint32_t> words) {
+    m_ins[ins].offset = m_words.size();
+    m_ins[ins].length = words.size();
+    m_words.insert(m_words.end(), words);
+  }
+  
+  
+  void SpirvRegisterPromotion::countUses(uint32_t ins, int32_t delta) {
+    const spv::Op  op        = getOp(ins);
+    const uint32_t resultArg = getResultArg(op);
+    
+    // Debug names and decorations do not keep
+    // an instruction alive, they get removed
+    if (op == spv::OpName || op == spv::OpMemberName
+     || op == spv::OpDecorate || op == spv::OpMemberDecorate)
+      return;
+    
+    for (uint32_t n = 1; n < m_ins[ins].length; n++) {
+      const uint32_t word = getArg(ins, n);
+      
+      if (n != resultArg && word < m_uses.size())
+        m_uses[word] += delta;
+    }
+  }
+  
+  
+  uint32_t SpirvRegisterPromotion::getResultArg(spv::Op op) {
+    if (hasIdOperands(op))
+      return 2;
+    
+    switch (op) {
+      case spv::OpString:
+      case spv::OpExtInstImport:
+      case spv::OpTypeVoid:
+      case spv::OpTypeBool:
+      case spv::OpTypeInt:
+      case spv::OpTypeFloat:
+      case spv::OpTypeVector:
+      case spv::OpTypeMatrix:
+      case spv::OpTypeImage:
+      case spv::OpTypeSampler:
+      case spv::OpTypeSampledImage:
+      case spv::OpTypeArray:
+      case spv::OpTypeRuntimeArray:
+      case spv::OpTypeStruct:
+      case spv::OpTypePointer:
+      case spv::OpTypeFunction:
+      case spv::OpLabel:
+        return 1;
+      
+      case spv::OpUndef:
+      case spv::OpConstantTrue:
+      case spv::OpConstantFalse:
+      case spv::OpConstant:
+      case spv::OpConstantComposite:
+      case spv::OpConstantNull:
+      case spv::OpSpecConstantTrue:
+      case spv::OpSpecConstantFalse:
+      case spv::OpSpecConstant:
+      case spv::OpFunction:
+      case spv::OpFunctionParameter:
+      case spv::OpFunctionCall:
+      case spv::OpVariable:
+      case spv::OpLoad:
+      case spv::OpAccessChain:
+      case spv::OpVectorShuffle:
+      case spv::OpCompositeExtract:
+      case spv::OpCompositeInsert:
+      case spv::OpExtInst:
+      case spv::OpSampledImage:
+      case spv::OpImageSampleImplicitLod:
+      case spv::OpImageSampleExplicitLod:
+      case spv::OpImageSampleDrefImplicitLod:
+      case spv::OpImageSampleDrefExplicitLod:
+      case spv::OpImageFetch:
+      case spv::OpImageGather:
+      case spv::OpImageDrefGather:
+      case spv::OpImageRead:
+      case spv::OpImageQuerySizeLod:
+      case spv::OpImageQuerySize:
+      case spv::OpImageQueryLevels:
+      case spv::OpImageQuerySamples:
+      case spv::OpDPdx:
+      case spv::OpDPdy:
+      case spv::OpFwidth:
+      case spv::OpDPdxFine:
+      case spv::OpDPdyFine:
+      case spv::OpDPdxCoarse:
+      case spv::OpDPdyCoarse:
+      case spv::OpPhi:
+        return 2;
+      
+      default:
+        return 0;
+    }
+  }
+  
+  
+  bool SpirvRegisterPromotion::hasIdOperands(spv::Op op) {
+    // Instructions without side effects which take a
+    // result type, a result ID and nothing but IDs
+    switch (op) {
+      case spv::OpCopyObject:
+      case spv::OpCompositeConstruct:
+      case spv::OpConvertFToU:
+      case spv::OpConvertFToS:
+      case spv::OpConvertSToF:
+      case spv::OpConvertUToF:
+      case spv::OpBitcast:
+      case spv::OpSNegate:
+      case spv::OpFNegate:
+      case spv::OpIAdd:
+      case spv::OpFAdd:
+      case spv::OpISub:
+      case spv::OpFSub:
+      case spv::OpIMul:
+      case spv::OpFMul:
+      case spv::OpUDiv:
+      case spv::OpSDiv:
+      case spv::OpFDiv:
+      case spv::OpUMod:
+      case spv::OpSRem:
+      case spv::OpSMod:
+      case spv::OpFRem:
+      case spv::OpFMod:
+      case spv::OpVectorTimesScalar:
+      case spv::OpDot:
+      case spv::OpIsNan:
+      case spv::OpIsInf:
+      case spv::OpAny:
+      case spv::OpAll:
+      case spv::OpLogicalEqual:
+      case spv::OpLogicalNotEqual:
+      case spv::OpLogicalOr:
+      case spv::OpLogicalAnd:
+      case spv::OpLogicalNot:
+      case spv::OpSelect:
+      case spv::OpIEqual:
+      case spv::OpINotEqual:
+      case spv::OpUGreaterThan:
+      case spv::OpSGreaterThan:
+      case spv::OpUGreaterThanEqual:
+      case spv::OpSGreaterThanEqual:
+      case spv::OpULessThan:
+      case spv::OpSLessThan:
+      case spv::OpULessThanEqual:
+      case spv::OpSLessThanEqual:
+      case spv::OpFOrdEqual:
+      case spv::OpFUnordEqual:
+      case spv::OpFOrdNotEqual:
+      case spv::OpFUnordNotEqual:
+      case spv::OpFOrdLessThan:
+      case spv::OpFUnordLessThan:
+      case spv::OpFOrdGreaterThan:
+      case spv::OpFUnordGreaterThan:
+      case spv::OpFOrdLessThanEqual:
+      case spv::OpFUnordLessThanEqual:
+      case spv::OpFOrdGreaterThanEqual:
+      case spv::OpFUnordGreaterThanEqual:
+      case spv::OpShiftRightLogical:
+      case spv::OpShiftRightArithmetic:
+      case spv::OpShiftLeftLogical:
+      case spv::OpBitwiseOr:
+      case spv::OpBitwiseXor:
+      case spv::OpBitwiseAnd:
+      case spv::OpNot:
+      case spv::OpBitFieldInsert:
+      case spv::OpBitFieldSExtract:
+      case spv::OpBitFieldUExtract:
+      case spv::OpBitReverse:
+      case spv::OpBitCount:
+        return true;
+      
+      default:
+        return false;
+    }
+  }
+  
+  
+  bool SpirvRegisterPromotion::isTerminator(spv::Op op) {
+    switch (op) {
+      case spv::OpBranch:
+      case spv::OpBranchConditional:
+      case spv::OpSwitch:
+      case spv::OpReturn:
+      case spv::OpReturnValue:
+      case spv::OpKill:
+      case spv::OpUnreachable:
+        return true;
+      
+      default:
+        return false;
+    }
+  }
+
+}
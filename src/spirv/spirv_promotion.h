@@ -0,0 +1,137 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "spirv_code_buffer.h"
+
+namespace dxvk {
+  
+  /**
+   * \brief Register promotion pass
+   * 
+   * Optimizes accesses to a set of \c Private variables
+   * in a compiled SPIR-V module, which is how the DXBC
+   * compiler declares temporary registers:
+   * 
+   * - Variables only accessed from a single function
+   *   through whole-variable loads and stores are moved
+   *   to \c Function storage.
+   * - Within a block, loads are replaced by the value
+   *   that was last stored to or loaded from the variable,
+   *   and stores that are overwritten before being read
+   *   are removed. Variables that are never read from
+   *   memory are removed along with all their stores.
+   * - Component extracts, inserts and shuffles are folded
+   *   through each other, so that individual components
+   *   become plain SSA values, and unused results are
+   *   removed afterwards.
+   * 
+   * Values are not forwarded across blocks, since that
+   * would require inserting \c OpPhi instructions.
+   */
+  class SpirvRegisterPromotion {
+  
+  public:
+    
+    SpirvRegisterPromotion(
+            size_t                varCount,
+      const uint32_t*             varIds);
+    
+    ~SpirvRegisterPromotion();
+    
+    /**
+     * \brief Runs the pass
+     * 
+     * \param [in] code Module, including the header
+     * \returns Optimized module
+     */
+    SpirvCodeBuffer run(const SpirvCodeBuffer& code);
+  
+  private:
+    
+    struct Ins {
+      uint32_t offset;
+      uint32_t length;
+      bool     removed;
+    };
+    
+    struct Var {
+      int32_t  decl      = -1;
+      int32_t  function  = -1;
+      int32_t  label     = -1;
+      bool     eligible  = true;
+      uint32_t loadCount = 0;
+      uint32_t ptrType   = 0;
+      std::vector<uint32_t> stores;
+    };
+    
+    struct VarState {
+      uint32_t value;
+      int32_t  store;
+    };
+    
+    std::vector<uint32_t> m_words;
+    std::vector<Ins>      m_ins;
+    
+    uint32_t m_bound = 0;
+    
+    std::vector<uint32_t>             m_varIds;
+    std::unordered_map<uint32_t, Var> m_vars;
+    
+    std::vector<int32_t>  m_defs;
+    std::vector<uint32_t> m_vectorSizes;
+    std::vector<uint32_t> m_uses;
+    std::vector<bool>     m_removedIds;
+    
+    std::unordered_map<uint32_t, std::vector<uint32_t>> m_extraWords;
+    
+    void parse(const SpirvCodeBuffer& code);
+    
+    void declareLocals();
+    
+    void forwardValues();
+    
+    void foldComponents();
+    
+    void removeDeadCode();
+    
+    bool removeDeadStores(std::vector<uint32_t>& worklist);
+    
+    void removeIns(uint32_t ins, std::vector<uint32_t>& worklist);
+    
+    bool isRemovable(uint32_t ins) const;
+    
+    bool isPromoted(uint32_t id) const;
+    
+    uint32_t resolveCopy(uint32_t id) const;
+    
+    uint32_t getVectorSize(uint32_t id) const;
+    
+    int32_t getDef(uint32_t id) const;
+    
+    spv::Op getOp(uint32_t ins) const {
+      return spv::Op(m_words[m_ins[ins].offset] & spv::OpCodeMask);
+    }
+    
+    uint32_t getArg(uint32_t ins, uint32_t arg) const {
+      return m_words[m_ins[ins].offset + arg];
+    }
+    
+    void setArg(uint32_t ins, uint32_t arg, uint32_t word) {
+      m_words[m_ins[ins].offset + arg] = word;
+    }
+    
+    void replaceIns(uint32_t ins, std::initializer_list<uint32_t> words);
+    
+    void countUses(uint32_t ins, int32_t delta);
+    
+    static uint32_t getResultArg(spv::Op op);
+    
+    static bool hasIdOperands(spv::Op op);
+    
+    static bool isTerminator(spv::Op op);
+  
+  };
+
+}
@@ -1,4 +1,5 @@
 #include "log.h"
+#include "log_async.h"
 
 #include "../util_env.h"
 
@@ -6,12 +7,20 @@ namespace dxvk {
   
   Logger::Logger(const std::string& file_name)
   : m_minLevel(getMinLogLevel()) {
-    if (m_minLevel != LogLevel::None)
+    if (m_minLevel != LogLevel::None) {
       m_fileStream = std::ofstream(getFileName(file_name));
+      
+      if (env::getEnvVar(L"DXVK_LOG_ASYNC") == "1")
+        m_asyncSink = std::make_unique<AsyncLogSink>(m_fileStream);
+    }
   }
   
   
-  Logger::~Logger() { }
+  Logger::~Logger() {
+    // Write out pending messages before
+    // the file stream gets closed
+    m_asyncSink = nullptr;
+  }
   
   
   void Logger::trace(const std::string& message) {
@@ -46,12 +55,17 @@ namespace dxvk {
   
   void Logger::emitMsg(LogLevel level, const std::string& message) {
     if (level >= m_minLevel) {
-      std::lock_guard<std::mutex> lock(m_mutex);
-      
       static std::array<const char*, 5> s_prefixes
         = {{ "trace: ", "debug: ", "info:  ", "warn:  ", "err:   " }};
       
       const char* prefix = s_prefixes.at(static_cast<uint32_t>(level));
+      
+      if (m_asyncSink != nullptr) {
+        m_asyncSink->push(level, prefix + message + '\n');
+        return;
+      }
+      
+      std::lock_guard<std::mutex> lock(m_mutex);
       std::cerr    << prefix << message << std::endl;
       m_fileStream << prefix << message << std::endl;
     }
@@ -3,9 +3,12 @@
 #include <array>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <string>
 
+#include "../util_string.h"
+
 namespace dxvk {
   
   enum class LogLevel : uint32_t {
@@ -17,6 +20,8 @@ namespace dxvk {
     None  = 5,
   };
   
+  class AsyncLogSink;
+  
   /**
    * \brief Logger
    * 
@@ -37,6 +42,36 @@ namespace dxvk {
     static void err  (const std::string& message);
     static void log  (LogLevel level, const std::string& message);
     
+    /**
+     * \brief Formats and logs a message
+     * 
+     * The arguments are only formatted if the given
+     * log level is enabled, so that disabled debug
+     * messages do not cost any string operations.
+     * \param [in] level Log level
+     * \param [in] args Message parts
+     */
+    template<typename... Args>
+    static void logf(LogLevel level, const Args&... args) {
+      if (level >= logLevel())
+        s_instance.emitMsg(level, str::format(args...));
+    }
+    
+    template<typename... Args>
+    static void tracef(const Args&... args) { logf(LogLevel::Trace, args...); }
+    
+    template<typename... Args>
+    static void debugf(const Args&... args) { logf(LogLevel::Debug, args...); }
+    
+    template<typename... Args>
+    static void infof (const Args&... args) { logf(LogLevel::Info,  args...); }
+    
+    template<typename... Args>
+    static void warnf (const Args&... args) { logf(LogLevel::Warn,  args...); }
+    
+    template<typename... Args>
+    static void errf  (const Args&... args) { logf(LogLevel::Error, args...); }
+    
     static LogLevel logLevel() {
       return s_instance.m_minLevel;
     }
@@ -50,6 +85,8 @@ namespace dxvk {
     std::mutex    m_mutex;
     std::ofstream m_fileStream;
     
+    std::unique_ptr<AsyncLogSink> m_asyncSink;
+    
     void emitMsg(LogLevel level, const std::string& message);
     
     static LogLevel getMinLogLevel();
@@ -0,0 +1,239 @@
+#include "log_async.h"
+
+namespace dxvk {
+  
+  AsyncLogSink::AsyncLogSink(std::ofstream& fileStream)
+  : m_fileStream(fileStream) {
+    for (uint32_t i = 0; i < RingSize; i++)
+      m_ring[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  
+  
+  AsyncLogSink::~AsyncLogSink() {
+    // The writer also wakes up periodically, so it will
+    // see the stop flag even if the notification is lost.
+    m_stopped.store(true);
+    m_cond.notify_all();
+    
+    if (m_thread.joinable())
+      m_thread.join();
+    
+    // If the writer was never started or got terminated
+    // before it could finish, write the messages out here.
+    if (!m_finished) {
+      std::string batch;
+      this->writeMessages(batch, true);
+    }
+  }
+  
+  
+  void AsyncLogSink::push(LogLevel level, std::string&& line) {
+    if (!m_started.load(std::memory_order_acquire))
+      this->startWriter();
+    
+    while (!this->tryPush(line)) {
+      if (level < LogLevel::Error) {
+        m_dropped += 1;
+        return;
+      }
+      
+      std::this_thread::yield();
+    }
+    
+    // The writer also wakes up periodically, so a missed
+    // notification only delays the message a little.
+    if (m_sleeping.load())
+      m_cond.notify_one();
+  }
+  
+  
+  bool AsyncLogSink::tryPush(std::string& line) {
+    uint64_t pos = m_writePos.load(std::memory_order_relaxed);
+    
+    while (true) {
+      Entry&   entry = m_ring[pos % RingSize];
+      uint64_t seq   = entry.sequence.load(std::memory_order_acquire);
+      int64_t  diff  = int64_t(seq) - int64_t(pos);
+      
+      if (diff < 0)
+        return false;
+      
+      if (diff == 0) {
+        if (m_writePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          entry.line = std::move(line);
+          entry.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else {
+        pos = m_writePos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+  
+  
+  bool AsyncLogSink::tryPop(std::string& line) {
+    Entry& entry = m_ring[m_readPos % RingSize];
+    
+    if (entry.sequence.load(std::memory_order_acquire) != m_readPos + 1)
+      return false;
+    
+    line = std::move(entry.line);
+    entry.line.clear();
+    entry.sequence.store(m_readPos + RingSize, std::memory_order_release);
+    
+    m_readPos += 1;
+    return true;
+  }
+  
+  
+  void AsyncLogSink::startWriter() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_started.load(std::memory_order_relaxed))
+      return;
+    
+    m_thread = std::thread([this] () { this->runWriter(); });
+    m_started.store(true, std::memory_order_release);
+  }
+  
+  
+  void AsyncLogSink::runWriter() {
+    std::string batch;
+    
+    while (true) {
+      const bool stopped = m_stopped.load();
+      
+      this->writeMessages(batch, stopped);
+      
+      if (stopped) {
+        m_finished = true;
+        return;
+      }
+      
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_sleeping.store(true);
+      
+      m_cond.wait_for(lock, std::chrono::milliseconds(50), [this] () {
+        return m_stopped.load()
+            || m_ring[m_readPos % RingSize].sequence.load() == m_readPos + 1;
+      });
+      
+      m_sleeping.store(false);
+    }
+  }
+  
+  
+  void AsyncLogSink::writeMessages(
+          std::string&  batch,
+          bool          stopped) {
+    const Clock::time_point now = Clock::now();
+    
+    std::string line;
+    
+    while (this->tryPop(line))
+      this->processLine(batch, std::move(line), now);
+    
+    uint32_t dropped = m_dropped.exchange(0);
+    
+    if (dropped != 0) {
+      this->flushRepeats(batch);
+      batch += "warn:  Log buffer full, dropped " + std::to_string(dropped) + " messages\n";
+      m_lastLine.clear();
+    }
+    
+    // Report repeated messages at least once per second
+    // even if the same message keeps getting logged.
+    if (stopped || now - m_lastRepeatFlush >= std::chrono::seconds(1)) {
+      this->flushRepeats(batch);
+      m_lastRepeatFlush = now;
+    }
+    
+    // Likewise, report suppressed messages once their
+    // rate window ends, even if they do not recur.
+    this->flushSuppressed(batch, now, stopped);
+    
+    if (!batch.empty()) {
+      std::cerr    << batch;
+      m_fileStream << batch;
+      m_fileStream.flush();
+      batch.clear();
+    }
+  }
+  
+  
+  void AsyncLogSink::processLine(
+          std::string&  batch,
+          std::string&& line,
+          Clock::time_point now) {
+    if (line == m_lastLine) {
+      m_lastRepeats += 1;
+      return;
+    }
+    
+    this->flushRepeats(batch);
+    this->flushSuppressed(batch, now, false);
+    
+    if (m_rates.size() >= MaxRateEntries) {
+      this->flushSuppressed(batch, now, true);
+      m_rates.clear();
+    }
+    
+    auto entry = m_rates.find(line);
+    
+    if (entry == m_rates.end())
+      entry = m_rates.insert({ line, RateInfo { now, 0u, 0u } }).first;
+    else if (now - entry->second.windowStart >= std::chrono::seconds(1))
+      entry->second = RateInfo { now, 0u, 0u };
+    
+    if (++entry->second.count > MaxRatePerSecond) {
+      if (entry->second.suppressed++ == 0)
+        m_suppressedLines.push_back(entry->first);
+      
+      // Do not count the next message as a repetition
+      // of whatever was written before this one
+      m_lastLine.clear();
+      return;
+    }
+    
+    batch += line;
+    m_lastLine = std::move(line);
+  }
+  
+  
+  void AsyncLogSink::flushRepeats(
+          std::string&  batch) {
+    if (m_lastRepeats != 0) {
+      batch += "info:  (previous message repeated "
+            +  std::to_string(m_lastRepeats) + " times)\n";
+    }
+    
+    m_lastRepeats = 0;
+  }
+  
+  
+  void AsyncLogSink::flushSuppressed(
+          std::string&  batch,
+          Clock::time_point now,
+          bool          force) {
+    for (auto i = m_suppressedLines.begin(); i != m_suppressedLines.end(); ) {
+      RateInfo& info = m_rates.at(*i);
+      
+      if (!force && now - info.windowStart < std::chrono::seconds(1)) {
+        i++;
+        continue;
+      }
+      
+      this->flushRepeats(batch);
+      
+      batch += "info:  (" + std::to_string(info.suppressed)
+            +  " occurrences of the following message suppressed)\n";
+      batch += *i;
+      
+      m_lastLine.clear();
+      info.suppressed = 0;
+      
+      i = m_suppressedLines.erase(i);
+    }
+  }
+  
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "log.h"
+
+namespace dxvk {
+  
+  /**
+   * \brief Asynchronous log sink
+   *
+   * Messages are added to a lock-free ring buffer which
+   * any number of threads can write to, and a background
+   * thread writes them to the log file and \c stderr in
+   * batches. Consecutive identical messages are collapsed
+   * into a single line, and any message that is logged
+   * more than a few times per second is suppressed.
+   *
+   * If the ring buffer is full, messages are dropped,
+   * except for errors which wait for space to become
+   * available. Messages that have not been written
+   * yet are lost if the process crashes.
+   * 
+   * The writer thread is started on the first message
+   * rather than on construction, since the sink may be
+   * created from a static constructor while the loader
+   * lock is held. The destructor joins the thread and
+   * writes out any messages it did not get to, e.g. if
+   * the thread was terminated at process exit.
+   */
+  class AsyncLogSink {
+    using Clock = std::chrono::steady_clock;
+    
+    constexpr static uint32_t RingSize         = 1024;
+    constexpr static uint32_t MaxRatePerSecond = 20;
+    constexpr static uint32_t MaxRateEntries   = 4096;
+  public:
+    
+    AsyncLogSink(std::ofstream& fileStream);
+    ~AsyncLogSink();
+    
+    AsyncLogSink             (const AsyncLogSink&) = delete;
+    AsyncLogSink& operator = (const AsyncLogSink&) = delete;
+    
+    /**
+     * \brief Adds a message to the ring buffer
+     *
+     * Never blocks unless the ring buffer is full
+     * and the message is an error message.
+     * \param [in] level Log level of the message
+     * \param [in] line Message, including the prefix
+     */
+    void push(LogLevel level, std::string&& line);
+    
+  private:
+    
+    struct Entry {
+      std::atomic<uint64_t> sequence;
+      std::string           line;
+    };
+    
+    struct RateInfo {
+      Clock::time_point windowStart;
+      uint32_t          count;
+      uint32_t          suppressed;
+    };
+    
+    std::ofstream&            m_fileStream;
+    
+    std::array<Entry, RingSize> m_ring;
+    std::atomic<uint64_t>     m_writePos = { 0ull };
+    uint64_t                  m_readPos  = 0;
+    
+    std::atomic<uint32_t>     m_dropped  = { 0u };
+    std::atomic<bool>         m_stopped  = { false };
+    std::atomic<bool>         m_sleeping = { false };
+    
+    std::mutex                m_mutex;
+    std::condition_variable   m_cond;
+    std::atomic<bool>         m_started  = { false };
+    bool                      m_finished = false;
+    
+    std::string               m_lastLine;
+    uint32_t                  m_lastRepeats = 0;
+    Clock::time_point         m_lastRepeatFlush;
+    
+    std::unordered_map<std::string, RateInfo> m_rates;
+    std::vector<std::string>  m_suppressedLines;
+    
+    std::thread               m_thread;
+    
+    bool tryPush(std::string& line);
+    
+    bool tryPop(std::string& line);
+    
+    void startWriter();
+    
+    void runWriter();
+    
+    void writeMessages(
+            std::string&  batch,
+            bool          stopped);
+    
+    void processLine(
+            std::string&  batch,
+            std::string&& line,
+            Clock::time_point now);
+    
+    void flushRepeats(
+            std::string&  batch);
+    
+    void flushSuppressed(
+            std::string&  batch,
+            Clock::time_point now,
+            bool          force);
+            
+  };
+  
+}
@@ -35,6 +35,9 @@ namespace dxvk::debug {
   
   template<typename... Args>
   void trace(const std::string& funcName, const Args&... args) {
+    if (Logger::logLevel() > LogLevel::Trace)
+      return;
+    
     std::stringstream stream;
     stream << methodName(funcName) << "(";
     traceArgs(stream, args...);
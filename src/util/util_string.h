@@ -26,4 +26,8 @@ namespace dxvk::str {
     return std::wstring_convert<std::codecvt_utf8<wchar_t>>().to_bytes(ws);
   }
   
+  inline std::wstring tows(const std::string& str) {
+    return std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(str);
+  }
+  
 }
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+#include <dxbc_module.h>
+#include <dxvk_shader.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxbc-bench-compiler.log");
+}
+
+using namespace dxvk;
+
+using Clock = std::chrono::high_resolution_clock;
+
+/**
+ * \brief Measures shader compile times
+ * 
+ * Compiles every DXBC file passed on the command line,
+ * e.g. files dumped via \c DXVK_SHADER_DUMP_PATH, and
+ * reports the time taken to translate each shader.
+ */
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    Logger::err("Usage: dxbc-bench-compiler [-n iterations] file.dxbc...");
+    return 1;
+  }
+  
+  uint32_t iterations = 10;
+  int      firstFile  = 1;
+  
+  if (argc > 3 && std::string(argv[1]) == "-n") {
+    iterations = std::max(1, std::atoi(argv[2]));
+    firstFile  = 3;
+  }
+  
+  double totalTime = 0.0;
+  double worstTime = 0.0;
+  size_t fileCount = 0;
+  
+  std::string worstFile;
+  
+  for (int i = firstFile; i < argc; i++) {
+    std::ifstream file(argv[i], std::ios::binary);
+    
+    if (!file) {
+      Logger::warn(str::format("Failed to open ", argv[i]));
+      continue;
+    }
+    
+    std::vector<char> dxbcCode(
+      (std::istreambuf_iterator<char>(file)),
+      (std::istreambuf_iterator<char>()));
+    
+    try {
+      Rc<DxvkShader> shader;
+      
+      auto t0 = Clock::now();
+      
+      for (uint32_t n = 0; n < iterations; n++) {
+        DxbcReader reader(dxbcCode.data(), dxbcCode.size());
+        DxbcModule module(reader);
+        
+        shader = module.compile(DxbcOptions(), argv[i]);
+      }
+      
+      auto t1 = Clock::now();
+      
+      std::ostringstream spirvCode;
+      shader->dump(spirvCode);
+      
+      double time = std::chrono::duration<double, std::milli>(t1 - t0).count() / iterations;
+      
+      Logger::info(str::format(argv[i], ": ", time, " ms, ",
+        dxbcCode.size(), " bytes DXBC, ", spirvCode.str().size(), " bytes SPIR-V"));
+      
+      if (time > worstTime) {
+        worstTime = time;
+        worstFile = argv[i];
+      }
+      
+      totalTime += time;
+      fileCount += 1;
+    } catch (const DxvkError& e) {
+      Logger::err(str::format(argv[i], ": ", e.message()));
+    }
+  }
+  
+  if (fileCount != 0) {
+    Logger::info(str::format(fileCount, " shaders: ", totalTime, " ms total, ",
+      totalTime / fileCount, " ms average, ", worstTime, " ms worst (", worstFile, ")"));
+  }
+  
+  return 0;
+}
@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+#include <dxbc_module.h>
+#include <dxvk_instance.h>
+#include <dxvk_pipelayout.h>
+#include <dxvk_shader.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxbc-bench-promote.log");
+}
+
+using namespace dxvk;
+
+using Clock = std::chrono::high_resolution_clock;
+
+/**
+ * \brief Counts SPIR-V instructions of a shader
+ */
+size_t countInstructions(const Rc<DxvkShader>& shader) {
+  std::stringstream stream;
+  shader->dump(stream);
+  
+  SpirvCodeBuffer code(stream);
+  size_t count = 0;
+  
+  for (auto i = code.begin(); i != code.end(); ++i)
+    count += 1;
+  
+  return count;
+}
+
+
+/**
+ * \brief Measures driver compile times
+ * 
+ * Compute shaders are compiled into a pipeline. For
+ * all other stages, only the shader module is created,
+ * since pipelines would require additional state, and
+ * many drivers defer compilation to pipeline creation.
+ * Returns the average time in milliseconds.
+ */
+double measureCompile(
+  const Rc<DxvkDevice>&       device,
+  const Rc<DxvkShader>&       shader,
+        bool                  isCompute,
+        uint32_t              iterations) {
+  const Rc<vk::DeviceFn> vkd = device->vkd();
+  
+  DxvkDescriptorSlotMapping mapping;
+  shader->defineResourceSlots(mapping);
+  
+  Rc<DxvkPipelineLayout> layout = new DxvkPipelineLayout(vkd,
+    mapping.bindingCount(), mapping.bindingInfos(),
+    VK_PIPELINE_BIND_POINT_COMPUTE);
+  
+  auto t0 = Clock::now();
+  
+  for (uint32_t i = 0; i < iterations; i++) {
+    Rc<DxvkShaderModule> module = shader->createShaderModule(vkd, mapping);
+    
+    if (isCompute) {
+      VkComputePipelineCreateInfo info;
+      info.sType              = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+      info.pNext              = nullptr;
+      info.flags              = 0;
+      info.stage              = module->stageInfo(nullptr);
+      info.layout             = layout->pipelineLayout();
+      info.basePipelineHandle = VK_NULL_HANDLE;
+      info.basePipelineIndex  = -1;
+      
+      VkPipeline pipeline = VK_NULL_HANDLE;
+      
+      if (vkd->vkCreateComputePipelines(vkd->device(),
+            VK_NULL_HANDLE, 1, &info, nullptr, &pipeline) != VK_SUCCESS)
+        throw DxvkError("Failed to create compute pipeline");
+      
+      vkd->vkDestroyPipeline(vkd->device(), pipeline, nullptr);
+    }
+  }
+  
+  auto t1 = Clock::now();
+  return std::chrono::duration<double, std::milli>(t1 - t0).count() / iterations;
+}
+
+
+/**
+ * \brief Measures the effect of temp register promotion
+ * 
+ * Compiles every DXBC file passed on the command line,
+ * e.g. files dumped via \c DXVK_SHADER_DUMP_PATH, with
+ * and without \c DxbcOptions::promoteTempRegisters, and
+ * reports the number of SPIR-V instructions as well as
+ * the time the driver takes to compile the shader on
+ * the first Vulkan adapter, if there is one. The driver's
+ * own shader cache should be disabled while running this.
+ */
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    Logger::err("Usage: dxbc-bench-promote [-n iterations] file.dxbc...");
+    return 1;
+  }
+  
+  uint32_t iterations = 10;
+  int      firstFile  = 1;
+  
+  if (argc > 3 && std::string(argv[1]) == "-n") {
+    iterations = std::max(1, std::atoi(argv[2]));
+    firstFile  = 3;
+  }
+  
+  Rc<DxvkDevice> device;
+  
+  try {
+    Rc<DxvkInstance> instance = new DxvkInstance();
+    std::vector<Rc<DxvkAdapter>> adapters = instance->enumAdapters();
+    
+    if (!adapters.empty())
+      device = adapters[0]->createDevice(adapters[0]->features());
+  } catch (const DxvkError& e) {
+    Logger::warn(str::format("No Vulkan device, only counting instructions: ", e.message()));
+  }
+  
+  DxbcOptions options = device != nullptr
+    ? DxbcOptions(device)
+    : DxbcOptions();
+  
+  std::array<size_t, 2> totalCount = {{ 0, 0 }};
+  std::array<double, 2> totalTime  = {{ 0.0, 0.0 }};
+  size_t fileCount = 0;
+  
+  for (int i = firstFile; i < argc; i++) {
+    std::ifstream file(argv[i], std::ios::binary);
+    
+    if (!file) {
+      Logger::warn(str::format("Failed to open ", argv[i]));
+      continue;
+    }
+    
+    std::vector<char> dxbcCode(
+      (std::istreambuf_iterator<char>(file)),
+      (std::istreambuf_iterator<char>()));
+    
+    try {
+      DxbcReader reader(dxbcCode.data(), dxbcCode.size());
+      DxbcModule module(reader);
+      
+      const bool isCompute = module.version().type() == DxbcProgramType::ComputeShader;
+      
+      std::array<size_t, 2> count = {{ 0, 0 }};
+      std::array<double, 2> time  = {{ 0.0, 0.0 }};
+      
+      for (uint32_t promote = 0; promote < 2; promote++) {
+        options.promoteTempRegisters = promote != 0;
+        
+        Rc<DxvkShader> shader = module.compile(options, argv[i]);
+        count[promote] = countInstructions(shader);
+        
+        if (device != nullptr)
+          time[promote] = measureCompile(device, shader, isCompute, iterations);
+        
+        totalCount[promote] += count[promote];
+        totalTime [promote] += time[promote];
+      }
+      
+      Logger::info(str::format(argv[i], ": ",
+        count[0], " -> ", count[1], " instructions, ",
+        time[0], " -> ", time[1], " ms ", isCompute ? "(pipeline)" : "(module)"));
+      
+      fileCount += 1;
+    } catch (const DxvkError& e) {
+      Logger::err(str::format(argv[i], ": ", e.message()));
+    }
+  }
+  
+  if (fileCount != 0) {
+    Logger::info(str::format(fileCount, " shaders: ",
+      totalCount[0], " -> ", totalCount[1], " instructions, ",
+      totalTime[0], " -> ", totalTime[1], " ms"));
+  }
+  
+  return 0;
+}
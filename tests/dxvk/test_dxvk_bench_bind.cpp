@@ -0,0 +1,234 @@
+#include <array>
+#include <chrono>
+#include <type_traits>
+
+#include <dxvk_cs.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-bench-bind.log");
+}
+
+using namespace dxvk;
+
+using Clock = std::chrono::high_resolution_clock;
+
+/**
+ * \brief Reference count operations
+ *
+ * Incremented whenever the reference count of a view
+ * changes, each of which is an atomic operation.
+ */
+static uint64_t g_refOps = 0;
+
+/**
+ * \brief View object
+ *
+ * Stands in for image and buffer views. Shadows
+ * the reference counting methods of \c RcObject
+ * so that \c Rc can count atomic operations.
+ */
+class View : public RcObject {
+  
+public:
+  
+  uint32_t incRef() {
+    g_refOps += 1;
+    return RcObject::incRef();
+  }
+  
+  uint32_t decRef() {
+    g_refOps += 1;
+    return RcObject::decRef();
+  }
+  
+};
+
+/**
+ * \brief Context state
+ *
+ * Mirrors the image and buffer view members of
+ * the resource slots that \c DxvkContext uses.
+ */
+struct Slot {
+  Rc<View> imageView;
+  Rc<View> bufferView;
+};
+
+static std::array<Slot, 128> g_slots;
+
+struct BenchResult {
+  uint64_t commands = 0;
+  uint64_t bytes    = 0;
+  uint64_t refOps   = 0;
+  double   time     = 0.0;
+};
+
+
+/**
+ * \brief Records a command
+ *
+ * Also accounts for the amount of memory the
+ * command occupies within the chunk.
+ */
+template<typename Cmd>
+void emit(DxvkCsChunkRef& chunk, BenchResult& result, Cmd&& command) {
+  chunk->push(command);
+  
+  result.commands += 1;
+  result.bytes    += sizeof(DxvkCsTypedCmd<Cmd>);
+}
+
+
+/**
+ * \brief Binds views with one command per slot
+ *
+ * This is what the D3D11 context used to do in
+ * \c SetShaderResources for each changed slot.
+ */
+void bindPerSlot(DxvkCsChunkRef& chunk, BenchResult& result,
+    uint32_t startSlot, uint32_t count, const Rc<View>* views) {
+  for (uint32_t i = 0; i < count; i++) {
+    emit(chunk, result, [
+      cSlotId     = startSlot + i,
+      cImageView  = views[i],
+      cBufferView = Rc<View>()
+    ] (DxvkContext* ctx) {
+      Slot& slot = g_slots[cSlotId];
+      
+      if (slot.imageView  != cImageView
+       || slot.bufferView != cBufferView) {
+        slot.imageView  = cImageView;
+        slot.bufferView = cBufferView;
+      }
+    });
+  }
+}
+
+
+/**
+ * \brief Binds views with ranged commands
+ *
+ * Uses the same batch sizes as the D3D11 context. Views
+ * are moved into the context state when the chunk is
+ * only going to be executed once.
+ */
+void bindRanged(DxvkCsChunkRef& chunk, BenchResult& result,
+    uint32_t startSlot, uint32_t count, const Rc<View>* views, bool consume) {
+  auto emitBatch = [&] (auto batch, uint32_t first, uint32_t batchCount) {
+    std::array<Rc<View>, decltype(batch)::value> imageViews;
+    std::array<Rc<View>, decltype(batch)::value> bufferViews;
+    
+    for (uint32_t i = 0; i < batchCount; i++)
+      imageViews[i] = views[first + i];
+    
+    emit(chunk, result, [
+      cSlotId      = startSlot + first,
+      cCount       = batchCount,
+      cConsume     = consume,
+      cImageViews  = std::move(imageViews),
+      cBufferViews = std::move(bufferViews)
+    ] (DxvkContext* ctx) mutable {
+      for (uint32_t i = 0; i < cCount; i++) {
+        Slot& slot = g_slots[cSlotId + i];
+        
+        if (slot.imageView  != cImageViews [i]
+         || slot.bufferView != cBufferViews[i]) {
+          slot.imageView  = cConsume ? std::move(cImageViews [i]) : cImageViews [i];
+          slot.bufferView = cConsume ? std::move(cBufferViews[i]) : cBufferViews[i];
+        }
+      }
+    });
+  };
+  
+  for (uint32_t first = 0; first < count; first += 16) {
+    uint32_t batchCount = std::min(count - first, 16u);
+    
+    if (batchCount == 1)
+      emitBatch(std::integral_constant<uint32_t,  1>(), first, batchCount);
+    else if (batchCount <= 4)
+      emitBatch(std::integral_constant<uint32_t,  4>(), first, batchCount);
+    else
+      emitBatch(std::integral_constant<uint32_t, 16>(), first, batchCount);
+  }
+}
+
+
+/**
+ * \brief Binds alternating sets of views
+ *
+ * Each iteration binds \c count views starting at slot 0,
+ * alternating between two sets of views so that every
+ * slot changes, then executes the chunk. Returns the
+ * command count, chunk memory and reference count
+ * operations per iteration, and the time per view.
+ */
+template<typename Fn>
+BenchResult runBench(uint32_t count, uint32_t iterations, DxvkCsChunkFlags flags, const Fn& bind) {
+  Rc<DxvkCsChunkPool> pool = new DxvkCsChunkPool(DxvkCsChunkPool::DefaultChunkSize);
+  
+  std::array<std::array<Rc<View>, 128>, 2> views;
+  
+  for (auto& set : views) {
+    for (auto& view : set)
+      view = new View();
+  }
+  
+  BenchResult result;
+  g_refOps = 0;
+  
+  auto t0 = Clock::now();
+  
+  for (uint32_t i = 0; i < iterations; i++) {
+    DxvkCsChunkRef chunk = pool->allocChunk(flags);
+    bind(chunk, result, 0, count, views[i & 1].data());
+    chunk->executeAll(nullptr);
+  }
+  
+  auto t1 = Clock::now();
+  
+  result.refOps = g_refOps;
+  
+  for (auto& slot : g_slots)
+    slot = Slot();
+  
+  result.commands /= iterations;
+  result.bytes    /= iterations;
+  result.refOps   /= iterations;
+  result.time      = std::chrono::duration<double, std::nano>(t1 - t0).count() / (double(iterations) * count);
+  return result;
+}
+
+
+void logResult(const char* name, const BenchResult& result) {
+  Logger::info(str::format("  ", name, ": ",
+    result.commands, " commands, ",
+    result.bytes,    " bytes, ",
+    result.refOps,   " ref count ops, ",
+    result.time,     " ns/view"));
+}
+
+
+int main(int argc, char** argv) {
+  constexpr uint32_t Iterations = 200000;
+  
+  for (uint32_t count : { 1u, 4u, 8u, 16u, 128u }) {
+    Logger::info(str::format("Binding ", count, " views"));
+    
+    logResult("Per-slot         ", runBench(count, Iterations, DxvkCsChunkFlag::SingleUse,
+      [] (DxvkCsChunkRef& chunk, BenchResult& result, uint32_t start, uint32_t n, const Rc<View>* views) {
+        bindPerSlot(chunk, result, start, n, views);
+      }));
+    
+    logResult("Ranged           ", runBench(count, Iterations, DxvkCsChunkFlag::SingleUse,
+      [] (DxvkCsChunkRef& chunk, BenchResult& result, uint32_t start, uint32_t n, const Rc<View>* views) {
+        bindRanged(chunk, result, start, n, views, true);
+      }));
+    
+    logResult("Ranged, reusable ", runBench(count, Iterations, DxvkCsChunkFlags(),
+      [] (DxvkCsChunkRef& chunk, BenchResult& result, uint32_t start, uint32_t n, const Rc<View>* views) {
+        bindRanged(chunk, result, start, n, views, false);
+      }));
+  }
+  
+  return 0;
+}
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <dxvk_cs.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-bench-cs.log");
+}
+
+using namespace dxvk;
+
+using Clock = std::chrono::high_resolution_clock;
+
+/**
+ * \brief Measures chunk throughput
+ * 
+ * Dispatches chunks containing the given number of
+ * trivial commands and waits for all of them to be
+ * executed. Unless the pool is used, each chunk gets
+ * allocated from a pool of its own, which has the same
+ * cost as allocating and freeing chunks directly.
+ * Returns the number of chunks per second.
+ */
+double measureThroughput(uint32_t chunkCount, uint32_t cmdsPerChunk, bool usePool) {
+  DxvkCsThread thread(nullptr);
+  Rc<DxvkCsChunkPool> pool = new DxvkCsChunkPool(DxvkCsChunkPool::DefaultChunkSize);
+  uint64_t counter = 0;
+  
+  auto t0 = Clock::now();
+  
+  for (uint32_t i = 0; i < chunkCount; i++) {
+    DxvkCsChunkRef chunk = usePool
+      ? pool->allocChunk(DxvkCsChunkFlag::SingleUse)
+      : Rc<DxvkCsChunkPool>(new DxvkCsChunkPool(DxvkCsChunkPool::DefaultChunkSize))->allocChunk(DxvkCsChunkFlag::SingleUse);
+    
+    for (uint32_t j = 0; j < cmdsPerChunk; j++) {
+      auto cmd = [&counter] (DxvkContext* ctx) { counter += 1; };
+      chunk->push(cmd);
+    }
+    
+    thread.dispatchChunk(std::move(chunk));
+  }
+  
+  thread.synchronize();
+  
+  auto t1 = Clock::now();
+  
+  if (counter != uint64_t(chunkCount) * cmdsPerChunk)
+    Logger::err("Command count mismatch");
+  
+  return chunkCount / std::chrono::duration<double>(t1 - t0).count();
+}
+
+
+/**
+ * \brief Measures hand-off latency
+ * 
+ * Dispatches single-command chunks one at a time and
+ * measures the time until the command starts executing
+ * on the CS thread, as well as the round-trip time
+ * including \c synchronize. Returns median values.
+ */
+void measureLatency(uint32_t iterations, double& handoff, double& roundTrip) {
+  DxvkCsThread thread(nullptr);
+  Rc<DxvkCsChunkPool> pool = new DxvkCsChunkPool(DxvkCsChunkPool::DefaultChunkSize);
+  
+  std::vector<double> handoffTimes;
+  std::vector<double> roundTripTimes;
+  
+  for (uint32_t i = 0; i < iterations; i++) {
+    Clock::time_point tExec;
+    
+    DxvkCsChunkRef chunk = pool->allocChunk(DxvkCsChunkFlag::SingleUse);
+    auto cmd = [&tExec] (DxvkContext* ctx) { tExec = Clock::now(); };
+    chunk->push(cmd);
+    
+    auto t0 = Clock::now();
+    thread.dispatchChunk(std::move(chunk));
+    thread.synchronize();
+    auto t1 = Clock::now();
+    
+    handoffTimes  .push_back(std::chrono::duration<double, std::micro>(tExec - t0).count());
+    roundTripTimes.push_back(std::chrono::duration<double, std::micro>(t1    - t0).count());
+  }
+  
+  std::sort(handoffTimes.begin(),   handoffTimes.end());
+  std::sort(roundTripTimes.begin(), roundTripTimes.end());
+  
+  handoff   = handoffTimes  [iterations / 2];
+  roundTrip = roundTripTimes[iterations / 2];
+}
+
+
+/**
+ * \brief Measures command list replay
+ * 
+ * Executes a command list consisting of the given number
+ * of chunks multiple times. If \c rerecord is set, the
+ * commands are recorded again into single-use chunks for
+ * each execution, otherwise the same reusable chunks are
+ * dispatched every time. Returns executions per second.
+ */
+double measureReplay(uint32_t iterations, uint32_t chunksPerList, bool rerecord) {
+  constexpr uint32_t CmdsPerChunk = 128;
+  
+  DxvkCsThread thread(nullptr);
+  Rc<DxvkCsChunkPool> pool = new DxvkCsChunkPool(DxvkCsChunkPool::DefaultDeferredChunkSize);
+  uint64_t counter = 0;
+  
+  auto recordList = [&] (DxvkCsChunkFlags flags) {
+    std::vector<DxvkCsChunkRef> chunks;
+    
+    for (uint32_t i = 0; i < chunksPerList; i++) {
+      DxvkCsChunkRef chunk = pool->allocChunk(flags);
+      
+      for (uint32_t j = 0; j < CmdsPerChunk; j++) {
+        auto cmd = [&counter] (DxvkContext* ctx) { counter += 1; };
+        chunk->push(cmd);
+      }
+      
+      chunks.push_back(std::move(chunk));
+    }
+    
+    return chunks;
+  };
+  
+  std::vector<DxvkCsChunkRef> commandList;
+  
+  if (!rerecord)
+    commandList = recordList(DxvkCsChunkFlags());
+  
+  auto t0 = Clock::now();
+  
+  for (uint32_t i = 0; i < iterations; i++) {
+    if (rerecord)
+      commandList = recordList(DxvkCsChunkFlag::SingleUse);
+    
+    for (const auto& chunk : commandList)
+      thread.dispatchChunk(DxvkCsChunkRef(chunk));
+  }
+  
+  thread.synchronize();
+  
+  auto t1 = Clock::now();
+  
+  if (counter != uint64_t(iterations) * chunksPerList * CmdsPerChunk)
+    Logger::err("Command count mismatch");
+  
+  return iterations / std::chrono::duration<double>(t1 - t0).count();
+}
+
+
+int main(int argc, char** argv) {
+  for (bool usePool : { false, true }) {
+    for (uint32_t cmdsPerChunk : { 1u, 16u, 128u }) {
+      double chunksPerSecond = measureThroughput(200000, cmdsPerChunk, usePool);
+      
+      Logger::info(str::format("Throughput (", cmdsPerChunk, " commands per chunk, ",
+        usePool ? "pooled" : "not pooled", "): ", uint64_t(chunksPerSecond), " chunks/s"));
+    }
+  }
+  
+  double handoff   = 0.0;
+  double roundTrip = 0.0;
+  measureLatency(10000, handoff, roundTrip);
+  
+  Logger::info(str::format("Latency: ", handoff, " us hand-off, ", roundTrip, " us round trip"));
+  
+  for (bool rerecord : { true, false }) {
+    double listsPerSecond = measureReplay(2000, 64, rerecord);
+    
+    Logger::info(str::format("Command list (", rerecord ? "re-recorded" : "replayed", "): ",
+      uint64_t(listsPerSecond), " executions/s"));
+  }
+  return 0;
+}
@@ -0,0 +1,294 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <dxvk_tlsf.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-bench-memory.log");
+}
+
+using namespace dxvk;
+
+using Clock = std::chrono::high_resolution_clock;
+
+/**
+ * \brief Free list allocator
+ *
+ * The worst-fit free list that chunks used before
+ * switching to the TLSF allocator. Kept here as a
+ * baseline for comparison.
+ */
+class FreeListAllocator {
+  
+public:
+  
+  constexpr static VkDeviceSize InvalidOffset = ~VkDeviceSize(0);
+  
+  FreeListAllocator(VkDeviceSize size)
+  : m_size(size) {
+    m_freeList.push_back({ 0, size });
+  }
+  
+  VkDeviceSize alloc(VkDeviceSize size, VkDeviceSize align) {
+    if (m_freeList.size() == 0)
+      return InvalidOffset;
+    
+    auto bestSlice = m_freeList.begin();
+    
+    for (auto slice = m_freeList.begin(); slice != m_freeList.end(); slice++) {
+      if (slice->length == size) {
+        bestSlice = slice;
+        break;
+      } else if (slice->length > bestSlice->length) {
+        bestSlice = slice;
+      }
+    }
+    
+    const VkDeviceSize sliceStart = bestSlice->offset;
+    const VkDeviceSize sliceEnd   = bestSlice->offset + bestSlice->length;
+    
+    const VkDeviceSize allocStart = dxvk::align(sliceStart,        align);
+    const VkDeviceSize allocEnd   = dxvk::align(allocStart + size, align);
+    
+    if (allocEnd > sliceEnd)
+      return InvalidOffset;
+    
+    m_freeList.erase(bestSlice);
+    
+    if (allocStart != sliceStart)
+      m_freeList.push_back({ sliceStart, allocStart - sliceStart });
+    
+    if (allocEnd != sliceEnd)
+      m_freeList.push_back({ allocEnd, sliceEnd - allocEnd });
+    
+    m_lengths.push_back({ allocStart, allocEnd - allocStart });
+    return allocStart;
+  }
+  
+  void free(VkDeviceSize offset) {
+    auto entry = std::find_if(m_lengths.begin(), m_lengths.end(),
+      [offset] (const Slice& s) { return s.offset == offset; });
+    
+    VkDeviceSize length = entry->length;
+    m_lengths.erase(entry);
+    
+    auto curr = m_freeList.begin();
+    
+    while (curr != m_freeList.end()) {
+      if (curr->offset == offset + length) {
+        length += curr->length;
+        curr = m_freeList.erase(curr);
+      } else if (curr->offset + curr->length == offset) {
+        offset -= curr->length;
+        length += curr->length;
+        curr = m_freeList.erase(curr);
+      } else {
+        curr++;
+      }
+    }
+    
+    m_freeList.push_back({ offset, length });
+  }
+  
+  DxvkTlsfStats getStats() const {
+    DxvkTlsfStats result;
+    
+    for (const auto& slice : m_freeList) {
+      result.freeSize        += slice.length;
+      result.freeBlockCount  += 1;
+      result.largestFreeBlock = std::max(result.largestFreeBlock, slice.length);
+    }
+    
+    result.usedSize       = m_size - result.freeSize;
+    result.usedBlockCount = m_lengths.size();
+    return result;
+  }
+  
+private:
+  
+  struct Slice {
+    VkDeviceSize offset;
+    VkDeviceSize length;
+  };
+  
+  VkDeviceSize       m_size;
+  std::vector<Slice> m_freeList;
+  
+  // The chunk itself does not need to look up allocation
+  // sizes since memory objects store them, but we do.
+  std::vector<Slice> m_lengths;
+  
+};
+
+
+struct BenchResult {
+  double        allocTime     = 0.0;
+  double        freeTime      = 0.0;
+  uint32_t      chunkCount    = 0;
+  uint32_t      emptyChunks   = 0;
+  double        fragmentation = 0.0;
+  DxvkTlsfStats stats;
+};
+
+
+/**
+ * \brief Simulates resource streaming on a heap
+ *
+ * Allocates memory from 16 MiB chunks in a first-fit manner
+ * like the memory heap does, creating new chunks as needed.
+ * The live set is first grown to the given size and then
+ * kept there while random allocations are freed and new ones
+ * created, with sizes between 256 bytes and 4 MiB and one in
+ * four allocations requiring image-like alignment. Afterwards,
+ * the live set is shrunk to a quarter of its size in order to
+ * see how many chunks could be released.
+ *
+ * Returns average times in nanoseconds per operation as well
+ * as the number of chunks and fragmentation stats at the end
+ * of the steady phase. Fragmentation is averaged over chunks.
+ */
+template<typename Allocator>
+BenchResult runStreaming(VkDeviceSize liveTarget, uint32_t operations) {
+  constexpr VkDeviceSize ChunkSize = 16 * 1024 * 1024;
+  
+  std::vector<std::unique_ptr<Allocator>> chunks;
+  BenchResult result;
+  
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> sizeDist(8.0, 22.0);
+  std::uniform_int_distribution<uint32_t> alignDist(0, 3);
+  
+  struct Allocation {
+    size_t       chunk;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+  };
+  
+  std::vector<Allocation> live;
+  VkDeviceSize liveSize = 0;
+  
+  Clock::duration allocTime = Clock::duration::zero();
+  Clock::duration freeTime  = Clock::duration::zero();
+  uint32_t allocCount = 0;
+  uint32_t freeCount  = 0;
+  
+  auto allocate = [&] () {
+    VkDeviceSize size  = VkDeviceSize(std::exp2(sizeDist(rng)));
+    VkDeviceSize align = alignDist(rng) == 0 ? 65536 : 256;
+    
+    auto t0 = Clock::now();
+    Allocation allocation = { 0, Allocator::InvalidOffset, size };
+    
+    while (allocation.offset == Allocator::InvalidOffset) {
+      if (allocation.chunk == chunks.size())
+        chunks.emplace_back(new Allocator(ChunkSize));
+      
+      allocation.offset = chunks[allocation.chunk]->alloc(size, align);
+      
+      if (allocation.offset == Allocator::InvalidOffset)
+        allocation.chunk += 1;
+    }
+    
+    auto t1 = Clock::now();
+    
+    allocTime  += t1 - t0;
+    allocCount += 1;
+    
+    live.push_back(allocation);
+    liveSize += size;
+  };
+  
+  auto release = [&] () {
+    size_t index = std::uniform_int_distribution<size_t>(0, live.size() - 1)(rng);
+    Allocation allocation = live[index];
+    live[index] = live.back();
+    live.pop_back();
+    liveSize -= allocation.size;
+    
+    auto t0 = Clock::now();
+    chunks[allocation.chunk]->free(allocation.offset);
+    auto t1 = Clock::now();
+    
+    freeTime  += t1 - t0;
+    freeCount += 1;
+  };
+  
+  while (liveSize < liveTarget)
+    allocate();
+  
+  for (uint32_t i = 0; i < operations; i++) {
+    if (liveSize < liveTarget)
+      allocate();
+    else
+      release();
+  }
+  
+  // Make sure that no two live allocations overlap
+  std::sort(live.begin(), live.end(),
+    [] (const Allocation& a, const Allocation& b) {
+      return a.chunk < b.chunk || (a.chunk == b.chunk && a.offset < b.offset);
+    });
+  
+  for (size_t i = 1; i < live.size(); i++) {
+    if (live[i - 1].chunk == live[i].chunk
+     && live[i - 1].offset + live[i - 1].size > live[i].offset)
+      Logger::err("Overlapping allocations");
+  }
+  
+  result.allocTime  = std::chrono::duration<double, std::nano>(allocTime).count() / std::max(allocCount, 1u);
+  result.freeTime   = std::chrono::duration<double, std::nano>(freeTime ).count() / std::max(freeCount,  1u);
+  result.chunkCount = chunks.size();
+  
+  for (const auto& chunk : chunks) {
+    DxvkTlsfStats stats = chunk->getStats();
+    result.stats.usedSize        += stats.usedSize;
+    result.stats.freeSize        += stats.freeSize;
+    result.stats.usedBlockCount  += stats.usedBlockCount;
+    result.stats.freeBlockCount  += stats.freeBlockCount;
+    result.stats.largestFreeBlock = std::max(result.stats.largestFreeBlock, stats.largestFreeBlock);
+    result.fragmentation += stats.fragmentation() / chunks.size();
+  }
+  
+  while (liveSize > liveTarget / 4)
+    release();
+  
+  for (const auto& chunk : chunks)
+    result.emptyChunks += chunk->getStats().usedBlockCount == 0 ? 1 : 0;
+  
+  return result;
+}
+
+
+void logResult(const char* name, const BenchResult& result) {
+  Logger::info(str::format(name, ": ",
+    result.allocTime, " ns/alloc, ",
+    result.freeTime,  " ns/free"));
+  Logger::info(str::format("  Chunks:        ",
+    result.chunkCount, " (", result.emptyChunks, " empty after shrinking)"));
+  Logger::info(str::format("  Used:          ",
+    result.stats.usedSize >> 10, " kB in ", result.stats.usedBlockCount, " blocks"));
+  Logger::info(str::format("  Free:          ",
+    result.stats.freeSize >> 10, " kB in ", result.stats.freeBlockCount, " blocks"));
+  Logger::info(str::format("  Largest free:  ",
+    result.stats.largestFreeBlock >> 10, " kB"));
+  Logger::info(str::format("  Fragmentation: ",
+    uint32_t(result.fragmentation * 100.0), "%"));
+}
+
+
+int main(int argc, char** argv) {
+  for (VkDeviceSize liveTarget : { 64ull << 20, 256ull << 20 }) {
+    for (uint32_t operations : { 10000u, 200000u }) {
+      Logger::info(str::format("Streaming, ", liveTarget >> 20, " MB live, ", operations, " operations"));
+      
+      logResult("Free list", runStreaming<FreeListAllocator>(liveTarget, operations));
+      logResult("TLSF",      runStreaming<DxvkTlsfAllocator>(liveTarget, operations));
+    }
+  }
+  
+  return 0;
+}
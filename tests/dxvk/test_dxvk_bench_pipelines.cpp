@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <dxvk_graphics.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-bench-pipelines.log");
+}
+
+using namespace dxvk;
+
+using Clock = std::chrono::high_resolution_clock;
+
+/**
+ * \brief Generates a synthetic state vector
+ * 
+ * Permutes blend, rasterizer and input layout
+ * state the way typical applications do.
+ */
+DxvkGraphicsPipelineStateInfo generateState(uint32_t id) {
+  DxvkGraphicsPipelineStateInfo state;
+  
+  state.iaPrimitiveTopology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+  state.ilAttributeCount    = 1 + (id % 4);
+  state.ilBindingCount      = 1;
+  
+  for (uint32_t i = 0; i < state.ilAttributeCount; i++) {
+    state.ilAttributes[i].location = i;
+    state.ilAttributes[i].format   = VK_FORMAT_R32G32B32A32_SFLOAT;
+    state.ilAttributes[i].offset   = 16 * i;
+  }
+  
+  state.ilBindings[0].stride    = 16 * state.ilAttributeCount;
+  
+  state.rsPolygonMode       = VK_POLYGON_MODE_FILL;
+  state.rsCullMode          = (id / 4) % 2 ? VK_CULL_MODE_BACK_BIT : VK_CULL_MODE_NONE;
+  state.rsDepthBiasEnable   = (id / 8) % 2;
+  state.rsViewportCount     = 1;
+  state.msSampleCount       = VK_SAMPLE_COUNT_1_BIT;
+  state.msSampleMask        = 0xFFFFFFFF;
+  state.dsEnableDepthTest   = VK_TRUE;
+  state.dsEnableDepthWrite  = (id / 16) % 2;
+  state.dsDepthCompareOp    = VK_COMPARE_OP_LESS_OR_EQUAL;
+  
+  for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
+    state.omBlendAttachments[i].blendEnable     = (id / 32) % 2;
+    state.omBlendAttachments[i].srcColorBlendFactor = VkBlendFactor((id / 64) % 8);
+    state.omBlendAttachments[i].colorWriteMask  = 0xF;
+  }
+  
+  return state;
+}
+
+
+template<typename Fn>
+double measure(uint32_t iterations, const Fn& fn) {
+  auto t0 = Clock::now();
+  
+  for (uint32_t i = 0; i < iterations; i++)
+    fn(i);
+  
+  auto t1 = Clock::now();
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / iterations;
+}
+
+
+int main(int argc, char** argv) {
+  const uint32_t iterations = 1000000;
+  
+  for (uint32_t stateCount : { 8u, 64u, 256u, 512u }) {
+    std::vector<DxvkGraphicsPipelineStateInfo> states;
+    
+    for (uint32_t i = 0; i < stateCount; i++)
+      states.push_back(generateState(i));
+    
+    // Access pattern: random state changes
+    std::mt19937 rng(stateCount);
+    std::vector<uint32_t> indices(4096);
+    
+    for (auto& index : indices)
+      index = rng() % stateCount;
+    
+    std::vector<std::pair<DxvkGraphicsPipelineStateInfo, VkPipeline>> list;
+    std::unordered_map<DxvkGraphicsPipelineStateInfo, VkPipeline, DxvkHash> map;
+    
+    for (uint32_t i = 0; i < stateCount; i++) {
+      VkPipeline handle = VkPipeline(uintptr_t(i + 1));
+      list.push_back({ states[i], handle });
+      map.insert({ states[i], handle });
+    }
+    
+    size_t sum = 0;
+    
+    double tList = measure(iterations, [&] (uint32_t i) {
+      const auto& state = states[indices[i % indices.size()]];
+      
+      for (const auto& pair : list) {
+        if (pair.first == state) {
+          sum += uintptr_t(pair.second);
+          break;
+        }
+      }
+    });
+    
+    double tMap = measure(iterations, [&] (uint32_t i) {
+      const auto& state = states[indices[i % indices.size()]];
+      sum += uintptr_t(map.find(state)->second);
+    });
+    
+    double tHash = measure(iterations, [&] (uint32_t i) {
+      sum += states[indices[i % indices.size()]].hash();
+    });
+    
+    Logger::info(str::format(stateCount, " states: linear ", tList,
+      " ns, hashed ", tMap, " ns, hash only ", tHash, " ns (", sum & 1, ")"));
+  }
+  
+  return 0;
+}
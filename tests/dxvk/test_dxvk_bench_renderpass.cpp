@@ -0,0 +1,218 @@
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <dxvk_renderpass.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-bench-renderpass.log");
+}
+
+using namespace dxvk;
+
+using Clock = std::chrono::high_resolution_clock;
+
+/**
+ * \brief Generates a render pass format
+ *
+ * Permutes render target count, formats, layouts
+ * and sample counts the way typical deferred and
+ * forward renderers do, with or without MSAA.
+ */
+DxvkRenderPassFormat generateFormat(uint32_t id) {
+  const std::array<VkFormat, 5> colorFormats = {{
+    VK_FORMAT_B8G8R8A8_UNORM,
+    VK_FORMAT_R8G8B8A8_SRGB,
+    VK_FORMAT_R16G16B16A16_SFLOAT,
+    VK_FORMAT_B10G11R11_UFLOAT_PACK32,
+    VK_FORMAT_R32_SFLOAT,
+  }};
+  
+  const std::array<VkFormat, 3> depthFormats = {{
+    VK_FORMAT_UNDEFINED,
+    VK_FORMAT_D24_UNORM_S8_UINT,
+    VK_FORMAT_D32_SFLOAT,
+  }};
+  
+  DxvkRenderPassFormat format;
+  
+  const uint32_t colorCount = 1 + id % 4;
+  id /= 4;
+  
+  for (uint32_t i = 0; i < colorCount; i++) {
+    DxvkRenderTargetFormat color;
+    color.format        = colorFormats[(id + i) % colorFormats.size()];
+    color.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    color.finalLayout   = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    color.renderLayout  = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    format.setColorFormat(i, color);
+  }
+  
+  id /= colorFormats.size();
+  
+  DxvkRenderTargetFormat depth;
+  depth.format = depthFormats[id % depthFormats.size()];
+  id /= depthFormats.size();
+  
+  if (depth.format != VK_FORMAT_UNDEFINED) {
+    // Depth buffers that are also bound as a
+    // shader resource use a read-only layout
+    const VkImageLayout layout = id % 2
+      ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+      : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    
+    depth.initialLayout = layout;
+    depth.finalLayout   = layout;
+    depth.renderLayout  = layout;
+    format.setDepthFormat(depth);
+  }
+  
+  id /= 2;
+  
+  format.setSampleCount(id % 2
+    ? VK_SAMPLE_COUNT_4_BIT
+    : VK_SAMPLE_COUNT_1_BIT);
+  return format;
+}
+
+
+/**
+ * \brief Previous render pass pool lookup
+ *
+ * Linear search over all formats while
+ * holding a lock, for comparison.
+ */
+class LinearLookup {
+  
+public:
+  
+  void insert(const DxvkRenderPassFormat& fmt) {
+    m_formats.push_back(fmt);
+  }
+  
+  bool find(const DxvkRenderPassFormat& fmt) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    for (const auto& f : m_formats) {
+      if (f.matchesFormat(fmt))
+        return true;
+    }
+    
+    return false;
+  }
+  
+private:
+  
+  std::mutex                        m_mutex;
+  std::vector<DxvkRenderPassFormat> m_formats;
+  
+};
+
+
+/**
+ * \brief Hashed lookup as used by the pool
+ */
+class HashedLookup {
+  
+public:
+  
+  void insert(const DxvkRenderPassFormat& fmt) {
+    m_table.insert(fmt, fmt.hash(), nullptr);
+  }
+  
+  bool find(const DxvkRenderPassFormat& fmt) {
+    return m_table.find(fmt, fmt.hash()) != nullptr;
+  }
+  
+private:
+  
+  DxvkRenderPassTable m_table;
+  
+};
+
+
+/**
+ * \brief Measures lookup time
+ *
+ * Runs the same number of random lookups on each
+ * thread and returns the average time per lookup
+ * in nanoseconds, as seen by a single thread.
+ */
+template<typename T>
+double measure(
+        T&                                  lookup,
+  const std::vector<DxvkRenderPassFormat>&  formats,
+        uint32_t                            threadCount) {
+  const uint32_t iterations = 1000000;
+  
+  std::vector<std::thread> threads;
+  std::vector<double>      times(threadCount);
+  
+  for (uint32_t t = 0; t < threadCount; t++) {
+    threads.emplace_back([&, t] {
+      // Access pattern: random render target changes
+      std::mt19937 rng(t);
+      std::vector<uint32_t> indices(4096);
+      
+      for (auto& index : indices)
+        index = rng() % formats.size();
+      
+      uint32_t hits = 0;
+      
+      auto t0 = Clock::now();
+      
+      for (uint32_t i = 0; i < iterations; i++)
+        hits += lookup.find(formats[indices[i % indices.size()]]);
+      
+      auto t1 = Clock::now();
+      
+      if (hits != iterations)
+        Logger::err("Lookup failed");
+      
+      times[t] = std::chrono::duration<double, std::nano>(t1 - t0).count() / iterations;
+    });
+  }
+  
+  double result = 0.0;
+  
+  for (uint32_t t = 0; t < threadCount; t++) {
+    threads[t].join();
+    result += times[t];
+  }
+  
+  return result / threadCount;
+}
+
+
+int main(int argc, char** argv) {
+  for (uint32_t formatCount : { 4u, 16u, 64u, 240u }) {
+    std::vector<DxvkRenderPassFormat> formats;
+    
+    LinearLookup linear;
+    HashedLookup hashed;
+    
+    // Formats without a depth attachment ignore
+    // the depth layout, so skip duplicates
+    for (uint32_t i = 0; i < formatCount; i++) {
+      DxvkRenderPassFormat format = generateFormat(i);
+      
+      if (!hashed.find(format)) {
+        formats.push_back(format);
+        linear.insert(format);
+        hashed.insert(format);
+      }
+    }
+    
+    for (uint32_t threadCount : { 1u, 4u }) {
+      const double tLinear = measure(linear, formats, threadCount);
+      const double tHashed = measure(hashed, formats, threadCount);
+      
+      Logger::info(str::format(formats.size(), " formats, ", threadCount,
+        " threads: linear ", tLinear, " ns, hashed ", tHashed, " ns"));
+    }
+  }
+  
+  return 0;
+}